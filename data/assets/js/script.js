@@ -376,84 +376,264 @@ function startSimulation() {
     }, 1000);
 }
 
-async function updateStatus() {
-    if (isLocalMode) return;
+// ========== LAST-KNOWN STATE (IndexedDB) ==========
+// The last answers of /api/status, /api/weather and /api/stats-history are kept in IndexedDB with the
+// time they were received. On page load they are rendered at once and revalidated in the background;
+// while the ESP32 is unreachable (OTA reboot, weak WiFi) the dashboard keeps showing them with their
+// age (staleness badge) instead of going blank. Requests to the same endpoint that overlap share one fetch.
+const LKS_DB_NAME = 'heizungssteuerung';
+const LKS_STORE = 'lastKnown';
+const LKS_STATUS_SAVE_INTERVAL = 30000;   // /ws/state deltas arrive every second, persist at most this often
+let lksDbPromise = null;
+let lksStatusSavedAt = 0;
+const inflightRequests = new Map();
+
+// Time the displayed status was received from the ESP32 and whether it is still current
+let statusReceivedAt = 0;
+let statusIsLive = false;
+
+function lksOpen() {
+    if (!lksDbPromise) {
+        lksDbPromise = new Promise((resolve) => {
+            if (!('indexedDB' in window)) {
+                resolve(null);
+                return;
+            }
+            const request = indexedDB.open(LKS_DB_NAME, 1);
+            request.onupgradeneeded = () => request.result.createObjectStore(LKS_STORE);
+            request.onsuccess = () => resolve(request.result);
+            request.onerror = () => resolve(null);   // e.g. private mode: work without persistence
+        });
+    }
+    return lksDbPromise;
+}
+
+async function lksGet(key) {
+    const db = await lksOpen();
+    if (!db) return null;
+    return new Promise((resolve) => {
+        const request = db.transaction(LKS_STORE, 'readonly').objectStore(LKS_STORE).get(key);
+        request.onsuccess = () => resolve(request.result || null);
+        request.onerror = () => resolve(null);
+    });
+}
 
+async function lksPut(key, data) {
+    const db = await lksOpen();
+    if (!db) return;
     try {
-        const response = await fetch('/api/status');
-        if (!response.ok) throw new Error('API failed');
+        db.transaction(LKS_STORE, 'readwrite').objectStore(LKS_STORE).put({ data, receivedAt: Date.now() }, key);
+    } catch (e) {
+        console.warn('IndexedDB write failed:', e);
+    }
+}
 
+// GET url as JSON; concurrent callers share the request. Successful answers are stored under key (if set).
+function fetchJsonShared(url, key) {
+    if (inflightRequests.has(url)) {
+        return inflightRequests.get(url);
+    }
+    const request = (async () => {
+        // 503 = ESP32 is still building a cache after boot (stats-history), retry shortly
+        let response = await fetch(url);
+        for (let attempt = 0; response.status === 503 && attempt < 5; attempt++) {
+            await new Promise(resolve => setTimeout(resolve, 1000));
+            response = await fetch(url);
+        }
+        if (!response.ok) throw new Error(`HTTP ${response.status}`);
         const data = await response.json();
+        if (key) lksPut(key, data);
+        return data;
+    })();
+    inflightRequests.set(url, request);
+    request.then(() => inflightRequests.delete(url), () => inflightRequests.delete(url));
+    return request;
+}
 
-        // Ensure schedules array always exists with MAX_SCHEDULES entries
-        const schedulesFromApi = Array.isArray(data.schedules) ? data.schedules : [];
-        const safeSchedules = [];
-        for (let i = 0; i < MAX_SCHEDULES; i++) {
-            const s = schedulesFromApi[i] || (currentState.schedules && currentState.schedules[i]) || {};
-            safeSchedules.push({
-                enabled: !!s.enabled,
-                start: (typeof s.start === 'string' && s.start) ? s.start : '00:00',
-                end: (typeof s.end === 'string' && s.end) ? s.end : '00:00'
-            });
-        }
+function formatAge(ms) {
+    const sec = Math.max(0, Math.round(ms / 1000));
+    if (sec < 60) return `${sec} s`;
+    if (sec < 3600) return `${Math.floor(sec / 60)} min`;
+    if (sec < 86400) return `${Math.floor(sec / 3600)} h`;
+    return `${Math.floor(sec / 86400)} d`;
+}
 
-        currentState = {
-            version: data.version || 'v0.0.0',
-            tempVorlauf: data.tempVorlauf,
-            tempRuecklauf: data.tempRuecklauf,
-            heating: data.heating,
-            pump: data.pump !== undefined ? data.pump : false,
-            pumpManualMode: data.pumpManualMode !== undefined ? data.pumpManualMode : false,
-            mode: data.mode,
-            tempOn: data.tempOn,
-            tempOff: data.tempOff,
-            rssi: data.rssi,
-            uptime: data.uptime,
-            currentTime: data.currentTime,
-            ntpSynced: data.ntpSynced,
-            schedules: safeSchedules,
-            tempDiff: data.tempDiff,
-            efficiency: data.efficiency || 0,
-            switchCount: data.switchCount || 0,
-            todaySwitches: data.todaySwitches || 0,
-            onTimeSeconds: data.onTimeSeconds || 0,
-            offTimeSeconds: data.offTimeSeconds || 0,
-            frostEnabled: data.frostEnabled || false,
-            frostTemp: data.frostTemp || 8,
-            tankAvailable: data.tankAvailable || false,
-            tankDistance: data.tankDistance,
-            tankLiters: data.tankLiters,
-            tankPercent: data.tankPercent,
-            tankHeight: data.tankHeight || 100,
-            tankCapacity: data.tankCapacity || 1000,
-            dieselConsumptionPerHour: data.dieselConsumptionPerHour !== undefined ? Math.round(data.dieselConsumptionPerHour * 10) / 10 : 2.0,
-            latitude: data.latitude || 50.952149,
-            longitude: data.longitude || 7.1229,
-            locationName: data.locationName || null,
-            heaterRelayActiveLow: (data.heaterRelayActiveLow !== undefined) ? data.heaterRelayActiveLow : true,
-            pumpRelayActiveLow: (data.pumpRelayActiveLow !== undefined) ? data.pumpRelayActiveLow : true,
-            heaterRelayOffMode: (data.heaterRelayOffMode !== undefined) ? data.heaterRelayOffMode : 0,
-            pumpRelayOffMode: (data.pumpRelayOffMode !== undefined) ? data.pumpRelayOffMode : 0
-        };
+function updateStaleBadge() {
+    const badge = document.getElementById('staleBadge');
+    if (!badge) return;
+    if (statusIsLive || !statusReceivedAt) {
+        badge.style.display = 'none';
+        return;
+    }
+    badge.textContent = `Stand vor ${formatAge(Date.now() - statusReceivedAt)}`;
+    badge.title = `Letzte Daten vom ESP32: ${new Date(statusReceivedAt).toLocaleString('de-DE')}`;
+    badge.style.display = '';
+}
 
-        // Update location name from status if available
-        if (data.locationName) {
-            document.getElementById('weatherLocation').textContent = data.locationName;
-            document.getElementById('currentLocationName').textContent = data.locationName;
-        }
+// Render the stored state before the first answer from the ESP32 arrives
+async function restoreLastKnownState() {
+    const [status, weather] = await Promise.all([lksGet('status'), lksGet('weather')]);
+    if (status && !statusReceivedAt) {
+        applyStatusData(status.data, status.receivedAt);
+    }
+    if (weather && !currentState.weather) {
+        applyWeatherData(weather.data);
+    }
+    const stats = await lksGet('statsHistory');
+    if (stats && !window.__lastStatsHistory) {
+        window.__lastStatsHistory = stats.data;
+        window.__lastStatsHistoryAt = stats.receivedAt;
+    }
+}
 
-        updateConnectionStatus(true);
-        // Weather update is now handled in main interval to avoid spam
+async function updateStatus() {
+    if (isLocalMode) return;
 
-        // Update UI after status is loaded (so location input field gets filled)
-        updateUI();
+    try {
+        const data = await fetchJsonShared('/api/status', null);   // Stored by applyStatusData()
+        applyStatusData(data);
     } catch (error) {
         console.error('Status fetch failed:', error);
+        statusIsLive = false;
         updateConnectionStatus(false);
+        updateStaleBadge();
         updateUI();
     }
 }
 
+// ========== LIVE STATUS PUSH (/ws/state) ==========
+// The ESP32 sends a full snapshot on connect and afterwards only changed fields.
+// While this socket is open, /api/status polling is paused (see main interval).
+let stateSocket = null;
+let stateSocketOpen = false;
+let stateSocketRetryDelay = 1000;
+let stateSeq = 0;
+let liveStatus = {};
+
+function connectStateSocket() {
+    if (isLocalMode || stateSocket) return;
+
+    const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
+    stateSocket = new WebSocket(`${protocol}//${window.location.host}/ws/state`);
+
+    stateSocket.onopen = () => {
+        stateSocketOpen = true;
+        stateSocketRetryDelay = 1000;
+    };
+
+    stateSocket.onmessage = (event) => {
+        let msg;
+        try {
+            msg = JSON.parse(event.data);
+        } catch (e) {
+            return;
+        }
+
+        if (msg.type === 'snapshot') {
+            liveStatus = Object.assign({}, msg.config || {}, msg.live || {});
+        } else {
+            if (msg.seq !== stateSeq + 1) {
+                // Missed a delta (dropped by the ESP32 for a slow client): ask for a full snapshot
+                stateSocket.send('snapshot');
+            }
+            Object.assign(liveStatus, msg.config || {}, msg.live || {});
+        }
+        stateSeq = msg.seq;
+        applyStatusData(liveStatus);
+    };
+
+    stateSocket.onclose = () => {
+        stateSocket = null;
+        stateSocketOpen = false;
+        // Polling takes over until the socket is back
+        setTimeout(connectStateSocket, stateSocketRetryDelay);
+        stateSocketRetryDelay = Math.min(stateSocketRetryDelay * 2, 30000);
+    };
+
+    stateSocket.onerror = () => {
+        // onclose follows and schedules the reconnect
+    };
+}
+
+// receivedAt: set when rendering a stored (last-known) state instead of a live answer
+function applyStatusData(data, receivedAt = 0) {
+    // Ensure schedules array always exists with MAX_SCHEDULES entries
+    const schedulesFromApi = Array.isArray(data.schedules) ? data.schedules : [];
+    const safeSchedules = [];
+    for (let i = 0; i < MAX_SCHEDULES; i++) {
+        const s = schedulesFromApi[i] || (currentState.schedules && currentState.schedules[i]) || {};
+        safeSchedules.push({
+            enabled: !!s.enabled,
+            start: (typeof s.start === 'string' && s.start) ? s.start : '00:00',
+            end: (typeof s.end === 'string' && s.end) ? s.end : '00:00'
+        });
+    }
+
+    currentState = {
+        version: data.version || 'v0.0.0',
+        tempVorlauf: data.tempVorlauf,
+        tempRuecklauf: data.tempRuecklauf,
+        heating: data.heating,
+        pump: data.pump !== undefined ? data.pump : false,
+        pumpManualMode: data.pumpManualMode !== undefined ? data.pumpManualMode : false,
+        mode: data.mode,
+        tempOn: data.tempOn,
+        tempOff: data.tempOff,
+        rssi: data.rssi,
+        uptime: data.uptime,
+        currentTime: data.currentTime,
+        ntpSynced: data.ntpSynced,
+        schedules: safeSchedules,
+        tempDiff: data.tempDiff,
+        efficiency: data.efficiency || 0,
+        switchCount: data.switchCount || 0,
+        todaySwitches: data.todaySwitches || 0,
+        onTimeSeconds: data.onTimeSeconds || 0,
+        offTimeSeconds: data.offTimeSeconds || 0,
+        frostEnabled: data.frostEnabled || false,
+        frostTemp: data.frostTemp || 8,
+        tankAvailable: data.tankAvailable || false,
+        tankDistance: data.tankDistance,
+        tankLiters: data.tankLiters,
+        tankPercent: data.tankPercent,
+        tankHeight: data.tankHeight || 100,
+        tankCapacity: data.tankCapacity || 1000,
+        dieselConsumptionPerHour: data.dieselConsumptionPerHour !== undefined ? Math.round(data.dieselConsumptionPerHour * 10) / 10 : 2.0,
+        latitude: data.latitude || 50.952149,
+        longitude: data.longitude || 7.1229,
+        locationName: data.locationName || null,
+        heaterRelayActiveLow: (data.heaterRelayActiveLow !== undefined) ? data.heaterRelayActiveLow : true,
+        pumpRelayActiveLow: (data.pumpRelayActiveLow !== undefined) ? data.pumpRelayActiveLow : true,
+        heaterRelayOffMode: (data.heaterRelayOffMode !== undefined) ? data.heaterRelayOffMode : 0,
+        pumpRelayOffMode: (data.pumpRelayOffMode !== undefined) ? data.pumpRelayOffMode : 0,
+        weather: currentState.weather   // Comes from /api/weather, not part of the status
+    };
+
+    // Update location name from status if available
+    if (data.locationName) {
+        document.getElementById('weatherLocation').textContent = data.locationName;
+        document.getElementById('currentLocationName').textContent = data.locationName;
+    }
+
+    if (receivedAt) {
+        statusIsLive = false;
+        statusReceivedAt = receivedAt;
+    } else {
+        statusIsLive = true;
+        statusReceivedAt = Date.now();
+        updateConnectionStatus(true);
+        if (statusReceivedAt - lksStatusSavedAt >= LKS_STATUS_SAVE_INTERVAL) {
+            lksStatusSavedAt = statusReceivedAt;
+            lksPut('status', data);
+        }
+    }
+    updateStaleBadge();
+    // Weather update is now handled in main interval to avoid spam
+
+    // Update UI after status is loaded (so location input field gets filled)
+    updateUI();
+}
+
 async function updateWeather() {
     if (isLocalMode) {
         // Use demo weather data
@@ -461,54 +641,58 @@ async function updateWeather() {
     }
 
     try {
-        const response = await fetch('/api/weather');
-        if (!response.ok) throw new Error('Weather API failed');
-
-        const data = await response.json();
-
-        // Update weather state even if not valid (to keep locationName)
-        if (!currentState.weather) {
-            currentState.weather = {};
+        const data = await fetchJsonShared('/api/weather', 'weather');
+        return applyWeatherData(data);
+    } catch (error) {
+        console.error('Weather fetch failed:', error);
+        // Keep showing the last known weather if there is one
+        if (!currentState.weather || !currentState.weather.valid) {
+            displayWeatherError();
         }
-        currentState.weather = { ...currentState.weather, ...data };
+        return false;
+    }
+}
 
-        // Update location name immediately if available (even if weather data is invalid)
-        // Ignore "Unbekannter Ort" as it's just a placeholder
-        if (data.locationName && data.locationName !== "Unbekannter Ort") {
-            document.getElementById('weatherLocation').textContent = data.locationName;
-            document.getElementById('currentLocationName').textContent = data.locationName;
-        }
+// Returns true if the weather data is valid
+function applyWeatherData(data) {
+    // Update weather state even if not valid (to keep locationName)
+    if (!currentState.weather) {
+        currentState.weather = {};
+    }
+    currentState.weather = { ...currentState.weather, ...data };
 
-        if (data.valid) {
-            displayWeather();
-            // Also update header if weather card is collapsed
-            const weatherCard = document.getElementById('weatherCard');
-            if (weatherCard) {
-                const weatherContent = weatherCard.querySelector('.card-content');
-                if (weatherContent && weatherContent.classList.contains('collapsed')) {
-                    updateWeatherCardHeader(true);
-                }
-            }
-            return true; // Return true if weather data is valid
-        } else {
-            // Check if we should show error or loading message
-            const locationInput = document.getElementById('locationInput');
-            const hasLocationInput = locationInput && locationInput.value.trim() !== '';
-            const hasLocationName = (data.locationName && data.locationName !== "Unbekannter Ort");
+    // Update location name immediately if available (even if weather data is invalid)
+    // Ignore "Unbekannter Ort" as it's just a placeholder
+    if (data.locationName && data.locationName !== "Unbekannter Ort") {
+        document.getElementById('weatherLocation').textContent = data.locationName;
+        document.getElementById('currentLocationName').textContent = data.locationName;
+    }
 
-            // Only show error if location is actually set, otherwise show loading
-            if (hasLocationInput || hasLocationName) {
-                // Location is set, show loading message (weather will be fetched soon)
-                displayWeatherError();
+    if (data.valid) {
+        displayWeather();
+        // Also update header if weather card is collapsed
+        const weatherCard = document.getElementById('weatherCard');
+        if (weatherCard) {
+            const weatherContent = weatherCard.querySelector('.card-content');
+            if (weatherContent && weatherContent.classList.contains('collapsed')) {
+                updateWeatherCardHeader(true);
             }
-            // If no location is set, don't show anything (will be handled by initial state)
-            return false; // Return false if weather data is not valid
         }
-    } catch (error) {
-        console.error('Weather fetch failed:', error);
+        return true;
+    }
+
+    // Check if we should show error or loading message
+    const locationInput = document.getElementById('locationInput');
+    const hasLocationInput = locationInput && locationInput.value.trim() !== '';
+    const hasLocationName = (data.locationName && data.locationName !== "Unbekannter Ort");
+
+    // Only show error if location is actually set, otherwise show loading
+    if (hasLocationInput || hasLocationName) {
+        // Location is set, show loading message (weather will be fetched soon)
         displayWeatherError();
-        return false;
     }
+    // If no location is set, don't show anything (will be handled by initial state)
+    return false;
 }
 
 function displayWeather() {
@@ -1739,6 +1923,8 @@ function resetDemo() {
 
 // ========== SERIAL MONITOR (WebSocket) ==========
 let ws = null;
+let logSession = null;  // Log session of the ESP32 (changes on reboot)
+let lastLogSeq = 0;     // Sequence number of the last log line shown
 let wsReconnectTimer = null;
 let waitingForReboot = false; // Flag to indicate we're waiting for ESP32 to reboot after OTA
 let rebootCheckInterval = null; // Interval for checking WebSocket reconnection after reboot
@@ -1749,6 +1935,21 @@ let isConnecting = false; // Prevent multiple simultaneous connection attempts
 const MAX_RECONNECT_DELAY = 30000; // Maximum delay: 30 seconds
 const BASE_RECONNECT_DELAY = 2000; // Base delay: 2 seconds
 
+// Log channel shown in the serial monitor ("all" or e.g. "mysql"), filtered on the ESP32
+function getSerialChannel() {
+    const select = document.getElementById('serialChannel');
+    return select ? select.value : 'all';
+}
+
+function changeSerialChannel() {
+    const channel = getSerialChannel();
+    localStorage.setItem('ui:serialChannel', channel);
+    if (ws && ws.readyState === WebSocket.OPEN) {
+        ws.send(`channels:${channel}`);
+    }
+    appendSerialLog(`// Kanal: ${channel === 'all' ? 'alle' : channel}\n`, '#608b4e');
+}
+
 function connectWebSocket() {
     if (isLocalMode) return;
 
@@ -1779,7 +1980,18 @@ function connectWebSocket() {
     }
 
     const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
-    const wsUrl = `${protocol}//${window.location.host}/ws`;
+    // Resume after the last line we have, so the ESP32 only sends what we missed
+    const params = new URLSearchParams();
+    if (logSession) {
+        params.set('session', logSession);
+        params.set('since', lastLogSeq);
+    }
+    const channel = getSerialChannel();
+    if (channel !== 'all') {
+        params.set('channels', channel);
+    }
+    const query = params.toString();
+    const wsUrl = `${protocol}//${window.location.host}/ws${query ? '?' + query : ''}`;
 
     isConnecting = true;
     ws = new WebSocket(wsUrl);
@@ -1867,12 +2079,33 @@ function connectWebSocket() {
     };
 
     ws.onmessage = (event) => {
-        // Handle both single-line and multi-line messages
-        const data = event.data;
-        // Split by newlines and add each line separately
-        const lines = data.split('\n');
-        lines.forEach((line) => {
-            // Skip empty lines only if they're the last line and data ends with \n
+        // Each message: header "@@<session>:<seq of next line>[!<lost>]", then one log line per row.
+        // Further header lines follow where lines of unsubscribed channels were skipped.
+        const lines = event.data.split('\n');
+        let seq = 0;
+        let sequenced = false;
+        lines.forEach((line, i) => {
+            // Last element is empty because every line ends with \n
+            if (line.length === 0 && i === lines.length - 1) return;
+            const header = /^@@([0-9a-f]+):(\d+)(?:!(\d+))?$/.exec(line);
+            if (header) {
+                if (header[1] !== logSession) {
+                    // ESP32 rebooted (or first connect): sequence numbers start over
+                    logSession = header[1];
+                    lastLogSeq = 0;
+                }
+                seq = parseInt(header[2], 10);
+                sequenced = true;
+                if (header[3]) {
+                    appendSerialLog(`// ${header[3]} Zeilen verpasst (Log-Puffer überschrieben)\n`, '#e67e22');
+                }
+                return;
+            }
+            if (sequenced) {
+                const lineSeq = seq++;
+                if (lineSeq <= lastLogSeq) return; // Already shown (resume overlap)
+                lastLogSeq = lineSeq;
+            }
             if (line.length > 0) {
                 appendSerialLog(line);
             }
@@ -2012,45 +2245,44 @@ async function refreshStatsModal() {
         return;
     }
     
-    // Show loading indicator
     const loadingEl = document.getElementById('statsModalLoading');
     const daysListEl = document.getElementById('statsModalDaysList');
     const eventsEl = document.getElementById('statsModalSwitchEvents');
-    
-    if (loadingEl) loadingEl.style.display = 'block';
-    if (daysListEl) daysListEl.style.display = 'none';
-    if (eventsEl) eventsEl.style.display = 'none';
-    
+    const showContent = (visible) => {
+        if (loadingEl) loadingEl.style.display = visible ? 'none' : 'block';
+        if (daysListEl) daysListEl.style.display = visible ? 'block' : 'none';
+        if (eventsEl) eventsEl.style.display = visible ? 'block' : 'none';
+    };
+
+    // Last known data right away (marked with its age), fresh data replaces it when it arrives
+    if (window.__lastStatsHistory) {
+        showContent(true);
+        renderStatsModal(window.__lastStatsHistory);
+        updateStatsStaleBadge(window.__lastStatsHistoryAt, true);
+    } else {
+        showContent(false);
+    }
+
     try {
-        const res = await fetch('/api/stats-history');
-        if (!res.ok) throw new Error(`HTTP ${res.status}`);
-        const data = await res.json();
+        const data = await fetchJsonShared('/api/stats-history', 'statsHistory');
         window.__lastStatsHistory = data;
-        
-        // Hide loading, show content
-        if (loadingEl) loadingEl.style.display = 'none';
-        if (daysListEl) daysListEl.style.display = 'block';
-        if (eventsEl) eventsEl.style.display = 'block';
-        
+        window.__lastStatsHistoryAt = Date.now();
+
+        showContent(true);
         renderStatsModal(data);
-        
+        updateStatsStaleBadge(0, false);
+
         // Show warning toast if MySQL is not available
         if (data.mysqlAvailable === false) {
             showToast('⚠️ MySQL-Verbindung nicht verfügbar. Zeige lokale Daten.', 'warning', 4000);
         }
     } catch (e) {
         console.error('stats-history failed:', e);
-        
-        // Hide loading on error
-        if (loadingEl) loadingEl.style.display = 'none';
-        if (daysListEl) daysListEl.style.display = 'block';
-        if (eventsEl) eventsEl.style.display = 'block';
-        
+        showContent(true);
         showToast('Fehler beim Laden der Statistik-History', 'error');
-        
-        // Try to render with cached data if available
+
         if (window.__lastStatsHistory) {
-            renderStatsModal(window.__lastStatsHistory);
+            updateStatsStaleBadge(window.__lastStatsHistoryAt, false);
         } else {
             // Show MySQL warning even on error if we have no cached data
             const mysqlWarningEl = document.getElementById('statsModalMySQLWarning');
@@ -2061,6 +2293,18 @@ async function refreshStatsModal() {
     }
 }
 
+// receivedAt = 0 hides the badge (data is current)
+function updateStatsStaleBadge(receivedAt, refreshing) {
+    const badge = document.getElementById('statsModalStale');
+    if (!badge) return;
+    if (!receivedAt) {
+        badge.style.display = 'none';
+        return;
+    }
+    badge.textContent = `Stand vor ${formatAge(Date.now() - receivedAt)}` + (refreshing ? ' – wird aktualisiert…' : ' – ESP32 nicht erreichbar');
+    badge.style.display = '';
+}
+
 function renderStatsModal(data) {
     const summaryEl = document.getElementById('statsModalSummary');
     if (!summaryEl) return;
@@ -3505,6 +3749,13 @@ async function uploadFrontend(event) {
 
 // ========== SERVICE WORKER REGISTRATION ==========
 if ('serviceWorker' in navigator && !isLocalMode) {
+    // A controller change after the first install means a new frontend build was cached completely
+    const hadController = !!navigator.serviceWorker.controller;
+    navigator.serviceWorker.addEventListener('controllerchange', () => {
+        if (hadController) {
+            showToast('Neue Oberflächen-Version geladen – Seite neu laden, um sie zu verwenden', 'info', 8000);
+        }
+    });
     navigator.serviceWorker.register('/sw.js').then((registration) => {
         console.log('Service Worker registered:', registration.scope);
     }).catch((error) => {
@@ -3548,9 +3799,11 @@ initCollapsibleCards();
 setInterval(() => {
     if (!isLocalMode) {
         // During OTA reboot we expect the backend to be unreachable. Don't spam console with failed requests.
-        if (!waitingForReboot) {
+        // Live updates arrive via /ws/state; polling is only the fallback while that socket is down.
+        if (!waitingForReboot && !stateSocketOpen) {
             updateStatus();
         }
+        updateStaleBadge();
 
         // Weather is only updated on page load and F5 refresh, not in loop
     }
@@ -3573,11 +3826,9 @@ document.addEventListener('keydown', function (e) {
 detectMode();
 updateConnectionStatus(true);
 if (!isLocalMode) {
+    restoreLastKnownState();
     // Update status first (which will call updateUI after loading data)
     updateStatus().then(() => {
-        // Update weather once on page load - if it's already cached, it will display right away
-        updateWeather();
-
         // Also try a few times in case backend is still fetching
         let retryCount = 0;
         const maxRetries = 5;
@@ -3602,10 +3853,15 @@ if (!isLocalMode) {
                 lastWeatherUpdate = Date.now();
             }
         };
-        // Start retry checks after 2 seconds
-        setTimeout(checkWeather, 2000);
+        // Weather once on page load; retries (every 2 s) only while the backend has no valid data yet
+        checkWeather();
     });
+    const serialChannel = document.getElementById('serialChannel');
+    if (serialChannel) {
+        serialChannel.value = localStorage.getItem('ui:serialChannel') || 'all';
+    }
     connectWebSocket();
+    connectStateSocket();
 } else {
     // In local mode, update UI immediately
     updateUI();
@@ -1,31 +1,78 @@
 // Service Worker für ESP32 Heizungssteuerung
-const CACHE_NAME = 'heizungssteuerung-v1';
-const urlsToCache = [
+// The filesystem build (scripts/build_fs.py) replaces ASSET_VERSION with the version of
+// /asset-manifest.json. Each version gets its own cache, filled completely during install; only
+// then does the new worker take over and delete the old caches, so the UI never mixes files of
+// two builds. The UI itself is always served from the cache, only /api/ goes to the device.
+const ASSET_VERSION = '__ASSET_VERSION__';
+const CACHE_PREFIX = 'heizungssteuerung-';
+const CACHE_NAME = CACHE_PREFIX + ASSET_VERSION;
+// Unprocessed data/ (no manifest): plain URLs
+const FALLBACK_URLS = [
   '/',
-  '/index.html',
-  '/manifest.json'
+  '/manifest.json',
+  '/assets/css/style.css',
+  '/assets/js/script.js'
 ];
 
+async function precacheUrls() {
+  try {
+    const response = await fetch('/asset-manifest.json?v=' + ASSET_VERSION, { cache: 'no-store' });
+    if (response.ok) {
+      const manifest = await response.json();
+      if (manifest.version === ASSET_VERSION) {
+        return manifest.assets.map((asset) => asset.url);
+      }
+    }
+  } catch (error) {
+    // No manifest (development image): fall through
+  }
+  return FALLBACK_URLS;
+}
+
 self.addEventListener('install', (event) => {
   event.waitUntil(
-    caches.open(CACHE_NAME)
-      .then((cache) => cache.addAll(urlsToCache))
+    precacheUrls()
+      .then((urls) => caches.open(CACHE_NAME)
+        .then((cache) => cache.addAll(urls.map((url) => new Request(url, { cache: 'reload' })))))
+      .then(() => self.skipWaiting())
+  );
+});
+
+self.addEventListener('activate', (event) => {
+  event.waitUntil(
+    caches.keys()
+      .then((keys) => Promise.all(keys
+        .filter((key) => key.startsWith(CACHE_PREFIX) && key !== CACHE_NAME)
+        .map((key) => caches.delete(key))))
+      .then(() => self.clients.claim())
   );
 });
 
 self.addEventListener('fetch', (event) => {
-  // Network-first strategy for API calls
-  if (event.request.url.includes('/api/')) {
+  const url = new URL(event.request.url);
+  if (event.request.method !== 'GET' || url.origin !== self.location.origin) {
+    return;
+  }
+
+  // API calls go straight to the device; the page keeps the last answers in IndexedDB
+  if (url.pathname.startsWith('/api/')) {
+    return;
+  }
+
+  // The dashboard page (also with query parameters) always comes from the cache of this version
+  if (url.pathname === '/' || url.pathname === '/index.html') {
     event.respondWith(
-      fetch(event.request)
-        .catch(() => caches.match(event.request))
+      caches.open(CACHE_NAME)
+        .then((cache) => cache.match('/'))
+        .then((response) => response || fetch(event.request))
     );
     return;
   }
-  
+
   // Cache-first strategy for static assets
   event.respondWith(
-    caches.match(event.request)
+    caches.open(CACHE_NAME)
+      .then((cache) => cache.match(event.request))
       .then((response) => response || fetch(event.request))
   );
 });
@@ -39,9 +86,8 @@ self.addEventListener('push', (event) => {
     badge: data.badge || '/icon-192.png',
     tag: 'heating-notification'
   };
-  
+
   event.waitUntil(
     self.registration.showNotification(title, options)
   );
 });
-
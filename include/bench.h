@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "switch_events.h"
+
+// ========== MICROBENCHMARKS ==========
+// Runner shared by the host ("program bench", env:native) and the firmware (/api/bench, built with
+// -DBENCH_ENABLED in env:esp32dev_bench). A case runs `iterations` calls split into BENCH_BATCHES
+// timed batches after one warm-up call; all numbers are per call. Results are printed as one JSON
+// object per line so runs can be diffed by CI:
+//   {"bench":"switch_aggregate_7d","platform":"native","iterations":2000,"usMean":1.9,...}
+#define BENCH_BATCHES 8
+
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    double usMean;       // All batches
+    double usMin;        // Fastest batch
+    double usMax;        // Slowest batch
+    double cyclesMean;   // 0 if the platform has no cycle counter
+};
+
+typedef void (*BenchFn)(void* ctx);
+
+BenchResult benchRun(const char* name, uint32_t iterations, BenchFn fn, void* ctx);
+size_t benchFormat(const BenchResult& r, const char* platform, char* buf, size_t size);
+
+// ========== PORTABLE CASES ==========
+// Aggregate switchEvents[] over 7 daily windows ending at `now`
+struct BenchAggregateCtx {
+    uint32_t bounds[8];
+    SwitchWindowStats windows[7];
+    time_t now;
+    uint32_t nowMs;
+};
+void benchAggregateInit(BenchAggregateCtx& ctx, time_t now, uint32_t nowMs);
+void benchCaseAggregate(void* ctx);
+
+void benchCaseUnusualBehavior(void* ctx);   // checkUnusualBehavior() on the current switch history
+
+// Persistence of one 36-byte record (size of a switch journal record)
+struct BenchPersistCtx {
+    const char* path;        // File for fsAppend (removed by the caller afterwards)
+    const char* nvsNamespace;
+    uint8_t record[36];
+    uint32_t counter;
+};
+void benchCaseFsAppend(void* ctx);
+void benchCaseNvsPut(void* ctx);
+
+// Fill switchEvents[] with `count` alternating events, one every `spacingS` seconds up to `now`
+void benchFillSwitchEvents(int count, time_t now, uint32_t spacingS);
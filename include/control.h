@@ -0,0 +1,64 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// ========== CONTROL LOGIC ==========
+// Relay decisions (hysteresis, frost protection, pump cooldown, failsafe, switch-rate warning)
+// shared by the firmware and the host build (env:native). Only hal.h is used for time and logging;
+// the actuators and notifications below are implemented by main.cpp on the ESP32 and by the host
+// program on Linux.
+
+#define PUMP_COOLDOWN_MS 180000       // Pump stays ON for 180 seconds after heating turns OFF (3 minutes)
+#define MAX_SWITCH_HISTORY 20
+#define WARNING_THRESHOLD_SWITCHES 10  // Warn if more than 10 switches
+#define WARNING_TIME_WINDOW_MS (15 * 60 * 1000)  // in last 15 minutes
+
+enum ControlMode : uint8_t {
+    CONTROL_MANUAL,
+    CONTROL_AUTO,
+    CONTROL_SCHEDULE,
+    CONTROL_FROST
+};
+
+// "manual", "auto", "schedule", "frost" (unknown names map to manual)
+ControlMode controlModeFromName(const char* name);
+
+// State read and written by the control functions. The firmware's SystemState derives from it.
+struct ControlState {
+    bool heatingOn = false;
+    bool pumpOn = false;          // Pump state (circulation pump)
+    bool pumpManualMode = false;  // Manual pump override (only in manual mode)
+    float tempVorlauf = NAN;      // Forward flow temperature
+    float tempRuecklauf = NAN;    // Return flow temperature
+    ControlMode controlMode = CONTROL_MANUAL;  // Parsed from SystemState::mode
+    float tempOn = 30.0;          // Turn ON temperature (hysteresis min)
+    float tempOff = 40.0;         // Turn OFF temperature (hysteresis max)
+
+    // Frost protection
+    bool frostProtectionEnabled = false;
+    float frostProtectionTemp = 8.0;  // Minimum temperature
+
+    uint32_t lastHeatingOffTime = 0;  // hal::millis() when heating was turned OFF (for pump cooldown)
+    bool sensorErrorNotified = false; // Sensor failure already reported
+
+    // Behavior warning (too many switches in WARNING_TIME_WINDOW_MS)
+    uint32_t switchTimestamps[MAX_SWITCH_HISTORY] = {};
+    uint8_t switchHistoryIndex = 0;
+    bool behaviorWarningActive = false;
+    uint32_t lastBehaviorWarningTime = 0;
+};
+
+extern ControlState& controlState;
+
+// Provided by the platform
+void setHeater(bool on, bool saveToNVS = true);
+void setPump(bool on, bool manualOverride = false);
+void controlNotify(const char* message);  // Telegram message (if configured)
+
+void frostProtection();
+void automaticControl();
+void handlePumpCooldown();
+void checkFailsafe();
+void controlRecordSwitch();   // Call on every heater state change
+void checkUnusualBehavior();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ========== HARDWARE ABSTRACTION LAYER ==========
+// Thin interface between portable code (control.cpp, switch_events.cpp, bench.cpp) and the board.
+// It only has what that code calls, so host tests never cover a path the firmware doesn't run:
+// sensors, HTTP and the rest of the storage stay in main.cpp. The ESP32 implementation
+// (src/hal_esp32.cpp) forwards to the Arduino core, Preferences and the data partition. The host
+// build (env:native, src/native/hal_native.cpp) provides Linux fakes with a virtual clock, so the
+// same code runs deterministically on x86.
+namespace hal {
+
+// Clock
+uint32_t millis();
+void delay(uint32_t ms);
+// Real elapsed time and CPU cycle counter for benchmarks (host: wall clock and TSC, not the virtual clock)
+uint64_t monotonicUs();
+uint32_t cycleCount();
+
+// NVS blob write (microbenchmark of the old switch event storage)
+bool nvsPut(const char* ns, const char* key, const void* data, size_t len);
+
+// Filesystem (device: the LittleFS data partition that holds the switch journal)
+bool fsAppend(const char* path, const void* data, size_t len);
+bool fsRemove(const char* path);
+
+// Log line (device: Serial + WebSocket log ring, channel from the line's tag). log() is an info line;
+// logWarn()/logError() still pass when the channel is set to "warn" or "error".
+void log(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void logWarn(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void logError(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#ifndef ARDUINO
+// Host-only controls for the fakes
+namespace fake {
+void setMillis(uint32_t ms);
+void advance(uint32_t ms);
+void setLogEcho(bool echo);                  // Print hal::log() lines to stdout
+}  // namespace fake
+#endif
+
+}  // namespace hal
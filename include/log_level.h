@@ -0,0 +1,13 @@
+#pragma once
+
+// ========== LOG LEVELS ==========
+// Shared by main.cpp (LOG_*() macros, per-channel levels in /api/log-config) and hal_esp32.cpp
+// (hal::log/logWarn/logError), so both filter with the same numbers.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
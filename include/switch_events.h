@@ -0,0 +1,65 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+// ========== SWITCH EVENT HISTORY ==========
+#define MAX_SWITCH_EVENTS 50  // Store last 50 switch events
+struct SwitchEvent {
+    unsigned long timestamp = 0;  // Unix timestamp (or 0 if NTP not synced)
+    bool isOn = false;            // true = ON, false = OFF
+    float tempVorlauf = NAN;      // Temperature when switched
+    float tempRuecklauf = NAN;
+    unsigned long uptimeMs = 0;   // Uptime in milliseconds (fallback if no NTP)
+    float tankLiters = NAN;       // Tank level in liters when switched (for consumption comparison)
+};
+extern SwitchEvent switchEvents[MAX_SWITCH_EVENTS];
+extern int switchEventIndex;      // Ring buffer index (next slot to write)
+
+// ========== SWITCH EVENT QUERIES ==========
+// switchEvents[] is written in time order, so the ring itself is the index: walking it from
+// switchEventIndex forward yields the events oldest first without copying or sorting. The
+// aggregation turns consecutive events into ON/OFF intervals and clips them against any set of
+// [from, to) windows in a single O(events + windows) pass. On the ESP32, callers outside the
+// control task hold ControlLock while iterating.
+
+// Chronological iteration over used ring slots (oldest first)
+struct SwitchEventCursor {
+    int pos;
+    int remaining;
+
+    // newest: only visit the newest N used slots
+    explicit SwitchEventCursor(int newest = MAX_SWITCH_EVENTS);
+
+    static bool switchEventUsed(const SwitchEvent& evt) {
+        return evt.timestamp != 0 || evt.uptimeMs != 0;  // Never-written slots are all zero
+    }
+
+    const SwitchEvent* next();
+};
+
+// Unix time of an event. Events of this boot recorded before NTP sync are placed via their uptime;
+// returns 0 if the event cannot be placed. now = 0 means the clock is not synchronized.
+unsigned long switchEventTime(const SwitchEvent& evt, time_t now, uint32_t nowMs);
+
+struct SwitchWindowStats {
+    uint32_t from;
+    uint32_t to;
+    uint16_t switches;           // Events inside the window
+    uint16_t onCycles;           // ON events inside the window
+    uint32_t onSeconds;
+    uint32_t offSeconds;
+    uint32_t unknownSeconds;     // Before the oldest stored event or in the future
+    uint16_t vorlaufSamples;     // Flow temperature at OFF events (cycle peak)
+    float vorlaufSum;
+    float vorlaufMax;
+    float tankFirst;             // First/last tank reading at events inside the window
+    float tankLast;
+};
+
+// Aggregate ON/OFF intervals over windows [bounds[i], bounds[i + 1]), i < windowCount. bounds must be
+// ascending. The state between two events is the state of the earlier one; after the newest event it
+// lasts until now (0 = clock not synchronized). Returns the number of events that could be placed.
+int switchEventsAggregate(const uint32_t* bounds, int windowCount, SwitchWindowStats* out,
+                          time_t now, uint32_t nowMs);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========== TANK BURST FILTER ==========
+// Each tank reading is a burst of TANK_BURST_SAMPLES spaced pings. Missed echoes are stored as NAN.
+// When the burst is complete the samples are sorted by a fixed compare-exchange network and reduced
+// to a trimmed mean, together with a confidence value (valid ratio x spread). Portable, so the host
+// build (env:native) tests the same kernel the firmware runs.
+#define TANK_BURST_SAMPLES 5          // Pings per tank reading (filtered by median/trimmed mean)
+#define TANK_BURST_MIN_VALID 3        // Minimum valid echoes for a burst to count as a reading
+#define TANK_SPREAD_FULL_SCALE_CM 5.0f  // Inner spread at which confidence drops to 0
+
+// Diagnostics of the last burst (/api/tank-debug)
+struct TankBurstDiag {
+    uint8_t valid = 0;
+    float medianCm = -1.0f;
+    float spreadCm = -1.0f;
+};
+
+// Reduce TANK_BURST_SAMPLES samples to one distance in cm; -1.0 (confidence 0) if fewer than
+// TANK_BURST_MIN_VALID echoes. confidence is 0..100.
+float filterTankBurst(const float* samples, int& confidence, TankBurstDiag& diag);
@@ -140,6 +140,8 @@ try {
         $max_vorlauf = isset($input['max_vorlauf']) && $input['max_vorlauf'] !== null ? (float)$input['max_vorlauf'] : null;
         $min_ruecklauf = isset($input['min_ruecklauf']) && $input['min_ruecklauf'] !== null ? (float)$input['min_ruecklauf'] : null;
         $max_ruecklauf = isset($input['max_ruecklauf']) && $input['max_ruecklauf'] !== null ? (float)$input['max_ruecklauf'] : null;
+        $stddev_vorlauf = isset($input['stddev_vorlauf']) && $input['stddev_vorlauf'] !== null ? (float)$input['stddev_vorlauf'] : null;
+        $stddev_ruecklauf = isset($input['stddev_ruecklauf']) && $input['stddev_ruecklauf'] !== null ? (float)$input['stddev_ruecklauf'] : null;
         $diesel_liters = isset($input['diesel_liters']) ? (float)$input['diesel_liters'] : 0.0;
         $samples = isset($input['samples']) ? (int)$input['samples'] : 0;
         
@@ -147,8 +149,9 @@ try {
             INSERT INTO daily_stats (
                 date_key, switches, on_seconds, off_seconds,
                 avg_vorlauf, avg_ruecklauf, min_vorlauf, max_vorlauf,
-                min_ruecklauf, max_ruecklauf, diesel_liters, samples
-            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+                min_ruecklauf, max_ruecklauf, stddev_vorlauf, stddev_ruecklauf,
+                diesel_liters, samples
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
             ON DUPLICATE KEY UPDATE
                 switches = VALUES(switches),
                 on_seconds = VALUES(on_seconds),
@@ -159,15 +162,18 @@ try {
                 max_vorlauf = VALUES(max_vorlauf),
                 min_ruecklauf = VALUES(min_ruecklauf),
                 max_ruecklauf = VALUES(max_ruecklauf),
+                stddev_vorlauf = VALUES(stddev_vorlauf),
+                stddev_ruecklauf = VALUES(stddev_ruecklauf),
                 diesel_liters = VALUES(diesel_liters),
                 samples = VALUES(samples)
         ");
         
         $stmt->bind_param(
-            'siiidddddddi',
+            'siiidddddddddi',
             $date_key, $switches, $on_seconds, $off_seconds,
             $avg_vorlauf, $avg_ruecklauf, $min_vorlauf, $max_vorlauf,
-            $min_ruecklauf, $max_ruecklauf, $diesel_liters, $samples
+            $min_ruecklauf, $max_ruecklauf, $stddev_vorlauf, $stddev_ruecklauf,
+            $diesel_liters, $samples
         );
         
         if ($stmt->execute()) {
@@ -178,6 +184,61 @@ try {
         }
         $stmt->close();
     }
+    // POST /api/mysql/events/batch - Speichere mehrere Switch-Events (ein INSERT, eine Transaktion)
+    // Body: {"events": [{"timestamp": "...", "is_on": 1, "temp_vorlauf": 45.2, ...}, ...]}
+    elseif ($method === 'POST' && strpos($path, '/events/batch') !== false) {
+        $input = json_decode(file_get_contents('php://input'), true);
+        $max_batch = 100;
+        
+        if (!$input || !isset($input['events']) || !is_array($input['events']) || count($input['events']) === 0) {
+            http_response_code(400);
+            echo json_encode(['error' => 'Missing events']);
+            exit;
+        }
+        if (count($input['events']) > $max_batch) {
+            http_response_code(413);
+            echo json_encode(['error' => 'Too many events (max ' . $max_batch . ')']);
+            exit;
+        }
+        
+        $placeholders = [];
+        $types = '';
+        $values = [];
+        foreach ($input['events'] as $i => $event) {
+            if (!is_array($event) || !isset($event['timestamp']) || !isset($event['is_on'])) {
+                http_response_code(400);
+                echo json_encode(['error' => 'Missing required fields in event ' . $i]);
+                exit;
+            }
+            $placeholders[] = '(?, ?, ?, ?, ?)';
+            $types .= 'siddd';
+            $values[] = $event['timestamp'];
+            $values[] = (int)$event['is_on'];
+            $values[] = isset($event['temp_vorlauf']) && $event['temp_vorlauf'] !== null ? (float)$event['temp_vorlauf'] : null;
+            $values[] = isset($event['temp_ruecklauf']) && $event['temp_ruecklauf'] !== null ? (float)$event['temp_ruecklauf'] : null;
+            $values[] = isset($event['tank_liters']) && $event['tank_liters'] !== null ? (float)$event['tank_liters'] : null;
+        }
+        
+        $mysqli->begin_transaction();
+        $stmt = $mysqli->prepare("
+            INSERT INTO switch_events (timestamp, is_on, temp_vorlauf, temp_ruecklauf, tank_liters)
+            VALUES " . implode(', ', $placeholders)
+        );
+        
+        if ($stmt && $stmt->bind_param($types, ...$values) && $stmt->execute()) {
+            $inserted = $stmt->affected_rows;
+            $mysqli->commit();
+            echo json_encode(['success' => true, 'inserted' => $inserted, 'first_id' => $mysqli->insert_id]);
+        } else {
+            $error = $stmt ? $stmt->error : $mysqli->error;
+            $mysqli->rollback();
+            http_response_code(500);
+            echo json_encode(['error' => 'Failed to save events: ' . $error]);
+        }
+        if ($stmt) {
+            $stmt->close();
+        }
+    }
     // POST /api/mysql/events - Speichere Switch-Event
     elseif ($method === 'POST' && strpos($path, '/events') !== false) {
         $input = json_decode(file_get_contents('php://input'), true);
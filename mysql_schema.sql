@@ -17,6 +17,8 @@ CREATE TABLE IF NOT EXISTS `daily_stats` (
   `max_vorlauf` DECIMAL(4,1) NULL COMMENT 'Maximale Temperatur Vorlauf',
   `min_ruecklauf` DECIMAL(4,1) NULL COMMENT 'Minimale Temperatur Rücklauf',
   `max_ruecklauf` DECIMAL(4,1) NULL COMMENT 'Maximale Temperatur Rücklauf',
+  `stddev_vorlauf` DECIMAL(5,2) NULL COMMENT 'Standardabweichung Vorlauf',
+  `stddev_ruecklauf` DECIMAL(5,2) NULL COMMENT 'Standardabweichung Rücklauf',
   `diesel_liters` DECIMAL(6,2) NOT NULL DEFAULT 0.00 COMMENT 'Dieselverbrauch in Litern',
   `samples` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Anzahl Temperaturmessungen',
   `created_at` TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
@@ -24,6 +26,11 @@ CREATE TABLE IF NOT EXISTS `daily_stats` (
   INDEX `idx_date` (`date_key`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci COMMENT='Tägliche Statistiken';
 
+-- Bestehende Installationen (Tabelle vor Firmware mit Standardabweichung angelegt):
+-- ALTER TABLE `daily_stats`
+--   ADD COLUMN IF NOT EXISTS `stddev_vorlauf` DECIMAL(5,2) NULL COMMENT 'Standardabweichung Vorlauf' AFTER `max_ruecklauf`,
+--   ADD COLUMN IF NOT EXISTS `stddev_ruecklauf` DECIMAL(5,2) NULL COMMENT 'Standardabweichung Rücklauf' AFTER `stddev_vorlauf`;
+
 -- Tabelle für Switch-Events (Heizungsperioden)
 CREATE TABLE IF NOT EXISTS `switch_events` (
   `id` INT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY,
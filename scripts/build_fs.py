@@ -0,0 +1,105 @@
+# PlatformIO extra script for the firmware envs: builds the LittleFS image from a staged copy of data/.
+#   - text assets are gzip-compressed (the web server sends "<file>.gz" with Content-Encoding: gzip
+#     when "<file>" is missing)
+#   - index.html references CSS/JS as "<asset>?v=<content hash>"; /asset-versions (uncompressed,
+#     "<url> <hash>" per line) tells the device which "v" is current, only that one is served immutable
+#   - /asset-manifest.json lists the URLs the service worker precaches with their content hashes; the
+#     manifest version is written into sw.js, so every frontend change installs a new service worker
+# data/ itself stays untouched. The stage lives in .pio/build/<env>/data.
+import gzip
+import hashlib
+import json
+import os
+import re
+import shutil
+
+Import("env")
+
+COMPRESS_EXT = (".html", ".js", ".css", ".json", ".svg", ".txt")
+VERSIONED_ASSETS = ("assets/css/style.css", "assets/js/script.js")
+FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+# Served under these URLs besides the versioned assets (see staticAssets[] in main.cpp)
+PRECACHE_FILES = (("/", "index.html"), ("/manifest.json", "manifest.json"))
+SW_VERSION_PLACEHOLDER = "__ASSET_VERSION__"
+VERSIONS_FILE = "asset-versions"  # No extension: stays uncompressed, read by initStaticAssets()
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:12]
+
+
+def stage_data(source, stage):
+    if os.path.isdir(stage):
+        shutil.rmtree(stage)
+    shutil.copytree(source, stage)
+
+    # Versioned URLs for the assets referenced by index.html
+    precache = []
+    versions = []
+    index_path = os.path.join(stage, "index.html")
+    if os.path.isfile(index_path):
+        with open(index_path, "r", encoding="utf-8") as f:
+            html = f.read()
+        for asset in VERSIONED_ASSETS:
+            path = os.path.join(stage, asset)
+            if not os.path.isfile(path):
+                continue
+            with open(path, "rb") as f:
+                version = content_hash(f.read())
+            html = re.sub(r'(["\'])/?' + re.escape(asset) + r'(\?v=[0-9a-f]*)?\1',
+                          lambda m: m.group(1) + asset + "?v=" + version + m.group(1), html)
+            precache.append({"url": "/" + asset + "?v=" + version, "hash": version})
+            versions.append("/" + asset + " " + version + "\n")
+        with open(index_path, "w", encoding="utf-8") as f:
+            f.write(html)
+    with open(os.path.join(stage, VERSIONS_FILE), "w", encoding="utf-8") as f:
+        f.write("".join(versions))
+
+    for url, name in PRECACHE_FILES:
+        path = os.path.join(stage, name)
+        if os.path.isfile(path):
+            with open(path, "rb") as f:
+                precache.insert(0, {"url": url, "hash": content_hash(f.read())})
+    precache.sort(key=lambda entry: entry["url"])
+
+    # Manifest version changes whenever any precached file changes
+    manifest_version = content_hash("".join(e["url"] + e["hash"] for e in precache).encode())
+    with open(os.path.join(stage, "asset-manifest.json"), "w", encoding="utf-8") as f:
+        json.dump({"version": manifest_version, "assets": precache}, f, separators=(",", ":"))
+
+    sw_path = os.path.join(stage, "sw.js")
+    if os.path.isfile(sw_path):
+        with open(sw_path, "r", encoding="utf-8") as f:
+            sw = f.read()
+        with open(sw_path, "w", encoding="utf-8") as f:
+            f.write(sw.replace(SW_VERSION_PLACEHOLDER, manifest_version))
+
+    raw_total = 0
+    stored_total = 0
+    for root, _, files in os.walk(stage):
+        for name in files:
+            path = os.path.join(root, name)
+            with open(path, "rb") as f:
+                data = f.read()
+            raw_total += len(data)
+            if not name.endswith(COMPRESS_EXT):
+                stored_total += len(data)
+                continue
+            # mtime=0 keeps the image reproducible (same input -> same .gz -> same ETag on the device)
+            packed = gzip.compress(data, compresslevel=9, mtime=0)
+            if len(packed) >= len(data):
+                stored_total += len(data)
+                continue
+            with open(path + ".gz", "wb") as f:
+                f.write(packed)
+            os.remove(path)
+            stored_total += len(packed)
+    print("LittleFS assets: %d bytes -> %d bytes (gzip), manifest version %s"
+          % (raw_total, stored_total, manifest_version))
+
+
+if any(target in FS_TARGETS for target in COMMAND_LINE_TARGETS):
+    source_dir = env.subst("$PROJECT_DATA_DIR")
+    stage_dir = os.path.join(env.subst("$BUILD_DIR"), "data")
+    stage_data(source_dir, stage_dir)
+    env.Replace(PROJECT_DATA_DIR=stage_dir)
@@ -0,0 +1,5 @@
+# PlatformIO extra script for env:native_asan: build_flags only reach the compiler,
+# the sanitizer runtimes must be linked as well.
+Import("env")
+
+env.Append(LINKFLAGS=["-fsanitize=address,undefined"])
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "control.h"
+#include "hal.h"
+
+BenchResult benchRun(const char* name, uint32_t iterations, BenchFn fn, void* ctx) {
+    BenchResult r;
+    memset(&r, 0, sizeof(r));
+    r.name = name;
+    uint32_t perBatch = iterations / BENCH_BATCHES;
+    if (perBatch == 0) perBatch = 1;
+    r.iterations = perBatch * BENCH_BATCHES;
+
+    fn(ctx);  // Warm-up (caches, lazy allocations, first flash page)
+
+    uint64_t totalUs = 0;
+    uint64_t totalCycles = 0;
+    for (int b = 0; b < BENCH_BATCHES; b++) {
+        uint32_t cycles0 = hal::cycleCount();
+        uint64_t t0 = hal::monotonicUs();
+        for (uint32_t i = 0; i < perBatch; i++) {
+            fn(ctx);
+        }
+        uint64_t us = hal::monotonicUs() - t0;
+        uint32_t cycles = hal::cycleCount() - cycles0;  // 32 bit: a batch must stay below ~17 s at 240 MHz
+        double perCall = (double)us / perBatch;
+        if (b == 0 || perCall < r.usMin) r.usMin = perCall;
+        if (b == 0 || perCall > r.usMax) r.usMax = perCall;
+        totalUs += us;
+        totalCycles += cycles;
+    }
+    r.usMean = (double)totalUs / r.iterations;
+    r.cyclesMean = (double)totalCycles / r.iterations;
+    return r;
+}
+
+size_t benchFormat(const BenchResult& r, const char* platform, char* buf, size_t size) {
+    int n = snprintf(buf, size,
+                     "{\"bench\":\"%s\",\"platform\":\"%s\",\"iterations\":%lu,\"usMean\":%.3f,"
+                     "\"usMin\":%.3f,\"usMax\":%.3f,\"cyclesMean\":%.0f}",
+                     r.name, platform, (unsigned long)r.iterations, r.usMean, r.usMin, r.usMax, r.cyclesMean);
+    return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+}
+
+// ========== PORTABLE CASES ==========
+void benchAggregateInit(BenchAggregateCtx& ctx, time_t now, uint32_t nowMs) {
+    ctx.now = now;
+    ctx.nowMs = nowMs;
+    uint32_t end = (uint32_t)now;
+    for (int i = 0; i < 8; i++) {
+        ctx.bounds[i] = end - (7 - i) * 86400;
+    }
+}
+
+void benchCaseAggregate(void* ctx) {
+    BenchAggregateCtx& c = *(BenchAggregateCtx*)ctx;
+    switchEventsAggregate(c.bounds, 7, c.windows, c.now, c.nowMs);
+}
+
+void benchCaseUnusualBehavior(void* ctx) {
+    (void)ctx;
+    checkUnusualBehavior();
+}
+
+void benchCaseFsAppend(void* ctx) {
+    BenchPersistCtx& c = *(BenchPersistCtx*)ctx;
+    c.counter++;
+    memcpy(c.record, &c.counter, sizeof(c.counter));
+    hal::fsAppend(c.path, c.record, sizeof(c.record));
+}
+
+void benchCaseNvsPut(void* ctx) {
+    BenchPersistCtx& c = *(BenchPersistCtx*)ctx;
+    c.counter++;
+    memcpy(c.record, &c.counter, sizeof(c.counter));
+    hal::nvsPut(c.nvsNamespace, "rec", c.record, sizeof(c.record));
+}
+
+void benchFillSwitchEvents(int count, time_t now, uint32_t spacingS) {
+    for (int i = 0; i < MAX_SWITCH_EVENTS; i++) {
+        switchEvents[i] = SwitchEvent();
+    }
+    switchEventIndex = 0;
+    for (int i = 0; i < count; i++) {
+        SwitchEvent& evt = switchEvents[switchEventIndex];
+        evt.timestamp = (unsigned long)now - (unsigned long)(count - i) * spacingS;
+        evt.isOn = (i % 2) == 0;
+        evt.tempVorlauf = evt.isOn ? 32.0f : 55.0f;
+        evt.tempRuecklauf = evt.isOn ? 30.0f : 40.0f;
+        evt.uptimeMs = 1000 + i;
+        evt.tankLiters = 800.0f - i * 0.5f;
+        switchEventIndex = (switchEventIndex + 1) % MAX_SWITCH_EVENTS;
+    }
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <string.h>
+#include "control.h"
+#include "hal.h"
+
+ControlMode controlModeFromName(const char* name) {
+    if (strcmp(name, "auto") == 0) return CONTROL_AUTO;
+    if (strcmp(name, "schedule") == 0) return CONTROL_SCHEDULE;
+    if (strcmp(name, "frost") == 0) return CONTROL_FROST;
+    return CONTROL_MANUAL;
+}
+
+// ========== FROST PROTECTION ==========
+void frostProtection() {
+    ControlState& state = controlState;
+    if (!state.frostProtectionEnabled) {
+        return;
+    }
+
+    // Use the lower temperature (usually Rücklauf)
+    float checkTemp = state.tempRuecklauf;
+    if (isnan(checkTemp) && !isnan(state.tempVorlauf)) {
+        checkTemp = state.tempVorlauf;
+    }
+
+    if (isnan(checkTemp)) {
+        return;  // No valid temperature
+    }
+
+    // Turn ON if below frost protection temperature
+    if (checkTemp < state.frostProtectionTemp && !state.heatingOn) {
+        hal::log("FROST: Temperature %.1f°C < %.1f°C, turning heater ON\n",
+                 checkTemp, state.frostProtectionTemp);
+        setHeater(true, false);
+    }
+    // Turn OFF if 2°C above frost protection (hysteresis)
+    else if (checkTemp > (state.frostProtectionTemp + 2.0) && state.heatingOn) {
+        hal::log("FROST: Temperature %.1f°C safe, turning heater OFF\n", checkTemp);
+        setHeater(false, false);
+    }
+}
+
+// ========== AUTOMATIC CONTROL WITH HYSTERESIS ==========
+void automaticControl() {
+    ControlState& state = controlState;
+    if (state.controlMode != CONTROL_AUTO) {
+        return;
+    }
+
+    // Use Rücklauf temperature for control
+    if (isnan(state.tempRuecklauf)) {
+        return;
+    }
+
+    // Hysteresis logic (like W1209)
+    // Turn ON if below EIN temperature
+    if (state.tempRuecklauf <= state.tempOn && !state.heatingOn) {
+        hal::log("AUTO: Rücklauf %.1f°C <= %.1f°C, turning heater ON\n",
+                 state.tempRuecklauf, state.tempOn);
+        setHeater(true, false);
+    }
+    // Turn OFF if above AUS temperature
+    else if (state.tempRuecklauf >= state.tempOff && state.heatingOn) {
+        hal::log("AUTO: Rücklauf %.1f°C >= %.1f°C, turning heater OFF\n",
+                 state.tempRuecklauf, state.tempOff);
+        setHeater(false, false);
+    }
+    // Between EIN and AUS: maintain current state (hysteresis zone)
+}
+
+// ========== PUMP COOLDOWN LOGIC ==========
+void handlePumpCooldown() {
+    ControlState& state = controlState;
+    // Only handle cooldown if heating is OFF and we're not in manual mode with manual pump override
+    if (state.heatingOn) {
+        return;  // Heating is ON, pump should be ON (handled by setHeater)
+    }
+
+    bool manualOverride = state.controlMode == CONTROL_MANUAL && state.pumpManualMode;
+
+    // In manual mode: if pumpManualMode is true, keep pump ON regardless of heating state
+    if (manualOverride) {
+        if (!state.pumpOn) {
+            setPump(true, true);  // Turn pump ON due to manual override
+        }
+        return;
+    }
+
+    // Check if cooldown period has elapsed
+    if (state.lastHeatingOffTime > 0 && state.pumpOn) {
+        uint32_t elapsed = hal::millis() - state.lastHeatingOffTime;
+
+        // After cooldown period, turn pump OFF
+        if (elapsed >= PUMP_COOLDOWN_MS) {
+            hal::log("[Pump] Cooldown period (%lu seconds) elapsed, turning pump OFF\n",
+                     (unsigned long)(PUMP_COOLDOWN_MS / 1000));
+            setPump(false, false);
+            state.lastHeatingOffTime = 0;  // Reset timer
+        } else {
+            // Still in cooldown period
+            uint32_t remaining = (PUMP_COOLDOWN_MS - elapsed) / 1000;
+            // Only log every 30 seconds to avoid spam
+            static uint32_t lastCooldownLog = 0;
+            if (hal::millis() - lastCooldownLog > 30000) {
+                hal::log("[Pump] Cooldown: %lu seconds remaining\n", (unsigned long)remaining);
+                lastCooldownLog = hal::millis();
+            }
+        }
+    }
+}
+
+// ========== FAILSAFE CHECK ==========
+void checkFailsafe() {
+    ControlState& state = controlState;
+    // If both sensors fail, turn off both heating and pump
+    if (isnan(state.tempVorlauf) && isnan(state.tempRuecklauf)) {
+        if (state.heatingOn) {
+            hal::logError("FAILSAFE: All sensors failed, turning heater OFF\n");
+            setHeater(false);
+        }
+        // If user explicitly enabled manual pump override in manual mode, don't fight it.
+        // Otherwise, turn pump OFF for safety to avoid oscillation with cooldown/manual logic.
+        if (state.pumpOn && !(state.controlMode == CONTROL_MANUAL && state.pumpManualMode)) {
+            hal::logError("FAILSAFE: All sensors failed, turning pump OFF\n");
+            setPump(false, false);
+        }
+
+        // Send Telegram notification once
+        if (!state.sensorErrorNotified) {
+            controlNotify("⚠️ SENSOR-FEHLER!\n\nBeide Temperatursensoren ausgefallen.\nHeizung und Pumpe wurden automatisch deaktiviert.");
+            state.sensorErrorNotified = true;
+        }
+    } else {
+        // Reset flag when sensors are working again
+        if (state.sensorErrorNotified) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "✅ Sensoren wieder OK\n\n🌡️ Vorlauf: %.1f°C", state.tempVorlauf);
+            controlNotify(msg);
+            state.sensorErrorNotified = false;
+        }
+    }
+
+    // CRITICAL SAFETY CHECK: Ensure heating is never ON without pump
+    if (state.heatingOn && !state.pumpOn) {
+        hal::logError("[FAILSAFE] ⚠️ CRITICAL: Heating ON but pump OFF - forcing pump ON!\n");
+        setPump(true, false);
+    }
+}
+
+// ========== CHECK FOR UNUSUAL BEHAVIOR ==========
+void controlRecordSwitch() {
+    ControlState& state = controlState;
+    state.switchTimestamps[state.switchHistoryIndex] = hal::millis();
+    state.switchHistoryIndex = (state.switchHistoryIndex + 1) % MAX_SWITCH_HISTORY;
+}
+
+void checkUnusualBehavior() {
+    ControlState& state = controlState;
+    uint32_t now = hal::millis();
+    int switchCountInWindow = 0;
+
+    // Count switches in the last WARNING_TIME_WINDOW_MS
+    for (int i = 0; i < MAX_SWITCH_HISTORY; i++) {
+        if (state.switchTimestamps[i] > 0 && (now - state.switchTimestamps[i]) < WARNING_TIME_WINDOW_MS) {
+            switchCountInWindow++;
+        }
+    }
+
+    // Check if we exceed the threshold
+    bool shouldWarn = (switchCountInWindow >= WARNING_THRESHOLD_SWITCHES);
+
+    if (shouldWarn && !state.behaviorWarningActive) {
+        state.behaviorWarningActive = true;
+        state.lastBehaviorWarningTime = now;
+
+        hal::logWarn("⚠️ WARNUNG: Ungewöhnliches Verhalten erkannt! %d Schaltungen in den letzten 15 Minuten.\n", switchCountInWindow);
+
+        char msg[128];
+        snprintf(msg, sizeof(msg), "⚠️ WARNUNG: Ungewöhnliches Verhalten!\n%d Schaltungen in den letzten 15 Minuten.\n"
+                 "Bitte Heizungsanlage prüfen!", switchCountInWindow);
+        controlNotify(msg);
+    } else if (!shouldWarn && state.behaviorWarningActive) {
+        // Clear warning if behavior normalized
+        state.behaviorWarningActive = false;
+        hal::log("✅ Verhalten normalisiert - Warnung aufgehoben\n");
+    }
+}
@@ -0,0 +1,86 @@
+// ESP32 implementation of hal.h on top of the Arduino core
+#include <Arduino.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <stdarg.h>
+#include <esp_timer.h>
+#include "hal.h"
+#include "log_level.h"
+
+extern fs::LittleFSFS* dataFs;         // main.cpp: data partition (asset partition on the old partition table)
+void logTaggedLine(const char* line, uint8_t level);  // main.cpp
+
+namespace hal {
+
+// ========== CLOCK ==========
+uint32_t millis() {
+    return ::millis();
+}
+
+void delay(uint32_t ms) {
+    ::delay(ms);
+}
+
+uint64_t monotonicUs() {
+    return esp_timer_get_time();
+}
+
+uint32_t cycleCount() {
+    return ESP.getCycleCount();
+}
+
+// ========== NVS ==========
+bool nvsPut(const char* ns, const char* key, const void* data, size_t len) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) {
+        return false;
+    }
+    bool ok = prefs.putBytes(key, data, len) == len;
+    prefs.end();
+    return ok;
+}
+
+// ========== FILESYSTEM ==========
+bool fsAppend(const char* path, const void* data, size_t len) {
+    File f = dataFs->open(path, FILE_APPEND);
+    if (!f) {
+        return false;
+    }
+    bool ok = f.write((const uint8_t*)data, len) == len;
+    f.close();
+    return ok;
+}
+
+bool fsRemove(const char* path) {
+    return dataFs->remove(path);
+}
+
+// ========== LOG ==========
+static void logLine(uint8_t level, const char* format, va_list args) {
+    char buffer[256];
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    logTaggedLine(buffer, level);
+}
+
+void log(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(LOG_LEVEL_INFO, format, args);
+    va_end(args);
+}
+
+void logWarn(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(LOG_LEVEL_WARN, format, args);
+    va_end(args);
+}
+
+void logError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(LOG_LEVEL_ERROR, format, args);
+    va_end(args);
+}
+
+}  // namespace hal
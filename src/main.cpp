@@ -11,7 +11,20 @@
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <stdarg.h>
+#include <atomic>
+#include <memory>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <esp32/rom/crc.h>
 #include "secrets.h"
+#include "control.h"
+#include "switch_events.h"
+#include "tank_filter.h"
+#include "log_level.h"
+#ifdef BENCH_ENABLED
+#include "bench.h"
+#include "hal.h"
+#endif
 
 // ========== PIN CONFIGURATION ==========
 #define HEATING_RELAY_PIN 21  // GPIO21 for heating relay control (Active-Low) (GPIO23 seems unreliable on some boards)
@@ -33,11 +46,12 @@
 #define TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"  // Europe/Berlin
 #define DEBOUNCE_MS 300
 #define TEMP_READ_INTERVAL 1000
+#define TEMP_DEFAULT_RESOLUTION 12    // DS18B20 resolution in bits (9..12): 9=94ms, 10=188ms, 11=375ms, 12=750ms conversion
 #define MAX_SCHEDULES 4
 #define TANK_READ_INTERVAL 5000       // Read tank level every 5 seconds
 #define ULTRASONIC_TIMEOUT 30000      // 30ms timeout for echo (max ~5m range)
+#define TANK_BURST_SPACING_MS 60      // Gap between pings of a burst (JSN-SR04T needs >=50ms for echoes to die down)
 #define WEATHER_UPDATE_INTERVAL 600000  // Update weather every 10 minutes
-#define PUMP_COOLDOWN_MS 180000       // Pump stays ON for 180 seconds after heating turns OFF (3 minutes)
 
 // ========== GLOBAL OBJECTS ==========
 AsyncWebServer server(80);
@@ -49,6 +63,28 @@ Preferences prefs;
 OneWire* oneWire = nullptr;
 DallasTemperature* sensors = nullptr;
 
+// ========== CONTROL LOCK ==========
+// Relay state and control settings are touched by the control task, the sensing task and the
+// async_tcp task (web handlers). Everything that switches relays or changes control settings
+// holds this recursive mutex (recursive because setHeater() calls setPump()).
+SemaphoreHandle_t controlMutex = nullptr;
+
+struct ControlLock {
+    ControlLock() { xSemaphoreTakeRecursive(controlMutex, portMAX_DELAY); }
+    ~ControlLock() { xSemaphoreGiveRecursive(controlMutex); }
+    ControlLock(const ControlLock&) = delete;
+    ControlLock& operator=(const ControlLock&) = delete;
+};
+
+// Scoped lock for plain (non-recursive) mutexes
+struct MutexLock {
+    explicit MutexLock(SemaphoreHandle_t m) : mutex(m) { xSemaphoreTake(mutex, portMAX_DELAY); }
+    ~MutexLock() { xSemaphoreGive(mutex); }
+    MutexLock(const MutexLock&) = delete;
+    MutexLock& operator=(const MutexLock&) = delete;
+    SemaphoreHandle_t mutex;
+};
+
 // ========== TANK SENSOR DEBUG ==========
 static volatile unsigned long lastUltrasonicDurationUs = 0;
 static volatile int lastEchoBefore = -1;
@@ -56,6 +92,41 @@ static volatile int lastEchoAfter = -1;
 static volatile float lastUltrasonicDistanceCm = -1.0f;
 static volatile uint8_t lastTankErrorCode = 0; // 0=OK, 1=TIMEOUT, 2=OUT_OF_RANGE
 
+// ========== TANK SENSOR ECHO CAPTURE (ISR) ==========
+// The echo pulse is timed by a GPIO edge interrupt instead of pulseIn(): the ISR timestamps the rising
+// and falling edge into a single-slot mailbox and loop() only consumes finished samples.
+// Single producer (ISR) / single consumer (loop): the ISR writes the timestamps before publishing
+// ECHO_DONE, the consumer only reads them after seeing ECHO_DONE (volatile accesses are ordered on Xtensa).
+enum EchoCaptureState : uint8_t {
+    ECHO_IDLE = 0,    // Not armed, edges are ignored
+    ECHO_ARMED = 1,   // Trigger sent, waiting for rising edge
+    ECHO_HIGH = 2,    // Rising edge captured, waiting for falling edge
+    ECHO_DONE = 3     // Both edges captured, sample ready for consumer
+};
+static volatile uint8_t echoCaptureState = ECHO_IDLE;
+static volatile uint32_t echoRiseUs = 0;
+static volatile uint32_t echoFallUs = 0;
+static volatile uint32_t echoEdgeCount = 0;     // Total edges seen (diagnostics for noisy/floating ECHO)
+static uint32_t tankPingStartUs = 0;            // micros() when TRIG pulse ended
+static bool tankPingPending = false;            // Ping sent, result not yet consumed
+static volatile long lastEchoDelayUs = -1;      // Trigger -> rising edge (sensor reaction time)
+
+// ========== TANK BURST ==========
+// Each tank reading is a burst of TANK_BURST_SAMPLES spaced pings, reduced by filterTankBurst()
+// (tank_filter.cpp). Missed echoes are stored as NAN. tankBurst[] belongs to the sensing task; every
+// finished burst is published as a copy for /api/tank-debug (web server task) under tankBurstMutex.
+static float tankBurst[TANK_BURST_SAMPLES];
+static uint8_t tankBurstCount = 0;              // Pings completed in the current burst
+static bool tankBurstActive = false;
+static unsigned long tankBurstLastPingMs = 0;
+
+struct TankBurstSnapshot {
+    float samples[TANK_BURST_SAMPLES] = {};
+    TankBurstDiag diag;
+};
+static TankBurstSnapshot lastBurst;             // Last finished burst (guarded by tankBurstMutex)
+SemaphoreHandle_t tankBurstMutex = nullptr;
+
 // Smooth tank availability to avoid UI flapping on occasional missed echoes
 static unsigned long lastTankGoodMs = 0;
 static float lastTankGoodDistanceCm = -1.0f;
@@ -65,6 +136,20 @@ DeviceAddress sensor1Address, sensor2Address;  // Will store unique addresses
 bool sensor1Found = false;
 bool sensor2Found = false;
 
+// ========== ASYNC TEMPERATURE CONVERSION ==========
+// DS18B20 conversions run in the background: requestTemperatures() only starts the conversion
+// (setWaitForConversion(false)) and the results are collected once the conversion time for the
+// slowest configured resolution has elapsed. This keeps loop() responsive (no 750ms stall at 12 bit).
+enum TempConversionPhase : uint8_t {
+    TEMP_IDLE = 0,        // No conversion running, ready to start a new one
+    TEMP_CONVERTING = 1   // Conversion started, waiting for deadline
+};
+static TempConversionPhase tempPhase = TEMP_IDLE;
+static unsigned long tempConversionStartMs = 0;
+static unsigned long tempConversionWaitMs = 0;
+static volatile bool sensorResolutionDirty = true;  // Apply configured resolution before next conversion
+static volatile bool temperaturesUpdated = false;   // Set by sensing task, consumed by control task
+
 // ========== SCHEDULE STRUCTURE ==========
 struct Schedule {
     bool enabled = false;
@@ -83,45 +168,18 @@ struct Statistics {
     unsigned long lastResetDay = 0;        // Day of last reset (for daily stats)
 } stats;
 
-// ========== SWITCH EVENT HISTORY ==========
-#define MAX_SWITCH_EVENTS 50  // Store last 50 switch events
-struct SwitchEvent {
-    unsigned long timestamp = 0;  // Unix timestamp (or 0 if NTP not synced)
-    bool isOn = false;            // true = ON, false = OFF
-    float tempVorlauf = NAN;      // Temperature when switched
-    float tempRuecklauf = NAN;
-    unsigned long uptimeMs = 0;   // Uptime in milliseconds (fallback if no NTP)
-    float tankLiters = NAN;       // Tank level in liters when switched (for consumption comparison)
-} switchEvents[MAX_SWITCH_EVENTS];
-int switchEventIndex = 0;  // Ring buffer index
-
-// ========== BEHAVIOR WARNING TRACKING ==========
-#define MAX_SWITCH_HISTORY 20
-#define WARNING_THRESHOLD_SWITCHES 10  // Warn if more than 10 switches
-#define WARNING_TIME_WINDOW_MS (15 * 60 * 1000)  // in last 15 minutes
-unsigned long switchTimestamps[MAX_SWITCH_HISTORY];
-int switchHistoryIndex = 0;
-bool behaviorWarningActive = false;
-unsigned long lastBehaviorWarningTime = 0;
-
 // ========== GLOBAL STATE ==========
-struct SystemState {
-    bool heatingOn = false;
-    bool pumpOn = false;          // Pump state (circulation pump)
-    bool pumpManualMode = false;  // Manual pump override (only in manual mode)
-    float tempVorlauf = NAN;    // Forward flow temperature
-    float tempRuecklauf = NAN;  // Return flow temperature
-    String mode = "manual";     // "manual", "auto", "schedule", or "frost"
-    float tempOn = 30.0;        // Turn ON temperature (hysteresis min)
-    float tempOff = 40.0;       // Turn OFF temperature (hysteresis max)
+// Relay state, temperatures and control settings live in ControlState (include/control.h)
+struct SystemState : ControlState {
+    String mode = "manual";     // "manual", "auto", "schedule", or "frost" (parsed into controlMode)
     Schedule schedules[MAX_SCHEDULES];
     unsigned long uptime = 0;
     bool apModeActive = false;
     bool ntpSynced = false;
     
-    // Frost protection
-    bool frostProtectionEnabled = false;
-    float frostProtectionTemp = 8.0;  // Minimum temperature
+    // DS18B20 resolution per sensor (9..12 bit, lower = faster conversion, coarser steps)
+    uint8_t sensor1Resolution = TEMP_DEFAULT_RESOLUTION;
+    uint8_t sensor2Resolution = TEMP_DEFAULT_RESOLUTION;
     
     // Tank level monitoring (JSN-SR04T)
     bool tankSensorAvailable = false;   // Sensor detected and working
@@ -130,6 +188,7 @@ struct SystemState {
     float tankDistance = -1.0;          // Current distance to liquid surface in cm
     float tankLiters = 0.0;             // Calculated liters
     int tankPercent = 0;                // Calculated fill percentage
+    int tankConfidence = 0;             // Confidence of last reading (0-100, valid echoes x spread)
     
     // Diesel consumption calculation
     float dieselConsumptionPerHour = 2.0;  // Default: 2.0 liters per hour when heating is ON
@@ -159,6 +218,7 @@ struct SystemState {
     bool mysqlConnected = false;
     unsigned long lastMySQLCheck = 0;
 } state;
+ControlState& controlState = state;
 
 // ========== RELAY DRIVER HELPERS ==========
 static void applyRelayOutput(uint8_t pin, bool on, bool activeLow, uint8_t offMode, const char* nameForLog) {
@@ -241,6 +301,7 @@ struct WeatherData {
     // Location name
     String locationName = "";
 } weather;
+SemaphoreHandle_t weatherMutex = nullptr;  // Weather is fetched by the outbound worker, read by web handlers
 
 unsigned long lastToggleTime = 0;
 unsigned long lastTempRead = 0;
@@ -248,7 +309,6 @@ unsigned long lastTankRead = 0;
 unsigned long lastWeatherFetch = 0;
 unsigned long bootTime = 0;
 unsigned long lastStateChangeTime = 0;
-unsigned long lastHeatingOffTime = 0;  // Timestamp when heating was turned OFF (for pump cooldown)
 unsigned long scheduledRebootTime = 0;  // Timestamp for scheduled reboot after OTA update
 bool rebootScheduled = false;  // Flag to indicate reboot is scheduled
 bool otaUpdateInProgress = false;  // Flag to prevent WiFi reconnect during OTA update
@@ -256,62 +316,403 @@ unsigned long lastWiFiReconnectAttempt = 0;  // Rate limiting for WiFi reconnect
 const unsigned long WIFI_RECONNECT_INTERVAL = 60000;  // Only try reconnect every 60 seconds
 
 // Telegram notification flags
-bool sensorErrorNotified = false;
 bool tankLowNotified = false;
 unsigned long lastTankLowTelegramMs = 0;
 
+// ========== LOG CHANNELS ==========
+// Every log line belongs to a channel (subsystem). Lines from LOG_ERROR/WARN/INFO/DEBUG() carry their
+// channel explicitly; plain serialLog() lines are assigned by their tag prefix ("[MySQL] ..." -> mysql).
+// Levels above LOG_COMPILE_LEVEL are removed by the compiler (set it in platformio.ini build_flags,
+// e.g. -DLOG_COMPILE_LEVEL=2 keeps only errors and warnings). Below that, each channel has a runtime
+// level (GET/POST /api/log-config, stored in NVS). WebSocket clients can subscribe to a subset of
+// channels (/ws?channels=mysql,relay or the message "channels:mysql,relay").
+// LOG_LEVEL_* and the LOG_COMPILE_LEVEL default are in include/log_level.h (shared with hal_esp32.cpp).
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO
+
+enum LogChannel : uint8_t {
+    LOGCH_SYSTEM,
+    LOGCH_CONTROL,
+    LOGCH_RELAY,
+    LOGCH_PUMP,
+    LOGCH_SENSOR,
+    LOGCH_MYSQL,
+    LOGCH_WEATHER,
+    LOGCH_TELEGRAM,
+    LOGCH_API,
+    LOGCH_STORAGE,
+    LOGCH_COUNT
+};
+#define LOGCH_AUTO 0xFF              // Channel taken from the line's tag prefix
+#define LOGCH_ALL_MASK ((1UL << LOGCH_COUNT) - 1)
+
+static const char* const logChannelNames[] = {
+    "system", "control", "relay", "pump", "sensor", "mysql", "weather", "telegram", "api", "storage"
+};
+static_assert(sizeof(logChannelNames) / sizeof(logChannelNames[0]) == LOGCH_COUNT, "logChannelNames must match LogChannel");
+static const char* const logLevelNames[] = { "none", "error", "warn", "info", "debug" };
+
+// Tag prefixes of existing log lines and the channel they belong to
+struct LogTagMapping {
+    const char* prefix;
+    uint8_t channel;
+};
+static const LogTagMapping logTagMap[] = {
+    { "[Relay]", LOGCH_RELAY }, { "[Pump]", LOGCH_PUMP }, { "Switch #", LOGCH_RELAY },
+    { "[Sensor]", LOGCH_SENSOR }, { "[Tank", LOGCH_SENSOR },
+    { "[MySQL]", LOGCH_MYSQL }, { "[Weather]", LOGCH_WEATHER }, { "[Geocode]", LOGCH_WEATHER },
+    { "[Telegram]", LOGCH_TELEGRAM }, { "[API]", LOGCH_API },
+    { "[Outbox]", LOGCH_STORAGE }, { "[Outbound]", LOGCH_STORAGE }, { "[SwitchEvents]", LOGCH_STORAGE },
+    { "[Stats]", LOGCH_STORAGE },
+    { "AUTO:", LOGCH_CONTROL }, { "FROST:", LOGCH_CONTROL }, { "SCHEDULE:", LOGCH_CONTROL },
+    { "FAILSAFE", LOGCH_CONTROL }, { "[FAILSAFE]", LOGCH_CONTROL },
+};
+
+uint8_t logChannelLevel[LOGCH_COUNT] = {
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL,
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL
+};
+
+void logChannelF(uint8_t channel, const char* format, ...);
+
+#define LOGC(channel, level, ...) \
+    do { \
+        if ((level) <= LOG_COMPILE_LEVEL && (level) <= logChannelLevel[channel]) { \
+            logChannelF(channel, __VA_ARGS__); \
+        } \
+    } while (0)
+#define LOG_ERROR(channel, ...) LOGC(channel, LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(channel, ...) LOGC(channel, LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(channel, ...) LOGC(channel, LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(channel, ...) LOGC(channel, LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+int logChannelByName(const char* name) {
+    for (int i = 0; i < LOGCH_COUNT; i++) {
+        if (strcasecmp(name, logChannelNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int logLevelByName(const char* name) {
+    for (int i = 0; i <= LOG_LEVEL_DEBUG; i++) {
+        if (strcasecmp(name, logLevelNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static uint8_t logChannelForLine(const char* line, size_t len) {
+    for (size_t i = 0; i < sizeof(logTagMap) / sizeof(logTagMap[0]); i++) {
+        size_t prefixLen = strlen(logTagMap[i].prefix);
+        if (len >= prefixLen && memcmp(line, logTagMap[i].prefix, prefixLen) == 0) {
+            return logTagMap[i].channel;
+        }
+    }
+    return LOGCH_SYSTEM;
+}
+
+// "mysql,relay" -> channel bit mask ("all" or empty = every channel)
+uint32_t logParseChannelMask(const char* list) {
+    if (!list || !*list || strcasecmp(list, "all") == 0) {
+        return LOGCH_ALL_MASK;
+    }
+    uint32_t mask = 0;
+    char name[16];
+    while (*list) {
+        size_t n = strcspn(list, ",");
+        if (n > 0 && n < sizeof(name)) {
+            memcpy(name, list, n);
+            name[n] = '\0';
+            int ch = logChannelByName(name);
+            if (ch >= 0) mask |= 1UL << ch;
+        }
+        list += n;
+        if (*list == ',') list++;
+    }
+    return mask ? mask : LOGCH_ALL_MASK;
+}
+
+void loadLogConfig() {
+    prefs.begin("logcfg", true);
+    for (int i = 0; i < LOGCH_COUNT; i++) {
+        uint8_t level = prefs.getUChar(logChannelNames[i], LOG_DEFAULT_LEVEL);
+        logChannelLevel[i] = level <= LOG_LEVEL_DEBUG ? level : LOG_DEFAULT_LEVEL;
+    }
+    prefs.end();
+}
+
+void saveLogConfig() {
+    prefs.begin("logcfg", false);
+    for (int i = 0; i < LOGCH_COUNT; i++) {
+        prefs.putUChar(logChannelNames[i], logChannelLevel[i]);
+    }
+    prefs.end();
+}
+
 // ========== SERIAL MONITOR (WebSocket) ==========
-#define LOG_BUFFER_SIZE 200  // Increased to store more boot messages
-String logBuffer[LOG_BUFFER_SIZE];
-int logBufferIndex = 0;
-int logBufferCount = 0;
+// Log history lives in one fixed byte ring (no String objects, flat heap). serialLog() fragments are
+// assembled into complete lines; every line is stored as [seq:u32][len:u16][channel:u8][text] and
+// gets a monotonically increasing sequence number. When the ring is full the oldest lines are overwritten.
+// Every /ws client has a cursor (next line to send). The housekeeping task streams lines from the ring
+// to each client in chunks of at most LOG_WS_CHUNK bytes, and only while the client's send queue is
+// short, so history for a new client (or many clients reconnecting after an OTA reboot) never needs
+// more than one chunk per client in flight. Every WebSocket message starts with a header line
+// "@@<session>:<seq of first line>", so a client can drop duplicates and reconnect with
+// /ws?session=<session>&since=<last seq> to receive only what it missed. If lines were overwritten
+// before they could be sent, the header gets a "!<count>" suffix. Lines of channels the client did not
+// subscribe to are skipped; a new header line "@@<session>:<seq>" follows each skipped run.
+#define LOG_RING_SIZE 16384          // Bytes of log history (line text + 7 byte header per line)
+#define LOG_LINE_MAX 256             // Longer lines are split
+#define LOG_WS_CHUNK 2048            // Max bytes per WebSocket message
+
+struct __attribute__((packed)) LogRecordHeader {
+    uint32_t seq;
+    uint16_t len;
+    uint8_t channel;
+};
+
+uint8_t logRing[LOG_RING_SIZE];
+size_t logRingHead = 0;              // Write offset
+size_t logRingTail = 0;              // Offset of the oldest line
+size_t logRingUsed = 0;
+uint32_t logFirstSeq = 1;            // Sequence number of the oldest line in the ring
+uint32_t logNextSeq = 1;             // Sequence number of the next committed line
+uint32_t logOverwrittenLines = 0;
+uint32_t logSessionId = 0;           // Random per boot, lets clients detect a reboot (seq restarts at 1)
+char logLine[LOG_LINE_MAX];          // Line being assembled from serialLog() fragments
+size_t logLineLen = 0;
+uint8_t logLineChannel = LOGCH_AUTO; // Channel of the line being assembled
+bool logLineOpen = false;            // Part of the current line was already written (Serial or logLine)
+bool logLineDropped = false;         // Current serialLog() line is below its channel's level (until '\n')
+char logWsBuffer[LOG_WS_CHUNK];      // Message buffer for WebSocket sends (guarded by logMutex)
 
 // Rate limiting for WebSocket - reduced to send more messages
 unsigned long lastWebSocketSend = 0;
 #define WEBSOCKET_MIN_INTERVAL 10  // Minimum 10ms between sends (was 100ms)
 
-// Queue for pending messages (to avoid losing messages due to rate limiting)
-String pendingMessage = "";
-bool hasPendingMessage = false;
+// Per-client streaming position (flow control: send only while the client's queue is short)
+#define LOG_MAX_CLIENTS 8            // Same limit as ws.cleanupClients()
+#define LOG_CLIENT_MAX_QUEUED 2      // Max messages waiting in a client's send queue
+struct LogClientCursor {
+    uint32_t clientId = 0;
+    uint32_t nextSeq = 0;            // Next line to send to this client
+    uint32_t channelMask = LOGCH_ALL_MASK;
+    bool active = false;
+};
+LogClientCursor logClients[LOG_MAX_CLIENTS];
+uint32_t logStreamChunks = 0;        // Messages sent (all clients)
+uint32_t logStreamDeferred = 0;      // Sends postponed because a client's queue was full
+
+// serialLog() is called from several tasks; the ring and line buffer are guarded by this mutex
+SemaphoreHandle_t logMutex = nullptr;
+
+static void logRingWrite(const void* src, size_t len) {
+    const uint8_t* p = (const uint8_t*)src;
+    size_t first = min(len, (size_t)(LOG_RING_SIZE - logRingHead));
+    memcpy(logRing + logRingHead, p, first);
+    memcpy(logRing, p + first, len - first);
+    logRingHead = (logRingHead + len) % LOG_RING_SIZE;
+}
+
+static void logRingRead(size_t offset, void* dst, size_t len) {
+    uint8_t* p = (uint8_t*)dst;
+    size_t first = min(len, (size_t)(LOG_RING_SIZE - offset));
+    memcpy(p, logRing + offset, first);
+    memcpy(p + first, logRing, len - first);
+}
+
+// Append one complete line (without '\n'), overwriting the oldest lines if needed
+static void logCommitLine() {
+    size_t need = sizeof(LogRecordHeader) + logLineLen;
+    while (LOG_RING_SIZE - logRingUsed < need) {
+        LogRecordHeader old;
+        logRingRead(logRingTail, &old, sizeof(old));
+        size_t oldSize = sizeof(old) + old.len;
+        logRingTail = (logRingTail + oldSize) % LOG_RING_SIZE;
+        logRingUsed -= oldSize;
+        logFirstSeq = old.seq + 1;
+        logOverwrittenLines++;
+    }
+    LogRecordHeader hdr;
+    hdr.seq = logNextSeq++;
+    hdr.len = (uint16_t)logLineLen;
+    hdr.channel = logLineChannel != LOGCH_AUTO ? logLineChannel : logChannelForLine(logLine, logLineLen);
+    logRingWrite(&hdr, sizeof(hdr));
+    logRingWrite(logLine, logLineLen);
+    logRingUsed += need;
+    logLineLen = 0;
+    logLineChannel = LOGCH_AUTO;
+}
+
+// Header line "@@<session>:<seq>[!<lost>]\n"
+static size_t logFormatHeader(char* buf, size_t size, uint32_t seq, uint32_t lost) {
+    if (lost > 0) {
+        return snprintf(buf, size, "@@%08lx:%lu!%lu\n", (unsigned long)logSessionId, (unsigned long)seq, (unsigned long)lost);
+    }
+    return snprintf(buf, size, "@@%08lx:%lu\n", (unsigned long)logSessionId, (unsigned long)seq);
+}
+
+// Fill logWsBuffer with "@@<session>:<seq>\n" and the lines fromSeq..toSeq of the channels in
+// channelMask (as many as fit). Returns the message length (0 = nothing to send); lastSeq is set to
+// the last line consumed (sent or skipped by the channel filter).
+static size_t logBuildMessage(uint32_t fromSeq, uint32_t toSeq, uint32_t channelMask, uint32_t& lastSeq) {
+    uint32_t lost = 0;
+    if (fromSeq < logFirstSeq) {
+        lost = logFirstSeq - fromSeq;
+        fromSeq = logFirstSeq;
+    }
+    lastSeq = fromSeq - 1;
+    if (fromSeq > toSeq) {
+        return 0;
+    }
+    
+    size_t len = logFormatHeader(logWsBuffer, sizeof(logWsBuffer), fromSeq, lost);
+    bool anyLine = false;
+    bool skipped = false;              // Filtered lines since the last header
+    size_t offset = logRingTail;
+    size_t scanned = 0;
+    while (scanned < logRingUsed) {
+        LogRecordHeader hdr;
+        logRingRead(offset, &hdr, sizeof(hdr));
+        size_t textOffset = (offset + sizeof(hdr)) % LOG_RING_SIZE;
+        if (hdr.seq > toSeq) {
+            break;
+        }
+        if (hdr.seq >= fromSeq) {
+            if (!(channelMask & (1UL << hdr.channel))) {
+                skipped = true;
+                lastSeq = hdr.seq;
+            } else {
+                char seqHeader[24];
+                size_t seqHeaderLen = 0;
+                if (skipped && anyLine) {
+                    seqHeaderLen = logFormatHeader(seqHeader, sizeof(seqHeader), hdr.seq, 0);
+                }
+                if (len + seqHeaderLen + hdr.len + 1 > sizeof(logWsBuffer)) {
+                    break;  // Rest goes into the next message
+                }
+                if (skipped) {
+                    if (anyLine) {
+                        memcpy(logWsBuffer + len, seqHeader, seqHeaderLen);
+                        len += seqHeaderLen;
+                    } else {
+                        // Nothing sent yet: rewrite the first header instead of adding a second one
+                        len = logFormatHeader(logWsBuffer, sizeof(logWsBuffer), hdr.seq, lost);
+                    }
+                    skipped = false;
+                }
+                logRingRead(textOffset, logWsBuffer + len, hdr.len);
+                len += hdr.len;
+                logWsBuffer[len++] = '\n';
+                lastSeq = hdr.seq;
+                anyLine = true;
+            }
+        }
+        offset = (textOffset + hdr.len) % LOG_RING_SIZE;
+        scanned += sizeof(hdr) + hdr.len;
+    }
+    return anyLine || lost > 0 ? len : 0;
+}
 
 // Custom print function that sends to both Serial and WebSocket
-// IMPORTANT: ALWAYS adds to buffer, even if no WebSocket clients connected
-void serialLog(const char* message) {
-    // Always print to Serial
-    Serial.print(message);
+// IMPORTANT: ALWAYS adds to the ring, even if no WebSocket clients connected (keeps boot messages)
+static void logWrite(const char* message, uint8_t channel) {
+    if (!logMutex) {
+        logMutex = xSemaphoreCreateMutex();  // First call happens in setup() before any task is started
+        logSessionId = esp_random();
+    }
+    xSemaphoreTake(logMutex, portMAX_DELAY);
     
-    // ALWAYS add to buffer (even if no WebSocket clients yet) - this ensures boot messages are stored
-    logBuffer[logBufferIndex] = String(message);
-    logBufferIndex = (logBufferIndex + 1) % LOG_BUFFER_SIZE;
-    if (logBufferCount < LOG_BUFFER_SIZE) logBufferCount++;
+    if (channel != LOGCH_AUTO) {
+        logLineChannel = channel;
+    }
     
-    // Send to all WebSocket clients with improved rate limiting (only if clients connected)
-    if (ws.count() > 0) {
-        unsigned long now = millis();
-        if (now - lastWebSocketSend >= WEBSOCKET_MIN_INTERVAL) {
-            // Send immediately if enough time has passed
-            ws.textAll(message);
-            lastWebSocketSend = now;
-            hasPendingMessage = false;
-        } else {
-            // Queue message if rate limit not met yet
-            pendingMessage += String(message);
-            hasPendingMessage = true;
+    for (const char* p = message; *p; ) {
+        size_t n = strcspn(p, "\n");
+        bool newline = p[n] == '\n';
+        // Untagged serialLog() lines count as LOG_INFO of the channel of their tag; the tag is at the
+        // start of the line, so decide there and drop all fragments up to the '\n'. LOG_*() and
+        // logTaggedLine() pass their channel and are filtered by the caller.
+        if (!logLineOpen && logLineChannel == LOGCH_AUTO) {
+            uint8_t lineChannel = logChannelForLine(p, n);
+            logLineDropped = LOG_LEVEL_INFO > LOG_COMPILE_LEVEL || LOG_LEVEL_INFO > logChannelLevel[lineChannel];
+        }
+        if (!logLineDropped) {
+            // Serial gets the text as is; WebSocket clients get complete lines from flushWebSocketMessages()
+            Serial.write((const uint8_t*)p, n + (newline ? 1 : 0));
+            for (size_t i = 0; i < n; i++) {
+                if (p[i] == '\r') continue;
+                logLine[logLineLen++] = p[i];
+                if (logLineLen == LOG_LINE_MAX) {
+                    logCommitLine();
+                }
+            }
+        }
+        logLineOpen = !newline;
+        if (newline) {
+            if (logLineDropped) {
+                logLineLen = 0;
+                logLineChannel = LOGCH_AUTO;
+            } else {
+                logCommitLine();
+            }
+            logLineDropped = false;
         }
+        p += n + (newline ? 1 : 0);
+    }
+    
+    xSemaphoreGive(logMutex);
+}
+
+// Untagged text (channel from the line's tag, level INFO)
+void serialLog(const char* message) {
+    logWrite(message, LOGCH_AUTO);
+}
+
+// Lines from portable code (hal::log/logWarn/logError in hal_esp32.cpp): channel from the tag,
+// filtered like LOG_INFO()/LOG_WARN()/LOG_ERROR()
+void logTaggedLine(const char* line, uint8_t level) {
+    uint8_t channel = logChannelForLine(line, strlen(line));
+    if (level <= LOG_COMPILE_LEVEL && level <= logChannelLevel[channel]) {
+        logWrite(line, channel);
     }
 }
 
-// Call this periodically to flush pending messages
+// Call this periodically to stream log lines (history and new lines) to WebSocket clients.
+// At most one chunk per client per call.
 void flushWebSocketMessages() {
-    if (hasPendingMessage && ws.count() > 0) {
-        unsigned long now = millis();
-        if (now - lastWebSocketSend >= WEBSOCKET_MIN_INTERVAL) {
-            ws.textAll(pendingMessage.c_str());
-            lastWebSocketSend = now;
-            pendingMessage = "";
-            hasPendingMessage = false;
+    if (!logMutex) {
+        return;
+    }
+    unsigned long now = millis();
+    if (now - lastWebSocketSend < WEBSOCKET_MIN_INTERVAL) {
+        return;
+    }
+    lastWebSocketSend = now;
+    
+    xSemaphoreTake(logMutex, portMAX_DELAY);
+    uint32_t lastCommitted = logNextSeq - 1;
+    for (int i = 0; i < LOG_MAX_CLIENTS; i++) {
+        LogClientCursor& cursor = logClients[i];
+        if (!cursor.active || cursor.nextSeq > lastCommitted) {
+            continue;
+        }
+        AsyncWebSocketClient* client = ws.client(cursor.clientId);
+        if (!client || client->status() != WS_CONNECTED) {
+            cursor.active = false;  // Disconnected
+            continue;
+        }
+        if (client->queueIsFull() || client->queueLen() >= LOG_CLIENT_MAX_QUEUED) {
+            logStreamDeferred++;    // Slow client: try again next time (lines stay in the ring)
+            continue;
+        }
+        uint32_t lastSeq;
+        size_t len = logBuildMessage(cursor.nextSeq, lastCommitted, cursor.channelMask, lastSeq);
+        if (len > 0) {
+            client->text(logWsBuffer, len);
+            logStreamChunks++;
         }
+        cursor.nextSeq = max(lastSeq, logFirstSeq - 1) + 1;
     }
+    xSemaphoreGive(logMutex);
 }
 
 void serialLogLn(const char* message) {
@@ -329,59 +730,345 @@ void serialLogF(const char* format, ...) {
     serialLog(buffer);
 }
 
+// Backend of LOG_ERROR/WARN/INFO/DEBUG(): one formatted line tagged with its channel
+void logChannelF(uint8_t channel, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    logWrite(buffer, channel);
+}
+
+// ========== STRUCTURED LOG EVENTS ==========
+// Hot paths (relay switching) must not wait for the UART. They call logEvent() with a format ID and
+// raw arguments; the record is copied into a lock-free ring of fixed slots and returns immediately.
+// Text is only produced when the housekeeping task drains the ring (drainLogEvents()), which feeds
+// Serial and the WebSocket log ring via serialLog().
+// String arguments are stored as pointers: pass string literals only, never String::c_str().
+enum LogFmtId : uint8_t {
+    LOGF_SWITCH_COUNT,        // switchCount, "ON"/"OFF"
+    LOGF_HEATER_SET,          // "ON"/"OFF", pin, level text
+    LOGF_HEATER_MISMATCH,     // pin, expected, got
+    LOGF_HEATER_ACTUAL,       // "ON"/"OFF", pin, level
+    LOGF_PUMP_SET,            // "ON"/"OFF", pin, level text
+    LOGF_PUMP_MISMATCH,       // pin, expected, got
+    LOGF_PUMP_ACTUAL,         // "ON"/"OFF", pin, level
+    LOGF_API_PIN_BEFORE,      // pin, level
+    LOGF_API_PIN_AFTER,       // pin, level
+    LOGF_COUNT
+};
+
+static const char* const logFormats[] = {
+    "Switch #%lu: Heater %s",
+    "[Relay] Setting heater to %s - GPIO%u: %s",
+    "[Relay] ⚠️ GPIO%u read back mismatch! Expected: %s, Got: %s",
+    "[Relay] Heater %s - GPIO%u actual: %s",
+    "[Pump] Setting pump to %s - GPIO%u: %s",
+    "[Pump] ⚠️ GPIO%u read back mismatch! Expected: %s, Got: %s",
+    "[Pump] Pump %s - GPIO%u actual: %s",
+    "[API] GPIO%d BEFORE toggle: %s",
+    "[API] GPIO%d AFTER toggle: %s",
+};
+static_assert(sizeof(logFormats) / sizeof(logFormats[0]) == LOGF_COUNT, "logFormats must match LogFmtId");
+
+#define LOG_EVENT_SLOTS 64           // Power of two
+#define LOG_EVENT_MAX_ARGS 5
+#define LOG_EVENT_DRAIN_MAX 16       // Records formatted per housekeeping tick
+
+union LogArg {
+    uint32_t u;
+    int32_t i;
+    float f;
+    const char* s;
+};
+
+// Bounded MPSC queue (Vyukov): a slot's seq equals its index when free and index+1 when published
+struct LogEventSlot {
+    std::atomic<uint32_t> seq;
+    uint8_t fmt;
+    uint8_t argc;
+    LogArg args[LOG_EVENT_MAX_ARGS];
+};
+LogEventSlot logEventSlots[LOG_EVENT_SLOTS];
+std::atomic<uint32_t> logEventWritePos(0);
+uint32_t logEventReadPos = 0;        // Only touched by the consumer
+std::atomic<uint32_t> logEventsDropped(0);
+uint32_t logEventsFormatted = 0;
+uint32_t logEventsDroppedReported = 0;
+
+void initLogEvents() {
+    for (uint32_t i = 0; i < LOG_EVENT_SLOTS; i++) {
+        logEventSlots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+static inline LogArg logArg(const char* v) { LogArg a; a.s = v; return a; }
+static inline LogArg logArg(float v) { LogArg a; a.f = v; return a; }
+static inline LogArg logArg(double v) { LogArg a; a.f = (float)v; return a; }
+static inline LogArg logArg(bool v) { LogArg a; a.u = v ? 1 : 0; return a; }
+static inline LogArg logArg(int v) { LogArg a; a.i = v; return a; }
+static inline LogArg logArg(long v) { LogArg a; a.i = (int32_t)v; return a; }
+static inline LogArg logArg(unsigned int v) { LogArg a; a.u = v; return a; }
+static inline LogArg logArg(unsigned long v) { LogArg a; a.u = (uint32_t)v; return a; }
+static inline LogArg logArg(uint8_t v) { LogArg a; a.u = v; return a; }
+
+static bool logEventPush(LogFmtId fmt, const LogArg* args, uint8_t argc) {
+    uint32_t pos = logEventWritePos.load(std::memory_order_relaxed);
+    LogEventSlot* slot;
+    for (;;) {
+        slot = &logEventSlots[pos & (LOG_EVENT_SLOTS - 1)];
+        int32_t dif = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+        if (dif == 0) {
+            if (logEventWritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            logEventsDropped.fetch_add(1, std::memory_order_relaxed);  // Full: consumer is behind
+            return false;
+        } else {
+            pos = logEventWritePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->fmt = fmt;
+    slot->argc = argc;
+    for (uint8_t i = 0; i < argc; i++) {
+        slot->args[i] = args[i];
+    }
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+// logEvent(LOGF_PUMP_SET, "ON", pin, "LOW (OUTPUT)") - arguments must match the format string
+template <typename... Args>
+bool logEvent(LogFmtId fmt, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_EVENT_MAX_ARGS, "too many log event arguments");
+    LogArg packed[sizeof...(Args) + 1] = { logArg(args)... };
+    return logEventPush(fmt, packed, sizeof...(Args));
+}
+
+// Expand one record into text. Supports %d %i %u %x %X %f %s %% with flags/width/precision and 'l'.
+static size_t logFormatEvent(const LogEventSlot& rec, char* out, size_t size) {
+    const char* f = rec.fmt < LOGF_COUNT ? logFormats[rec.fmt] : "[Log] unknown event %u";
+    size_t len = 0;
+    uint8_t argIndex = 0;
+    while (*f && len + 1 < size) {
+        if (*f != '%') {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+        char spec[16];
+        size_t specLen = 0;
+        bool isLong = false;
+        spec[specLen++] = *f++;
+        while (*f && !strchr("diuxXfs", *f) && specLen < sizeof(spec) - 2) {
+            if (*f == 'l') {
+                isLong = true;
+            } else {
+                spec[specLen++] = *f;
+            }
+            f++;
+        }
+        if (!*f) {
+            break;
+        }
+        char conv = *f++;
+        if (isLong && conv != 'f' && conv != 's') {
+            spec[specLen++] = 'l';
+        }
+        spec[specLen++] = conv;
+        spec[specLen] = '\0';
+        
+        LogArg a;
+        if (rec.fmt >= LOGF_COUNT) {
+            a.u = rec.fmt;
+        } else if (argIndex < rec.argc) {
+            a = rec.args[argIndex++];
+        } else {
+            a.u = 0;
+        }
+        int n;
+        switch (conv) {
+            case 'f': n = snprintf(out + len, size - len, spec, (double)a.f); break;
+            case 's': n = snprintf(out + len, size - len, spec, a.s ? a.s : ""); break;
+            case 'd':
+            case 'i': n = isLong ? snprintf(out + len, size - len, spec, (long)a.i)
+                                 : snprintf(out + len, size - len, spec, (int)a.i); break;
+            default:  n = isLong ? snprintf(out + len, size - len, spec, (unsigned long)a.u)
+                                 : snprintf(out + len, size - len, spec, (unsigned int)a.u); break;
+        }
+        if (n < 0) {
+            break;
+        }
+        len = min(len + (size_t)n, size - 1);
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Consumer side: format pending records into Serial and the log ring (housekeeping task, setup())
+void drainLogEvents() {
+    char line[LOG_LINE_MAX];
+    for (int n = 0; n < LOG_EVENT_DRAIN_MAX; n++) {
+        LogEventSlot& slot = logEventSlots[logEventReadPos & (LOG_EVENT_SLOTS - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != logEventReadPos + 1) {
+            break;  // Nothing published at this position yet
+        }
+        logFormatEvent(slot, line, sizeof(line));
+        slot.seq.store(logEventReadPos + LOG_EVENT_SLOTS, std::memory_order_release);
+        logEventReadPos++;
+        logEventsFormatted++;
+        serialLogLn(line);
+    }
+    
+    uint32_t dropped = logEventsDropped.load(std::memory_order_relaxed);
+    if (dropped != logEventsDroppedReported) {
+        serialLogF("[Log] %lu event(s) dropped (ring full)\n", (unsigned long)(dropped - logEventsDroppedReported));
+        logEventsDroppedReported = dropped;
+    }
+}
+
 // ========== TELEGRAM NOTIFICATIONS (FORWARD DECLARATIONS) ==========
 bool isTelegramConfigured();
 void sendTelegramMessage(String message);
 
-// ========== BEHAVIOR WARNING (FORWARD DECLARATION) ==========
-void checkUnusualBehavior();
-
 // WebSocket event handler
 void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
     if (type == WS_EVT_CONNECT) {
         serialLogF("WebSocket client #%u connected\n", client->id());
         
-        // Send complete log history to new client
-        // Send as one properly formatted message to avoid overwhelming the connection
-        if (logBufferCount > 0) {
-            String fullHistory = "";
-            for (int i = 0; i < logBufferCount; i++) {
-                int idx = (logBufferIndex - logBufferCount + i + LOG_BUFFER_SIZE) % LOG_BUFFER_SIZE;
-                String msg = logBuffer[idx];
-                if (msg.length() > 0) {
-                    // Ensure each message ends with newline
-                    if (msg.charAt(msg.length() - 1) != '\n') {
-                        fullHistory += msg + "\n";
-                    } else {
-                        fullHistory += msg;
-                    }
-                }
+        // Resume support: /ws?session=<hex>&since=<seq> only sends lines after <seq> of this boot
+        uint32_t since = 0;
+        bool resume = false;
+        uint32_t channelMask = LOGCH_ALL_MASK;
+        AsyncWebServerRequest *request = (AsyncWebServerRequest*)arg;
+        if (request && request->hasParam("since") && request->hasParam("session")) {
+            uint32_t session = strtoul(request->getParam("session")->value().c_str(), nullptr, 16);
+            if (session == logSessionId) {
+                since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+                resume = true;
             }
-            // Send entire history as one message (WebSocket handles this fine)
-            if (fullHistory.length() > 0) {
-                client->text(fullHistory);
+        }
+        if (request && request->hasParam("channels")) {
+            channelMask = logParseChannelMask(request->getParam("channels")->value().c_str());
+        }
+        
+        // Only register a cursor here; history is streamed in chunks by flushWebSocketMessages()
+        xSemaphoreTake(logMutex, portMAX_DELAY);
+        bool registered = false;
+        for (int i = 0; i < LOG_MAX_CLIENTS && !registered; i++) {
+            LogClientCursor& cursor = logClients[i];
+            if (!cursor.active || !ws.client(cursor.clientId)) {
+                cursor.clientId = client->id();
+                // A resume point that was already overwritten is reported as lost lines in the first header
+                cursor.nextSeq = resume ? since + 1 : logFirstSeq;
+                cursor.channelMask = channelMask;
+                cursor.active = true;
+                registered = true;
             }
         }
+        xSemaphoreGive(logMutex);
+        if (!registered) {
+            client->close(1013, "Too many log clients");
+        }
     } else if (type == WS_EVT_DISCONNECT) {
+        xSemaphoreTake(logMutex, portMAX_DELAY);
+        for (int i = 0; i < LOG_MAX_CLIENTS; i++) {
+            if (logClients[i].active && logClients[i].clientId == client->id()) {
+                logClients[i].active = false;
+            }
+        }
+        xSemaphoreGive(logMutex);
         serialLogF("WebSocket client #%u disconnected\n", client->id());
+    } else if (type == WS_EVT_DATA) {
+        // "channels:mysql,relay" changes the subscription (applies to lines not yet sent)
+        AwsFrameInfo *info = (AwsFrameInfo*)arg;
+        if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT && len < 128) {
+            char text[128];
+            memcpy(text, data, len);
+            text[len] = '\0';
+            if (strncmp(text, "channels:", 9) == 0) {
+                uint32_t mask = logParseChannelMask(text + 9);
+                xSemaphoreTake(logMutex, portMAX_DELAY);
+                for (int i = 0; i < LOG_MAX_CLIENTS; i++) {
+                    if (logClients[i].active && logClients[i].clientId == client->id()) {
+                        logClients[i].channelMask = mask;
+                    }
+                }
+                xSemaphoreGive(logMutex);
+            }
+        }
+    }
+}
+
+// ========== RELAY READ-BACK ==========
+// setHeater()/setPump() only record the expected pin level; the control task reads the pin once
+// the relay had RELAY_READBACK_DELAY_MS to settle, so switching never sleeps under ControlLock.
+#define RELAY_READBACK_DELAY_MS 50
+
+struct RelayReadback {
+    bool pending;
+    bool on;
+    bool expectedLow;
+    uint8_t pin;
+    unsigned long dueMs;
+};
+
+RelayReadback heaterReadback = {};
+RelayReadback pumpReadback = {};
+
+static void scheduleRelayReadback(RelayReadback& rb, uint8_t pin, bool on, bool activeLow) {
+    rb.pin = pin;
+    rb.on = on;
+    rb.expectedLow = activeLow ? on : !on;  // activeLow: ON->LOW, activeHigh: OFF->LOW
+    rb.dueMs = millis() + RELAY_READBACK_DELAY_MS;
+    rb.pending = true;
+}
+
+// Returns the pin level once the read-back is due, -1 before that
+static int relayReadbackDue(RelayReadback& rb, unsigned long now) {
+    if (!rb.pending || (long)(now - rb.dueMs) < 0) {
+        return -1;
+    }
+    rb.pending = false;
+    return digitalRead(rb.pin);
+}
+
+// Called from the control task under ControlLock
+void checkRelayReadback() {
+    unsigned long now = millis();
+    // Read-back check is best-effort (open-drain HIGH may read as HIGH or floating)
+    int actualState = relayReadbackDue(heaterReadback, now);
+    if (actualState >= 0) {
+        bool stateCorrect = heaterReadback.expectedLow ? (actualState == LOW) : (actualState != LOW);
+        if (!stateCorrect) {
+            logEvent(LOGF_HEATER_MISMATCH, heaterReadback.pin, heaterReadback.expectedLow ? "LOW" : "HIGH", actualState == LOW ? "LOW" : "HIGH");
+        }
+        logEvent(LOGF_HEATER_ACTUAL, heaterReadback.on ? "ON" : "OFF", heaterReadback.pin, actualState == LOW ? "LOW" : "HIGH");
+    }
+    actualState = relayReadbackDue(pumpReadback, now);
+    if (actualState >= 0) {
+        bool stateCorrect = pumpReadback.expectedLow ? (actualState == LOW) : (actualState != LOW);
+        if (!stateCorrect) {
+            logEvent(LOGF_PUMP_MISMATCH, pumpReadback.pin, pumpReadback.expectedLow ? "LOW" : "HIGH", actualState == LOW ? "LOW" : "HIGH");
+        }
+        logEvent(LOGF_PUMP_ACTUAL, pumpReadback.on ? "ON" : "OFF", pumpReadback.pin, actualState == LOW ? "LOW" : "HIGH");
     }
 }
 
 // ========== PUMP CONTROL (Active-Low) ==========
-void setPump(bool on, bool manualOverride = false) {
+void setPump(bool on, bool manualOverride) {
+    ControlLock lock;
     bool stateChanged = (on != state.pumpOn);
     
     if (stateChanged) {
-        // Build complete message first, then log as one message
-        String msg = "[Pump] Setting pump to ";
-        msg += (on ? "ON" : "OFF");
-        msg += " - GPIO";
-        msg += String(state.pumpRelayPin);
-        msg += ": ";
-        msg += (on ? "LOW (OUTPUT)" : "HIGH (OPEN-DRAIN)");
-        serialLogLn(msg.c_str());
-        Serial.flush();
+        logEvent(LOGF_PUMP_SET, on ? "ON" : "OFF", state.pumpRelayPin, on ? "LOW (OUTPUT)" : "HIGH (OPEN-DRAIN)");
     }
     
     state.pumpOn = on;
@@ -389,57 +1076,46 @@ void setPump(bool on, bool manualOverride = false) {
     // Apply relay output based on configured polarity/off-mode
     applyRelayOutput(state.pumpRelayPin, on, state.pumpRelayActiveLow, state.pumpRelayOffMode, "Pump");
     
-    // Verify pin state was set correctly (only log if verification fails)
-    delay(50);
-    int actualState = digitalRead(state.pumpRelayPin);
-    // Read-back check is best-effort (open-drain HIGH may read as HIGH or floating)
-    bool expectedLow = state.pumpRelayActiveLow ? on : !on; // activeLow: ON->LOW, activeHigh: OFF->LOW
-    bool stateCorrect = expectedLow ? (actualState == LOW) : (actualState != LOW);
-    
-    if (!stateCorrect && stateChanged) {
-        serialLog("[Pump] ⚠️ GPIO22 read back mismatch! Expected: ");
-        serialLog(on ? "LOW" : "HIGH");
-        serialLog(", Got: ");
-        serialLogLn(actualState == LOW ? "LOW" : "HIGH");
-    }
-    
+    // Read back the pin on a later control tick (only reported when the state changed)
     if (stateChanged) {
-        serialLog("[Pump] Pump ");
-        serialLog(on ? "ON" : "OFF");
-        serialLog(" - GPIO");
-        serialLog(String(state.pumpRelayPin).c_str());
-        serialLog(" actual: ");
-        serialLogLn(actualState == LOW ? "LOW" : "HIGH");
-        Serial.flush();
+        scheduleRelayReadback(pumpReadback, state.pumpRelayPin, on, state.pumpRelayActiveLow);
     }
 }
 
 // Forward declarations
-void saveSwitchEvents();
+bool queueSwitchRecord(const SwitchEvent& evt);
+bool queueOutboxDrain();
+bool queueStatsRefresh();
+void refreshStatsCache();
+extern volatile bool stateConfigDirty;
+bool queueDailyStatsUpload();
 void loadSwitchEvents();
 bool checkMySQLConnection();
-bool saveSwitchEventToMySQL(const SwitchEvent& evt);
+bool saveSwitchEventsBatchToMySQL(const SwitchEvent* events, int count);
 bool fetchMySQLStats(StaticJsonDocument<8192>& doc);
 bool saveDailyStatsToMySQL(); // Save today's statistics to MySQL
+void dailyStatsSample();
+void dailyStatsSwitch();
 
 // ========== RELAY CONTROL (Active-Low) ==========
-void setHeater(bool on, bool saveToNVS = true) {
+void setHeater(bool on, bool saveToNVS) {
+    ControlLock lock;
     bool stateChanged = (on != state.heatingOn);
     
     // Only count as switch if state actually changes
     if (stateChanged) {
         stats.switchCount++;
         stats.todaySwitches++;
+        dailyStatsSwitch();
         lastStateChangeTime = millis();
-        serialLogF("Switch #%lu: Heater %s\n", stats.switchCount, on ? "ON" : "OFF");
+        logEvent(LOGF_SWITCH_COUNT, stats.switchCount, on ? "ON" : "OFF");
         
         // Track switch timestamp for behavior analysis
-        switchTimestamps[switchHistoryIndex] = millis();
-        switchHistoryIndex = (switchHistoryIndex + 1) % MAX_SWITCH_HISTORY;
+        controlRecordSwitch();
         
         // Store switch event with temperatures and tank level
         struct tm timeinfo;
-        bool hasTime = getLocalTime(&timeinfo, 100);
+        bool hasTime = getLocalTime(&timeinfo, 0);  // Don't wait: called from the control task
         switchEvents[switchEventIndex].isOn = on;
         switchEvents[switchEventIndex].tempVorlauf = state.tempVorlauf;
         switchEvents[switchEventIndex].tempRuecklauf = state.tempRuecklauf;
@@ -452,17 +1128,18 @@ void setHeater(bool on, bool saveToNVS = true) {
         }
         switchEventIndex = (switchEventIndex + 1) % MAX_SWITCH_EVENTS;
         
-        // Save switch events to NVS (persist across reboots)
-        saveSwitchEvents();
+        // Hand the event to the outbound worker, which appends it to the switch journal and the
+        // LittleFS outbox (no flash I/O under ControlLock)
+        queueSwitchRecord(switchEvents[(switchEventIndex + MAX_SWITCH_EVENTS - 1) % MAX_SWITCH_EVENTS]);
         
-        // Save switch event to MySQL (optional, non-blocking)
-        saveSwitchEventToMySQL(switchEvents[(switchEventIndex + MAX_SWITCH_EVENTS - 1) % MAX_SWITCH_EVENTS]);
-        
-        // If heating turned OFF, save today's stats to MySQL
+        // If heating turned OFF, save today's stats to MySQL (queued)
         if (!on) {
-            saveDailyStatsToMySQL();
+            queueDailyStatsUpload();
         }
         
+        // Rebuild /api/stats-history in the background
+        queueStatsRefresh();
+        
         // Check for unusual behavior
         checkUnusualBehavior();
     }
@@ -476,24 +1153,14 @@ void setHeater(bool on, bool saveToNVS = true) {
         setPump(true, false);
     }
     
-    // Build complete message first, then log as one message
-    String msg = "[Relay] Setting heater to ";
-    msg += (on ? "ON" : "OFF");
-    msg += " - GPIO";
-    msg += String(state.heaterRelayPin);
-    msg += ": ";
     // Log based on expected electrical behavior
+    const char* level;
     if (state.heaterRelayActiveLow) {
-        if (on) {
-            msg += "LOW (OUTPUT)";
-        } else {
-            msg += "HIGH (OFF-MODE)";
-        }
+        level = on ? "LOW (OUTPUT)" : "HIGH (OFF-MODE)";
     } else {
-        msg += (on ? "HIGH (OUTPUT)" : "LOW (OUTPUT)");
+        level = on ? "HIGH (OUTPUT)" : "LOW (OUTPUT)";
     }
-    serialLogLn(msg.c_str());
-    Serial.flush();
+    logEvent(LOGF_HEATER_SET, on ? "ON" : "OFF", state.heaterRelayPin, level);
     
     if (on) {
         // Apply configured relay output
@@ -502,28 +1169,16 @@ void setHeater(bool on, bool saveToNVS = true) {
         if (!state.pumpOn) {
             setPump(true, false);
         }
-        lastHeatingOffTime = 0;  // Reset cooldown timer
+        state.lastHeatingOffTime = 0;  // Reset cooldown timer
     } else {
         // Apply configured relay output
         applyRelayOutput(state.heaterRelayPin, false, state.heaterRelayActiveLow, state.heaterRelayOffMode, "Heater");
         // Start cooldown timer for pump (pump will turn OFF after cooldown unless manual override)
-        lastHeatingOffTime = millis();
+        state.lastHeatingOffTime = millis();
     }
     
-    // Verify pin state was set correctly (only log if verification fails)
-    delay(50); // Longer delay for relay to respond
-    int actualState = digitalRead(state.heaterRelayPin);
-    // Read-back check is best-effort (open-drain HIGH may read as HIGH or floating)
-    bool expectedLow = state.heaterRelayActiveLow ? on : !on; // activeLow: ON->LOW, activeHigh: OFF->LOW
-    bool stateCorrect = expectedLow ? (actualState == LOW) : (actualState != LOW);
-    
-    if (!stateCorrect) {
-        serialLog("[Relay] ⚠️ GPIO23 read back mismatch! Expected: ");
-        serialLog(on ? "LOW" : "HIGH");
-        serialLog(", Got: ");
-        serialLogLn(actualState == LOW ? "LOW" : "HIGH");
-    }
-    Serial.flush();
+    // Verify pin state on a later control tick (only logs a mismatch if verification fails)
+    scheduleRelayReadback(heaterReadback, state.heaterRelayPin, on, state.heaterRelayActiveLow);
     
     if (saveToNVS && state.mode == "manual") {
         prefs.begin("heater", false);
@@ -531,16 +1186,6 @@ void setHeater(bool on, bool saveToNVS = true) {
         prefs.end();
     }
     
-    // Build complete message first, then log as one message
-    String msg2 = "[Relay] Heater ";
-    msg2 += (on ? "ON" : "OFF");
-    msg2 += " - GPIO";
-    msg2 += String(state.heaterRelayPin);
-    msg2 += " actual: ";
-    msg2 += (actualState == LOW ? "LOW" : "HIGH");
-    serialLogLn(msg2.c_str());
-    Serial.flush();
-    
     // Send Telegram notification on state change
     if (stateChanged && isTelegramConfigured()) {
         String mode = state.mode;
@@ -556,38 +1201,10 @@ void setHeater(bool on, bool saveToNVS = true) {
     }
 }
 
-// ========== CHECK FOR UNUSUAL BEHAVIOR ==========
-void checkUnusualBehavior() {
-    unsigned long now = millis();
-    int switchCountInWindow = 0;
-    
-    // Count switches in the last WARNING_TIME_WINDOW_MS
-    for (int i = 0; i < MAX_SWITCH_HISTORY; i++) {
-        if (switchTimestamps[i] > 0 && (now - switchTimestamps[i]) < WARNING_TIME_WINDOW_MS) {
-            switchCountInWindow++;
-        }
-    }
-    
-    // Check if we exceed the threshold
-    bool shouldWarn = (switchCountInWindow >= WARNING_THRESHOLD_SWITCHES);
-    
-    if (shouldWarn && !behaviorWarningActive) {
-        behaviorWarningActive = true;
-        lastBehaviorWarningTime = now;
-        
-        Serial.printf("⚠️ WARNUNG: Ungewöhnliches Verhalten erkannt! %d Schaltungen in den letzten 15 Minuten.\n", switchCountInWindow);
-        
-        // Send Telegram warning if configured
-        if (isTelegramConfigured()) {
-            String msg = "⚠️ WARNUNG: Ungewöhnliches Verhalten!\n";
-            msg += String(switchCountInWindow) + " Schaltungen in den letzten 15 Minuten.\n";
-            msg += "Bitte Heizungsanlage prüfen!";
-            sendTelegramMessage(msg);
-        }
-    } else if (!shouldWarn && behaviorWarningActive) {
-        // Clear warning if behavior normalized
-        behaviorWarningActive = false;
-        Serial.println("✅ Verhalten normalisiert - Warnung aufgehoben");
+// Notifications from the control logic (control.cpp)
+void controlNotify(const char* message) {
+    if (isTelegramConfigured()) {
+        sendTelegramMessage(message);
     }
 }
 
@@ -604,7 +1221,7 @@ void updateStatistics() {
     
     // Reset daily counter at midnight
     struct tm timeinfo;
-    if (getLocalTime(&timeinfo, 100)) {
+    if (getLocalTime(&timeinfo, 0)) {
         unsigned long currentDay = timeinfo.tm_yday;  // Day of year
         if (stats.lastResetDay != currentDay) {
             stats.todaySwitches = 0;
@@ -612,13 +1229,39 @@ void updateStatistics() {
             Serial.println("Daily statistics reset");
         }
     }
+    
+    // Per-day accumulators (mean/variance/min/max, exact ON/OFF time)
+    dailyStatsSample();
 }
 
 // ========== READ TANK LEVEL (JSN-SR04T) ==========
-float readTankDistance() {
+void IRAM_ATTR onEchoEdge() {
+    uint32_t nowUs = micros();
+    echoEdgeCount++;
+    uint8_t captureState = echoCaptureState;
+    if (digitalRead(ECHO_PIN) == HIGH) {
+        if (captureState == ECHO_ARMED) {
+            echoRiseUs = nowUs;
+            echoCaptureState = ECHO_HIGH;
+        }
+    } else if (captureState == ECHO_HIGH) {
+        echoFallUs = nowUs;
+        echoCaptureState = ECHO_DONE;  // Publish sample (timestamps written first)
+    }
+}
+
+// Send a 10us TRIG pulse and arm the echo capture. Returns immediately.
+void triggerTankPing() {
+    if (tankPingPending) {
+        return;  // Previous ping not consumed yet
+    }
+    
     // Capture idle state before triggering (helps diagnose wiring/floating pins)
     lastEchoBefore = digitalRead(ECHO_PIN);
-
+    
+    // Arm before triggering so the rising edge cannot be missed
+    echoCaptureState = ECHO_ARMED;
+    
     // Send 10us pulse to TRIG
     digitalWrite(TRIG_PIN, LOW);
     delayMicroseconds(2);
@@ -626,18 +1269,41 @@ float readTankDistance() {
     delayMicroseconds(10);
     digitalWrite(TRIG_PIN, LOW);
     
-    // Read ECHO pulse duration (timeout after 30ms)
-    long duration = pulseIn(ECHO_PIN, HIGH, ULTRASONIC_TIMEOUT);
-    lastUltrasonicDurationUs = (unsigned long)duration;
-    lastEchoAfter = digitalRead(ECHO_PIN);
+    tankPingStartUs = micros();
+    tankPingPending = true;
+}
+
+// Consume the result of the last ping.
+// Returns false while the ping is still in flight, true once a result is available:
+// distanceCm is then the measured distance, or -1.0 on timeout / out-of-range.
+bool readTankDistance(float& distanceCm) {
+    if (!tankPingPending) {
+        return false;
+    }
     
-    // No echo received = sensor error
-    if (duration == 0) {
+    if (echoCaptureState != ECHO_DONE) {
+        if (micros() - tankPingStartUs < ULTRASONIC_TIMEOUT) {
+            return false;  // Still waiting for the echo
+        }
+        // No echo received within timeout = sensor error
+        echoCaptureState = ECHO_IDLE;
+        tankPingPending = false;
+        lastUltrasonicDurationUs = 0;
+        lastEchoDelayUs = -1;
+        lastEchoAfter = digitalRead(ECHO_PIN);
         lastTankErrorCode = 1;
         lastUltrasonicDistanceCm = -1.0f;
-        return -1.0;
+        distanceCm = -1.0f;
+        return true;
     }
     
+    uint32_t duration = echoFallUs - echoRiseUs;
+    lastEchoDelayUs = (long)(echoRiseUs - tankPingStartUs);
+    echoCaptureState = ECHO_IDLE;
+    tankPingPending = false;
+    lastUltrasonicDurationUs = duration;
+    lastEchoAfter = digitalRead(ECHO_PIN);
+    
     // Calculate distance in cm (speed of sound: 343 m/s = 0.0343 cm/us)
     // Distance = (duration / 2) * 0.0343
     float distance = (duration * 0.0343) / 2.0;
@@ -646,16 +1312,65 @@ float readTankDistance() {
     if (distance < 2.0 || distance > 500.0) {
         lastTankErrorCode = 2;
         lastUltrasonicDistanceCm = distance;
-        return -1.0;
+        distanceCm = -1.0f;
+        return true;
     }
     
     lastTankErrorCode = 0;
     lastUltrasonicDistanceCm = distance;
-    return distance;
+    distanceCm = distance;
+    return true;
+}
+
+// Start a new burst of pings (first ping is sent immediately)
+void startTankBurst() {
+    if (tankBurstActive) {
+        return;
+    }
+    tankBurstCount = 0;
+    tankBurstActive = true;
+    tankBurstLastPingMs = millis();
+    triggerTankPing();
+}
+
+// Collect echoes of the running burst and send the next ping once the spacing has elapsed.
+// Returns true when the burst is complete and tankBurst[] holds TANK_BURST_SAMPLES samples.
+bool serviceTankBurst() {
+    if (!tankBurstActive) {
+        return false;
+    }
+    
+    float distance;
+    if (readTankDistance(distance)) {
+        tankBurst[tankBurstCount % TANK_BURST_SAMPLES] = (distance < 0) ? NAN : distance;
+        tankBurstCount++;
+        if (tankBurstCount >= TANK_BURST_SAMPLES) {
+            tankBurstActive = false;
+            return true;
+        }
+    }
+    
+    if (!tankPingPending && (millis() - tankBurstLastPingMs) >= TANK_BURST_SPACING_MS) {
+        tankBurstLastPingMs = millis();
+        triggerTankPing();
+    }
+    return false;
 }
 
 void updateTankLevel() {
-    float distance = readTankDistance();
+    if (!serviceTankBurst()) {
+        return;  // Burst still running (or not started)
+    }
+    
+    int confidence = 0;
+    TankBurstDiag diag;
+    float distance = filterTankBurst(tankBurst, confidence, diag);
+    state.tankConfidence = confidence;
+    {
+        MutexLock lock(tankBurstMutex);
+        memcpy(lastBurst.samples, tankBurst, sizeof(lastBurst.samples));
+        lastBurst.diag = diag;
+    }
     
     if (distance < 0) {
         // Sensor error / missed echo: don't immediately flip to "unavailable" because JSN-SR04T can miss pulses.
@@ -796,6 +1511,19 @@ void doFetchWeatherData(bool forceRefresh = false) {
         DeserializationError error = deserializeJson(doc, payload);
         
         if (!error) {
+            // Fetch location name outside the lock (always fetch if forceRefresh is true or not already set)
+            bool refreshName;
+            {
+                MutexLock lock(weatherMutex);
+                refreshName = forceRefresh || weather.locationName == "" || weather.locationName == "Unbekannter Ort";
+            }
+            String newLocationName;
+            if (refreshName) {
+                newLocationName = fetchLocationName(state.latitude, state.longitude);
+            }
+            
+            MutexLock lock(weatherMutex);
+            
             // Current weather
             weather.temperature = doc["current"]["temperature_2m"];
             weather.weatherCode = doc["current"]["weather_code"];
@@ -812,20 +1540,19 @@ void doFetchWeatherData(bool forceRefresh = false) {
             weather.lastUpdate = millis();
             lastWeatherFetch = millis();
             
-            // Fetch location name (always fetch if forceRefresh is true or not already set)
-            if (forceRefresh || weather.locationName == "" || weather.locationName == "Unbekannter Ort") {
-                weather.locationName = fetchLocationName(state.latitude, state.longitude);
+            if (refreshName) {
+                weather.locationName = newLocationName;
             }
             
             // Silent success (no logging to reduce WebSocket spam)
         } else {
-            serialLog("[Weather] ❌ JSON parse error: ");
-            serialLogLn(error.c_str());
+            LOG_ERROR(LOGCH_WEATHER, "[Weather] ❌ JSON parse error: %s\n", error.c_str());
+            MutexLock lock(weatherMutex);
             weather.valid = false;
         }
     } else {
-        serialLog("[Weather] ❌ HTTP error: ");
-        serialLogLn(String(httpCode).c_str());
+        LOG_WARN(LOGCH_WEATHER, "[Weather] ❌ HTTP error: %d\n", httpCode);
+        MutexLock lock(weatherMutex);
         weather.valid = false;
     }
     
@@ -872,19 +1599,14 @@ bool isTelegramConfigured() {
             String(TELEGRAM_BOT_TOKEN).length() > 10);
 }
 
-void sendTelegramMessage(String message) {
-    if (!isTelegramConfigured()) {
-        serialLogLn("[Telegram] Not configured, skipping notification");
-        return;
-    }
-    
+// Actually send a message (runs on the outbound worker). Returns false on failure so the job is retried.
+bool deliverTelegramMessage(String message) {
     if (WiFi.status() != WL_CONNECTED) {
-        serialLogLn("[Telegram] WiFi not connected, skipping notification");
-        return;
+        LOG_WARN(LOGCH_TELEGRAM, "[Telegram] WiFi not connected, will retry\n");
+        return false;
     }
     
-    serialLog("[Telegram] Sending: ");
-    serialLogLn(message.c_str());
+    LOG_DEBUG(LOGCH_TELEGRAM, "[Telegram] Sending: %s\n", message.c_str());
     
     HTTPClient http;
     
@@ -908,13 +1630,13 @@ void sendTelegramMessage(String message) {
     int httpCode = http.POST(payload);
     
     if (httpCode == HTTP_CODE_OK) {
-        serialLogLn("[Telegram] ✅ Message sent successfully");
+        LOG_INFO(LOGCH_TELEGRAM, "[Telegram] ✅ Message sent successfully\n");
     } else {
-        serialLog("[Telegram] ❌ Error: ");
-        serialLogLn(String(httpCode).c_str());
+        LOG_ERROR(LOGCH_TELEGRAM, "[Telegram] ❌ Error: %d\n", httpCode);
     }
     
     http.end();
+    return httpCode == HTTP_CODE_OK;
 }
 
 // ========== INITIALIZE TEMPERATURE SENSORS ==========
@@ -927,6 +1649,8 @@ void initSensors() {
         sensors = new DallasTemperature(oneWire);
     }
     sensors->begin();
+    // Non-blocking conversions: requestTemperatures() returns immediately, results are collected later
+    sensors->setWaitForConversion(false);
     
     // Wait a bit for sensors to stabilize
     delay(100);
@@ -978,11 +1702,63 @@ void initSensors() {
 }
 
 // ========== TEMPERATURE READING ==========
-void readTemperatures() {
+static bool isValidSensorResolution(int bits) {
+    return bits >= 9 && bits <= 12;
+}
+
+// Write the configured resolution into each sensor's scratchpad.
+// Only called while no conversion is running (changing resolution mid-conversion corrupts the result).
+static void applySensorResolutions() {
     if (!sensors) {
         return;
     }
+    if (sensor1Found) {
+        sensors->setResolution(sensor1Address, state.sensor1Resolution);
+    }
+    if (sensor2Found) {
+        sensors->setResolution(sensor2Address, state.sensor2Resolution);
+    }
+    sensorResolutionDirty = false;
+    serialLogF("[Sensor] Resolution: Vorlauf %u bit, Rücklauf %u bit\n",
+               state.sensor1Resolution, state.sensor2Resolution);
+}
+
+// Conversion time for the slowest configured sensor (all sensors convert in parallel)
+static unsigned long tempConversionTimeMs() {
+    int16_t waitMs = 0;
+    if (sensor1Found) {
+        waitMs = max(waitMs, sensors->millisToWaitForConversion(state.sensor1Resolution));
+    }
+    if (sensor2Found) {
+        waitMs = max(waitMs, sensors->millisToWaitForConversion(state.sensor2Resolution));
+    }
+    return (unsigned long)waitMs;
+}
+
+// Start a conversion on all sensors and return immediately
+void startTemperatureConversion() {
+    if (!sensors || tempPhase != TEMP_IDLE) {
+        return;
+    }
+    if (sensorResolutionDirty) {
+        applySensorResolutions();
+    }
     sensors->requestTemperatures();
+    tempConversionStartMs = millis();
+    tempConversionWaitMs = tempConversionTimeMs();
+    tempPhase = TEMP_CONVERTING;
+}
+
+// Collect results once the conversion deadline has passed.
+// Returns true when new values were stored in state (caller runs control logic), false while still converting.
+bool collectTemperatures() {
+    if (!sensors || tempPhase != TEMP_CONVERTING) {
+        return false;
+    }
+    if (millis() - tempConversionStartMs < tempConversionWaitMs) {
+        return false;
+    }
+    tempPhase = TEMP_IDLE;
     
     // Read sensor 1 (Vorlauf)
     if (sensor1Found) {
@@ -990,11 +1766,11 @@ void readTemperatures() {
         if (temp != DEVICE_DISCONNECTED_C && temp >= -55.0 && temp <= 125.0) {
             state.tempVorlauf = temp;
         } else {
-            Serial.printf("[Sensor] Sensor 1 read error: %.2f°C (disconnected: %d)\n", temp, (temp == DEVICE_DISCONNECTED_C));
+            LOG_WARN(LOGCH_SENSOR, "[Sensor] Sensor 1 read error: %.2f°C (disconnected: %d)\n", temp, (temp == DEVICE_DISCONNECTED_C));
             state.tempVorlauf = NAN;
         }
     } else {
-        Serial.println("[Sensor] Sensor 1 not found!");
+        LOG_DEBUG(LOGCH_SENSOR, "[Sensor] Sensor 1 not found!\n");
         state.tempVorlauf = NAN;
     }
     
@@ -1004,22 +1780,38 @@ void readTemperatures() {
         if (temp != DEVICE_DISCONNECTED_C && temp >= -55.0 && temp <= 125.0) {
             state.tempRuecklauf = temp;
         } else {
-            Serial.printf("[Sensor] Sensor 2 read error: %.2f°C (disconnected: %d)\n", temp, (temp == DEVICE_DISCONNECTED_C));
+            LOG_WARN(LOGCH_SENSOR, "[Sensor] Sensor 2 read error: %.2f°C (disconnected: %d)\n", temp, (temp == DEVICE_DISCONNECTED_C));
             state.tempRuecklauf = NAN;
         }
     } else if (sensor1Found) {
         // Fallback: If only one sensor, use it for both
         state.tempRuecklauf = state.tempVorlauf;
     } else {
-        Serial.println("[Sensor] Sensor 2 not found!");
+        LOG_DEBUG(LOGCH_SENSOR, "[Sensor] Sensor 2 not found!\n");
         state.tempRuecklauf = NAN;
     }
+    return true;
+}
+
+// Blocking read (start + wait + collect). Only used during setup() where a stall is acceptable.
+void readTemperatures() {
+    if (!sensors) {
+        return;
+    }
+    if (tempPhase == TEMP_IDLE) {
+        startTemperatureConversion();
+    }
+    unsigned long elapsed = millis() - tempConversionStartMs;
+    if (elapsed < tempConversionWaitMs) {
+        delay(tempConversionWaitMs - elapsed);
+    }
+    collectTemperatures();
 }
 
 // ========== GET CURRENT TIME ==========
 bool getCurrentTime(int &hour, int &minute) {
     struct tm timeinfo;
-    if (!getLocalTime(&timeinfo, 100)) {
+    if (!getLocalTime(&timeinfo, 0)) {
         return false;
     }
     hour = timeinfo.tm_hour;
@@ -1066,144 +1858,12 @@ void scheduleControl() {
     bool shouldBeOn = isInSchedule();
     
     if (shouldBeOn != state.heatingOn) {
-        Serial.printf("SCHEDULE: Should be %s, turning heater %s\n", 
-                     shouldBeOn ? "ON" : "OFF", shouldBeOn ? "ON" : "OFF");
+        LOG_INFO(LOGCH_CONTROL, "SCHEDULE: Should be %s, turning heater %s\n", 
+                 shouldBeOn ? "ON" : "OFF", shouldBeOn ? "ON" : "OFF");
         setHeater(shouldBeOn, false);
     }
 }
 
-// ========== FROST PROTECTION ==========
-void frostProtection() {
-    if (!state.frostProtectionEnabled) {
-        return;
-    }
-    
-    // Use the lower temperature (usually Rücklauf)
-    float checkTemp = state.tempRuecklauf;
-    if (isnan(checkTemp) && !isnan(state.tempVorlauf)) {
-        checkTemp = state.tempVorlauf;
-    }
-    
-    if (isnan(checkTemp)) {
-        return;  // No valid temperature
-    }
-    
-    // Turn ON if below frost protection temperature
-    if (checkTemp < state.frostProtectionTemp && !state.heatingOn) {
-        Serial.printf("FROST: Temperature %.1f°C < %.1f°C, turning heater ON\n", 
-                     checkTemp, state.frostProtectionTemp);
-        setHeater(true, false);
-    }
-    // Turn OFF if 2°C above frost protection (hysteresis)
-    else if (checkTemp > (state.frostProtectionTemp + 2.0) && state.heatingOn) {
-        Serial.printf("FROST: Temperature %.1f°C safe, turning heater OFF\n", checkTemp);
-        setHeater(false, false);
-    }
-}
-
-// ========== AUTOMATIC CONTROL WITH HYSTERESIS ==========
-void automaticControl() {
-    if (state.mode != "auto") {
-        return;
-    }
-    
-    // Use Rücklauf temperature for control
-    if (isnan(state.tempRuecklauf)) {
-        return;
-    }
-    
-    // Hysteresis logic (like W1209)
-    // Turn ON if below EIN temperature
-    if (state.tempRuecklauf <= state.tempOn && !state.heatingOn) {
-        Serial.printf("AUTO: Rücklauf %.1f°C <= %.1f°C, turning heater ON\n", 
-                     state.tempRuecklauf, state.tempOn);
-        setHeater(true, false);
-    } 
-    // Turn OFF if above AUS temperature
-    else if (state.tempRuecklauf >= state.tempOff && state.heatingOn) {
-        Serial.printf("AUTO: Rücklauf %.1f°C >= %.1f°C, turning heater OFF\n", 
-                     state.tempRuecklauf, state.tempOff);
-        setHeater(false, false);
-    }
-    // Between EIN and AUS: maintain current state (hysteresis zone)
-}
-
-// ========== PUMP COOLDOWN LOGIC ==========
-void handlePumpCooldown() {
-    // Only handle cooldown if heating is OFF and we're not in manual mode with manual pump override
-    if (state.heatingOn) {
-        return;  // Heating is ON, pump should be ON (handled by setHeater)
-    }
-    
-    // In manual mode: if pumpManualMode is true, keep pump ON regardless of heating state
-    if (state.mode == "manual" && state.pumpManualMode) {
-        if (!state.pumpOn) {
-            setPump(true, true);  // Turn pump ON due to manual override
-        }
-        return;
-    }
-    
-    // Check if cooldown period has elapsed
-    if (lastHeatingOffTime > 0 && state.pumpOn) {
-        unsigned long elapsed = millis() - lastHeatingOffTime;
-        
-        // After cooldown period, turn pump OFF (unless manual override in manual mode)
-        if (elapsed >= PUMP_COOLDOWN_MS) {
-            if (!(state.mode == "manual" && state.pumpManualMode)) {
-                serialLogF("[Pump] Cooldown period (%lu seconds) elapsed, turning pump OFF\n", PUMP_COOLDOWN_MS / 1000);
-                setPump(false, false);
-                lastHeatingOffTime = 0;  // Reset timer
-            }
-        } else {
-            // Still in cooldown period
-            unsigned long remaining = (PUMP_COOLDOWN_MS - elapsed) / 1000;
-            // Only log every 30 seconds to avoid spam
-            static unsigned long lastCooldownLog = 0;
-            if (millis() - lastCooldownLog > 30000) {
-                serialLogF("[Pump] Cooldown: %lu seconds remaining\n", remaining);
-                lastCooldownLog = millis();
-            }
-        }
-    }
-}
-
-// ========== FAILSAFE CHECK ==========
-void checkFailsafe() {
-    // If both sensors fail, turn off both heating and pump
-    if (isnan(state.tempVorlauf) && isnan(state.tempRuecklauf)) {
-        if (state.heatingOn) {
-            Serial.println("FAILSAFE: All sensors failed, turning heater OFF");
-            setHeater(false);
-        }
-        // If user explicitly enabled manual pump override in manual mode, don't fight it.
-        // Otherwise, turn pump OFF for safety to avoid oscillation with cooldown/manual logic.
-        if (state.pumpOn && !(state.mode == "manual" && state.pumpManualMode)) {
-            Serial.println("FAILSAFE: All sensors failed, turning pump OFF");
-            setPump(false, false);
-        }
-        
-        // Send Telegram notification once
-        if (!sensorErrorNotified && isTelegramConfigured()) {
-            sendTelegramMessage("⚠️ SENSOR-FEHLER!\n\nBeide Temperatursensoren ausgefallen.\nHeizung und Pumpe wurden automatisch deaktiviert.");
-            sensorErrorNotified = true;
-        }
-    } else {
-        // Reset flag when sensors are working again
-        if (sensorErrorNotified) {
-            if (isTelegramConfigured()) {
-                sendTelegramMessage("✅ Sensoren wieder OK\n\n🌡️ Vorlauf: " + String(state.tempVorlauf, 1) + "°C");
-            }
-            sensorErrorNotified = false;
-        }
-    }
-    
-    // CRITICAL SAFETY CHECK: Ensure heating is never ON without pump
-    if (state.heatingOn && !state.pumpOn) {
-        serialLogLn("[FAILSAFE] ⚠️ CRITICAL: Heating ON but pump OFF - forcing pump ON!");
-        setPump(true, false);
-    }
-}
-
 // ========== LOAD SETTINGS FROM NVS ==========
 void loadSettings() {
     prefs.begin("heater", true);
@@ -1212,11 +1872,19 @@ void loadSettings() {
     state.pumpOn = prefs.getBool("pumpOn", false);
     state.pumpManualMode = prefs.getBool("pumpManualMode", false);
     state.mode = prefs.getString("mode", "manual");
+    state.controlMode = controlModeFromName(state.mode.c_str());
     state.tempOn = prefs.getFloat("tempOn", 30.0);
     state.tempOff = prefs.getFloat("tempOff", 40.0);
     state.frostProtectionEnabled = prefs.getBool("frostEnabled", false);
     state.frostProtectionTemp = prefs.getFloat("frostTemp", 8.0);
     
+    // Load DS18B20 resolution (fall back to default if invalid)
+    uint8_t s1Res = prefs.getUChar("s1Res", TEMP_DEFAULT_RESOLUTION);
+    uint8_t s2Res = prefs.getUChar("s2Res", TEMP_DEFAULT_RESOLUTION);
+    state.sensor1Resolution = isValidSensorResolution(s1Res) ? s1Res : TEMP_DEFAULT_RESOLUTION;
+    state.sensor2Resolution = isValidSensorResolution(s2Res) ? s2Res : TEMP_DEFAULT_RESOLUTION;
+    sensorResolutionDirty = true;  // Applied before the next conversion starts
+    
     // Load tank configuration
     state.tankHeight = prefs.getFloat("tankHeight", 100.0);
     state.tankCapacity = prefs.getFloat("tankCapacity", 1000.0);
@@ -1295,383 +1963,1326 @@ void loadSettings() {
     }
 }
 
+// ========== DATA PARTITION (LittleFS "userdata") ==========
+// Local history (switch journal, outbox, time series, daily checkpoint) lives on its own LittleFS
+// partition (partitions.csv), mounted at /data. The asset partition ("spiffs") is replaced as a whole
+// by "pio run -t uploadfs" and by /update-fs; the data partition is never written by an image, so
+// frontend updates keep the history. Boards still running the old partition table (only updated
+// over the air since) have no data partition: dataFs then stays on the asset partition, and a UI
+// update erases the history there (logged at boot, shown as storage.dataPartition in /api/tasks).
+#define DATA_PARTITION_LABEL "userdata"
+#define DATA_PARTITION_BASE_PATH "/data"
+
+fs::LittleFSFS DataFS;
+fs::LittleFSFS* dataFs = &LittleFS;    // Where the history files live
+bool dataPartitionMounted = false;
+
+// Called from setup() after the asset partition; returns false if no filesystem is available for history
+bool initDataPartition(bool assetsMounted) {
+    // Format on first mount (a freshly flashed partition table leaves it blank), but only if the partition
+    // exists: formatting a missing label is what crashes esp_littlefs_format_partition() (see setup())
+    bool present = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+                                            DATA_PARTITION_LABEL) != nullptr;
+    if (present && DataFS.begin(true, DATA_PARTITION_BASE_PATH, 10, DATA_PARTITION_LABEL)) {
+        dataFs = &DataFS;
+        dataPartitionMounted = true;
+        LOG_INFO(LOGCH_STORAGE, "[Storage] Data partition '%s' mounted (%lu of %lu bytes used)\n", DATA_PARTITION_LABEL,
+                 (unsigned long)DataFS.usedBytes(), (unsigned long)DataFS.totalBytes());
+        return true;
+    }
+    LOG_WARN(LOGCH_STORAGE, "[Storage] ⚠️ %s '%s': history is kept on the asset partition and erased by uploadfs "
+             "or /update-fs\n", present ? "Cannot mount" : "Old partition table (flash once over USB), no", DATA_PARTITION_LABEL);
+    return assetsMounted;
+}
+
 // ========== SWITCH EVENTS PERSISTENCE ==========
-void saveSwitchEvents() {
-    prefs.begin("switchevts", false);
+// Local switch history (switchEvents[]) is persisted as an append-only journal on the data partition: every
+// switch appends one fixed-size, CRC-protected record instead of rewriting the whole ring in NVS.
+// LittleFS spreads the writes over the partition (copy-on-write blocks), so short cycling no longer
+// hammers the same NVS pages. When the journal reaches SWITCH_JOURNAL_MAX_RECORDS it is compacted to
+// the newest MAX_SWITCH_EVENTS records (written to a temp file, then renamed over it). At boot the journal is
+// replayed into switchEvents[]; records with a bad CRC (torn write on power loss) are skipped and
+// dropped by the next compaction. The NVS blob is kept as a backup (refreshed on every compaction):
+// it refills the journal if the file is gone and is the only store without any filesystem.
+// Appends and runtime compaction run on the outbound worker (setHeater() only queues the event), so
+// they work on the journal file alone and never read switchEvents[] without the control lock.
+#define SWITCH_JOURNAL_PATH "/switchevents.jnl"
+#define SWITCH_JOURNAL_TMP_PATH "/switchevents.tmp"
+#define SWITCH_JOURNAL_MAGIC 0x314A4553UL   // "SEJ1"
+#define SWITCH_JOURNAL_MAX_RECORDS (MAX_SWITCH_EVENTS * 4)
+
+struct SwitchJournalRecord {
+    uint32_t magic;
+    uint32_t seq;              // Monotonic, used to order records on replay
+    uint32_t timestamp;        // Unix time, 0 = no NTP at switch time
+    uint32_t uptimeMs;
+    float tempVorlauf;
+    float tempRuecklauf;
+    float tankLiters;
+    uint8_t isOn;
+    uint8_t reserved[3];
+    uint32_t crc;              // CRC32 over all preceding bytes
+};
+static_assert(sizeof(SwitchJournalRecord) == 36, "SwitchJournalRecord layout is stored on flash");
+
+bool switchJournalReady = false;       // Data partition (or fallback) mounted
+uint32_t switchJournalNextSeq = 1;
+uint32_t switchJournalRecords = 0;     // Records in the file (including superseded ones)
+
+struct SwitchJournalStats {
+    uint32_t appended = 0;
+    uint32_t compactions = 0;
+    uint32_t corrupt = 0;              // Skipped on replay
+    uint32_t writeErrors = 0;
+    uint32_t lastAppendUs = 0;
+    uint32_t maxAppendUs = 0;
+    uint32_t replayMs = 0;
+} switchJournalStats;
+
+static uint32_t switchJournalCrc(const SwitchJournalRecord& rec) {
+    return crc32_le(0, (const uint8_t*)&rec, offsetof(SwitchJournalRecord, crc));
+}
+
+static bool switchJournalValid(const SwitchJournalRecord& rec) {
+    return rec.magic == SWITCH_JOURNAL_MAGIC && rec.crc == switchJournalCrc(rec);
+}
+
+static void switchJournalEncode(const SwitchEvent& evt, SwitchJournalRecord& rec) {
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = SWITCH_JOURNAL_MAGIC;
+    rec.seq = switchJournalNextSeq++;
+    rec.timestamp = (uint32_t)evt.timestamp;
+    rec.uptimeMs = (uint32_t)evt.uptimeMs;
+    rec.tempVorlauf = evt.tempVorlauf;
+    rec.tempRuecklauf = evt.tempRuecklauf;
+    rec.tankLiters = evt.tankLiters;
+    rec.isOn = evt.isOn ? 1 : 0;
+    rec.crc = switchJournalCrc(rec);
+}
+
+// Move a completely written temp file over the journal
+static bool switchJournalInstall(bool written, uint32_t count) {
+    // LittleFS rename replaces the journal atomically: a power cut leaves either the old or the new file
+    if (!written || !dataFs->rename(SWITCH_JOURNAL_TMP_PATH, SWITCH_JOURNAL_PATH)) {
+        dataFs->remove(SWITCH_JOURNAL_TMP_PATH);
+        switchJournalStats.writeErrors++;
+        return false;
+    }
+    switchJournalRecords = count;
+    switchJournalStats.compactions++;
+    return true;
+}
+
+// Rewrite the journal from switchEvents[] (newest MAX_SWITCH_EVENTS records only); setup() only
+static bool switchJournalCompact() {
+    File f = dataFs->open(SWITCH_JOURNAL_TMP_PATH, FILE_WRITE);
+    if (!f) {
+        switchJournalStats.writeErrors++;
+        return false;
+    }
+    bool ok = true;
+    int count = 0;
+    SwitchEventCursor cursor;
+    for (const SwitchEvent* evt = cursor.next(); evt != nullptr && ok; evt = cursor.next()) {
+        SwitchJournalRecord rec;
+        switchJournalEncode(*evt, rec);
+        ok = f.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec);
+        count++;
+    }
+    f.close();
+    return switchJournalInstall(ok, count);
+}
+
+// Runtime compaction: keep the newest MAX_SWITCH_EVENTS valid records of the journal file itself
+static bool switchJournalTrim() {
+    File src = dataFs->open(SWITCH_JOURNAL_PATH, FILE_READ);
+    if (!src) {
+        return false;
+    }
+    uint32_t valid = 0;
+    SwitchJournalRecord rec;
+    while (src.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+        if (switchJournalValid(rec)) valid++;
+    }
+    File dst = dataFs->open(SWITCH_JOURNAL_TMP_PATH, FILE_WRITE);
+    if (!dst || !src.seek(0)) {
+        src.close();
+        if (dst) dst.close();
+        return switchJournalInstall(false, 0);
+    }
+    uint32_t skip = valid > MAX_SWITCH_EVENTS ? valid - MAX_SWITCH_EVENTS : 0;
+    uint32_t kept = 0;
+    bool ok = true;
+    while (ok && src.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+        if (!switchJournalValid(rec)) {
+            continue;
+        }
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        ok = dst.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec);
+        kept++;
+    }
+    src.close();
+    dst.close();
+    return switchJournalInstall(ok, kept);
+}
+
+// Called from setup() after initDataPartition()
+void initSwitchJournal() {
+    switchJournalReady = true;
+}
+
+// Backup (and only storage without a filesystem): whole ring as one NVS blob
+static void saveSwitchEventsToNVS() {
+    // Snapshot under the control lock, write to NVS outside of it (own handle: runs on the worker)
+    static SwitchEvent snapshot[MAX_SWITCH_EVENTS];
+    uint8_t index;
+    {
+        ControlLock lock;
+        for (int i = 0; i < MAX_SWITCH_EVENTS; i++) {
+            snapshot[i] = switchEvents[i];
+        }
+        index = switchEventIndex;
+    }
+    Preferences nvs;
+    nvs.begin("switchevts", false);
     // Save current index
-    prefs.putUChar("idx", switchEventIndex);
+    nvs.putUChar("idx", index);
     // Save all events (as binary blob)
-    size_t dataSize = MAX_SWITCH_EVENTS * sizeof(SwitchEvent);
-    prefs.putBytes("events", switchEvents, dataSize);
-    prefs.end();
+    nvs.putBytes("events", snapshot, sizeof(snapshot));
+    nvs.end();
 }
 
-void loadSwitchEvents() {
+static bool loadSwitchEventsFromNVS() {
+    bool loaded = false;
     prefs.begin("switchevts", true);
     if (prefs.isKey("idx") && prefs.isKey("events")) {
-        switchEventIndex = prefs.getUChar("idx", 0);
         size_t dataSize = MAX_SWITCH_EVENTS * sizeof(SwitchEvent);
         size_t storedSize = prefs.getBytesLength("events");
         if (storedSize == dataSize) {
+            switchEventIndex = prefs.getUChar("idx", 0) % MAX_SWITCH_EVENTS;
             prefs.getBytes("events", switchEvents, dataSize);
-            serialLogF("[SwitchEvents] Loaded %d events from NVS\n", MAX_SWITCH_EVENTS);
+            loaded = true;
         } else {
             serialLogF("[SwitchEvents] Size mismatch: expected %d, got %d\n", dataSize, storedSize);
         }
-    } else {
-        // First run: initialize with zeros
-        memset(switchEvents, 0, sizeof(switchEvents));
-        switchEventIndex = 0;
-        serialLogLn("[SwitchEvents] No saved events, initialized empty");
     }
     prefs.end();
+    return loaded;
 }
 
-// ========== MYSQL INTEGRATION (OPTIONAL) ==========
-bool checkMySQLConnection() {
-    if (strlen(MYSQL_API_URL) == 0) {
-        state.mysqlConnected = false;
-        return false;
+// Persist one switch event handed over by setHeater(); runs on the outbound worker (persistSwitchRecords())
+void saveSwitchEvent(const SwitchEvent& evt) {
+    if (!switchJournalReady) {
+        saveSwitchEventsToNVS();
+        return;
     }
     
-    if (WiFi.status() != WL_CONNECTED) {
-        state.mysqlConnected = false;
-        return false;
+    int64_t startUs = esp_timer_get_time();
+    SwitchJournalRecord rec;
+    switchJournalEncode(evt, rec);
+    File f = dataFs->open(SWITCH_JOURNAL_PATH, FILE_APPEND);
+    if (f && f.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+        switchJournalRecords++;
+        switchJournalStats.appended++;
+    } else {
+        switchJournalStats.writeErrors++;
+        serialLogLn("[SwitchEvents] ❌ Journal append failed");
     }
-    
-    HTTPClient http;
-    String url = String(MYSQL_API_URL) + "/health";
-    
-    if (!http.begin(url)) {
-        state.mysqlConnected = false;
-        return false;
+    if (f) {
+        f.close();
     }
-    
-    http.setTimeout(3000);
-    int httpCode = http.GET();
-    http.end();
-    
-    bool connected = (httpCode == HTTP_CODE_OK);
-    state.mysqlConnected = connected;
-    state.lastMySQLCheck = millis();
-    
-    if (!connected) {
-        Serial.printf("[MySQL] Connection check failed: HTTP %d\n", httpCode);
+    if (switchJournalRecords >= SWITCH_JOURNAL_MAX_RECORDS && switchJournalTrim()) {
+        saveSwitchEventsToNVS();  // Refresh the backup, at most every SWITCH_JOURNAL_MAX_RECORDS - MAX_SWITCH_EVENTS switches
+    }
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - startUs);
+    switchJournalStats.lastAppendUs = elapsedUs;
+    if (elapsedUs > switchJournalStats.maxAppendUs) {
+        switchJournalStats.maxAppendUs = elapsedUs;
     }
-    
-    return connected;
 }
 
-bool saveSwitchEventToMySQL(const SwitchEvent& evt) {
-    if (strlen(MYSQL_API_URL) == 0) {
-        return false; // MySQL API disabled
-    }
-    
-    if (!checkMySQLConnection()) {
-        return false;
+void loadSwitchEvents() {
+    for (int i = 0; i < MAX_SWITCH_EVENTS; i++) {
+        switchEvents[i] = SwitchEvent();
     }
+    switchEventIndex = 0;
     
-    HTTPClient http;
-    String url = String(MYSQL_API_URL) + "/events";
-    
-    if (!http.begin(url)) {
-        return false; // Failed to begin HTTP connection
+    if (!switchJournalReady) {
+        if (loadSwitchEventsFromNVS()) {
+            serialLogF("[SwitchEvents] Loaded %d events from NVS\n", MAX_SWITCH_EVENTS);
+        } else {
+            serialLogLn("[SwitchEvents] No saved events, initialized empty");
+        }
+        return;
     }
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(3000);
     
-    // Build JSON payload
-    StaticJsonDocument<256> doc;
-    struct tm timeinfo;
-    if (evt.timestamp > 0) {
-        // Convert Unix timestamp to MySQL DATETIME format
-        time_t timestamp = (time_t)evt.timestamp;
-        struct tm* timeinfoPtr = localtime(&timestamp);
-        if (timeinfoPtr != nullptr) {
-            memcpy(&timeinfo, timeinfoPtr, sizeof(struct tm));
-            char timestampStr[32];
-            sprintf(timestampStr, "%04d-%02d-%02d %02d:%02d:%02d",
-                    timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-            doc["timestamp"] = timestampStr;
+    unsigned long startMs = millis();
+    // Interrupted compaction: the temp file is only complete if the journal itself is gone
+    // (firmware before the atomic rename removed the journal first)
+    if (dataFs->exists(SWITCH_JOURNAL_TMP_PATH)) {
+        if (!dataFs->exists(SWITCH_JOURNAL_PATH)) {
+            dataFs->rename(SWITCH_JOURNAL_TMP_PATH, SWITCH_JOURNAL_PATH);
+            serialLogLn("[SwitchEvents] Recovered journal from interrupted compaction");
         } else {
-            // Conversion failed, skip
-            http.end();
-            return false;
+            dataFs->remove(SWITCH_JOURNAL_TMP_PATH);
         }
-    } else {
-        // No valid timestamp, skip
-        http.end();
-        return false;
-    }
-    doc["is_on"] = evt.isOn ? 1 : 0;
-    if (!isnan(evt.tempVorlauf)) {
-        doc["temp_vorlauf"] = round(evt.tempVorlauf * 10) / 10.0;
     }
-    if (!isnan(evt.tempRuecklauf)) {
-        doc["temp_ruecklauf"] = round(evt.tempRuecklauf * 10) / 10.0;
-    }
-    if (!isnan(evt.tankLiters)) {
-        doc["tank_liters"] = round(evt.tankLiters * 10) / 10.0;
+    File f = dataFs->open(SWITCH_JOURNAL_PATH, FILE_READ);
+    if (!f) {
+        // No journal (first boot with it, or a fresh data partition): restore from the NVS backup, which stays
+        if (loadSwitchEventsFromNVS()) {
+            if (switchJournalCompact()) {
+                serialLogF("[SwitchEvents] Restored %lu events from NVS backup into the journal\n", (unsigned long)switchJournalRecords);
+            }
+        } else {
+            serialLogLn("[SwitchEvents] No saved events, initialized empty");
+        }
+        return;
     }
     
-    String json;
-    serializeJson(doc, json);
-    
-    int httpCode = http.POST(json);
-    bool success = (httpCode == HTTP_CODE_OK || httpCode == 200);
-    
-    if (!success) {
-        Serial.printf("[MySQL] Failed to save switch event: HTTP %d\n", httpCode);
+    // Replay: records are appended in seq order, so the last MAX_SWITCH_EVENTS valid ones form the ring
+    uint32_t records = 0, corrupt = 0, lastSeq = 0, loaded = 0;
+    bool tornTail = (f.size() % sizeof(SwitchJournalRecord)) != 0;
+    SwitchJournalRecord rec;
+    while (f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+        records++;
+        if (!switchJournalValid(rec) || rec.seq <= lastSeq) {
+            corrupt++;
+            continue;
+        }
+        lastSeq = rec.seq;
+        SwitchEvent& evt = switchEvents[switchEventIndex];
+        evt.timestamp = rec.timestamp;
+        evt.isOn = rec.isOn != 0;
+        evt.tempVorlauf = rec.tempVorlauf;
+        evt.tempRuecklauf = rec.tempRuecklauf;
+        evt.uptimeMs = rec.uptimeMs;
+        evt.tankLiters = rec.tankLiters;
+        switchEventIndex = (switchEventIndex + 1) % MAX_SWITCH_EVENTS;
+        loaded++;
     }
+    f.close();
     
-    http.end();
-    return success;
+    switchJournalNextSeq = lastSeq + 1;
+    switchJournalRecords = records;
+    switchJournalStats.corrupt = corrupt;
+    if (corrupt > 0 || tornTail) {
+        switchJournalCompact();
+    }
+    switchJournalStats.replayMs = millis() - startMs;
+    serialLogF("[SwitchEvents] Replayed %lu events from journal (%lu records, %lu corrupt) in %lu ms\n",
+               (unsigned long)min(loaded, (uint32_t)MAX_SWITCH_EVENTS), (unsigned long)records,
+               (unsigned long)corrupt, (unsigned long)switchJournalStats.replayMs);
 }
 
-bool saveDailyStatsToMySQL() {
-    if (strlen(MYSQL_API_URL) == 0) {
-        return false; // MySQL API disabled
-    }
-    
-    if (WiFi.status() != WL_CONNECTED) {
-        return false; // No WiFi connection
+// ========== TIME SERIES STORE (data partition) ==========
+// Per-minute history of both temperatures, the tank level and the heating duty, kept on flash for
+// TS_RETENTION_DAYS. The sensing task adds every temperature reading to a one-minute accumulator; the
+// network task writes one 10-byte row per completed minute (only with NTP time) to a file per local
+// day, /ts/YYYYMMDD.bin. Values are fixed-point (0.01 °C, 1 L) and stored as int16 deltas to the
+// previous row of the same file; a row with TS_FLAG_RESET restarts the deltas at 0 (first row after
+// boot), so appending never needs to read the file. RAM use is the accumulator plus the encoder state.
+// 35 days take about 520 KB of the 896 KB data partition; frontend updates don't touch it.
+#define TS_DIR "/ts"
+#define TS_MAGIC 0x31445354UL           // "TSD1"
+#define TS_RETENTION_DAYS 35
+#define TS_MIN_FREE_BYTES 65536         // Delete oldest days early if the data partition runs low
+#define TS_MAX_POINTS 1440              // Per /api/history response (res is raised if needed)
+#define TS_TEMP_SCALE 100               // 0.01 °C
+#define TS_TANK_SCALE 1                 // 1 L
+
+#define TS_FLAG_VORLAUF 0x01
+#define TS_FLAG_RUECKLAUF 0x02
+#define TS_FLAG_TANK 0x04
+#define TS_FLAG_RESET 0x80
+
+struct TsFileHeader {
+    uint32_t magic;
+    uint32_t dayStart;         // Unix time of local midnight
+    uint32_t reserved[2];
+};
+
+struct __attribute__((packed)) TsRow {
+    uint16_t minute;           // Minutes since dayStart (up to 1499 on a 25 h DST day)
+    int16_t dVorlauf;
+    int16_t dRuecklauf;
+    int16_t dTank;
+    uint8_t heatingSec;        // Seconds of the minute with heating ON (0-60)
+    uint8_t flags;
+};
+static_assert(sizeof(TsRow) == 10, "TsRow layout is stored on flash");
+
+// Decoded minute sample
+struct TsSample {
+    uint32_t time;             // Unix time of the minute start
+    float vorlauf;             // NAN = no valid reading in this minute
+    float ruecklauf;
+    float tankLiters;
+    uint8_t heatingSec;
+};
+
+// Running delta state (encoder and decoder use the same rules)
+struct TsDeltaState {
+    int32_t vorlauf = 0;
+    int32_t ruecklauf = 0;
+    int32_t tank = 0;
+};
+
+struct TsAccumulator {
+    uint32_t minute = 0;       // Unix time / 60 of the minute being collected (0 = empty)
+    float sumVorlauf = 0, sumRuecklauf = 0, sumTank = 0;
+    uint16_t nVorlauf = 0, nRuecklauf = 0, nTank = 0;
+    uint16_t samples = 0, heatingSamples = 0;
+};
+
+SemaphoreHandle_t tsMutex = nullptr;
+bool tsReady = false;
+TsAccumulator tsCurrent;               // Guarded by tsMutex (sensing task writes, network task takes)
+TsAccumulator tsCompleted;
+bool tsCompletedPending = false;
+
+// Writer state (network task only)
+uint32_t tsFileDayKey = 0;             // YYYYMMDD of the open day file
+uint32_t tsFileDayStart = 0;
+TsDeltaState tsEncoder;
+bool tsNeedReset = true;
+
+struct TsStats {
+    uint32_t rowsWritten = 0;
+    uint32_t writeErrors = 0;
+    uint32_t filesDeleted = 0;
+    uint32_t queries = 0;
+} tsStats;
+
+static uint32_t tsDayKey(time_t t) {
+    struct tm tmv;
+    localtime_r(&t, &tmv);
+    return (uint32_t)((tmv.tm_year + 1900) * 10000 + (tmv.tm_mon + 1) * 100 + tmv.tm_mday);
+}
+
+// Local midnight of the day containing t (offset = +1 for the following day)
+static time_t tsDayStart(time_t t, int offset = 0) {
+    struct tm tmv;
+    localtime_r(&t, &tmv);
+    tmv.tm_mday += offset;
+    tmv.tm_hour = 0;
+    tmv.tm_min = 0;
+    tmv.tm_sec = 0;
+    tmv.tm_isdst = -1;
+    return mktime(&tmv);
+}
+
+static void tsDayPath(uint32_t dayKey, char* path, size_t size) {
+    snprintf(path, size, TS_DIR "/%08lu.bin", (unsigned long)dayKey);
+}
+
+static int16_t tsEncodeDelta(int32_t value, int32_t& prev) {
+    int32_t delta = value - prev;
+    if (delta > INT16_MAX) delta = INT16_MAX;   // Larger jumps are caught up over the next rows
+    if (delta < INT16_MIN) delta = INT16_MIN;
+    prev += delta;
+    return (int16_t)delta;
+}
+
+// Apply one row to the decoder state and produce the sample
+static void tsDecodeRow(const TsRow& row, uint32_t dayStart, TsDeltaState& dec, TsSample& out) {
+    if (row.flags & TS_FLAG_RESET) {
+        dec = TsDeltaState();
     }
-    
-    // Get current date
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo, 100)) {
-        return false; // No NTP sync
-    }
-    
-    // Calculate today's statistics (same logic as in /api/stats-history)
-    unsigned long todayOnSeconds = 0;
-    unsigned long todayOffSeconds = 0;
-    float sumVorlauf = 0.0;
-    float sumRuecklauf = 0.0;
-    float minVorlauf = NAN;
-    float maxVorlauf = NAN;
-    float minRuecklauf = NAN;
-    float maxRuecklauf = NAN;
-    int sampleCount = 0;
-    
-    // Get today's timestamp at 00:00:00
-    struct tm todayStart = timeinfo;
-    todayStart.tm_hour = 0;
-    todayStart.tm_min = 0;
-    todayStart.tm_sec = 0;
-    unsigned long todayStartTimestamp = mktime(&todayStart);
-    
-    // Get yesterday's timestamp at 00:00:00 (for events that started yesterday but ended today)
-    struct tm yesterdayStart = timeinfo;
-    yesterdayStart.tm_hour = 0;
-    yesterdayStart.tm_min = 0;
-    yesterdayStart.tm_sec = 0;
-    time_t yesterdayTime = mktime(&yesterdayStart);
-    yesterdayTime -= 86400; // 24 hours in seconds
-    unsigned long yesterdayStartTimestamp = (unsigned long)yesterdayTime;
-    
-    // Collect today's events (simplified version - limit to prevent stack overflow)
-    const int MAX_TODAY_EVENTS = 20;
-    struct EventWithIndex {
-        const SwitchEvent* evt;
-        unsigned long sortKey;
-    };
-    EventWithIndex todayEvents[MAX_TODAY_EVENTS];
-    int todayEventCount = 0;
-    
-    for (int i = 0; i < MAX_SWITCH_EVENTS && todayEventCount < MAX_TODAY_EVENTS; ++i) {
-        int idx = (switchEventIndex + i) % MAX_SWITCH_EVENTS;
-        const SwitchEvent& evt = switchEvents[idx];
-        if (evt.timestamp == 0 && evt.uptimeMs == 0) continue;
-        
-        bool isRelevant = false;
-        if (evt.timestamp > 0) {
-            isRelevant = (evt.timestamp >= yesterdayStartTimestamp && evt.timestamp < (todayStartTimestamp + 86400));
-        } else if (evt.uptimeMs > 0) {
-            unsigned long currentUptime = millis();
-            if (evt.uptimeMs <= currentUptime && (currentUptime - evt.uptimeMs) < 172800000) {
-                isRelevant = true;
-            }
+    dec.vorlauf += row.dVorlauf;
+    dec.ruecklauf += row.dRuecklauf;
+    dec.tank += row.dTank;
+    out.time = dayStart + (uint32_t)row.minute * 60;
+    out.vorlauf = (row.flags & TS_FLAG_VORLAUF) ? dec.vorlauf / (float)TS_TEMP_SCALE : NAN;
+    out.ruecklauf = (row.flags & TS_FLAG_RUECKLAUF) ? dec.ruecklauf / (float)TS_TEMP_SCALE : NAN;
+    out.tankLiters = (row.flags & TS_FLAG_TANK) ? dec.tank / (float)TS_TANK_SCALE : NAN;
+    out.heatingSec = row.heatingSec;
+}
+
+// Delete day files older than the retention window, and the oldest ones while space is low
+static void tsEnforceRetention(uint32_t todayKey) {
+    uint32_t cutoffKey = tsDayKey(tsDayStart(time(nullptr), -TS_RETENTION_DAYS));
+    for (;;) {
+        uint32_t oldestKey = 0;
+        int files = 0;
+        File dir = dataFs->open(TS_DIR);
+        if (!dir || !dir.isDirectory()) {
+            return;
         }
-        
-        if (!isRelevant) continue;
-        
-        todayEvents[todayEventCount].evt = &evt;
-        todayEvents[todayEventCount].sortKey = evt.timestamp > 0 ? evt.timestamp : evt.uptimeMs;
-        todayEventCount++;
-    }
-    
-    // Sort events chronologically
-    for (int i = 0; i < todayEventCount - 1; ++i) {
-        for (int j = i + 1; j < todayEventCount; ++j) {
-            if (todayEvents[i].sortKey > todayEvents[j].sortKey) {
-                EventWithIndex temp = todayEvents[i];
-                todayEvents[i] = todayEvents[j];
-                todayEvents[j] = temp;
+        File entry = dir.openNextFile();
+        while (entry) {
+            const char* name = strrchr(entry.name(), '/');
+            uint32_t key = strtoul(name ? name + 1 : entry.name(), nullptr, 10);
+            if (key > 0 && key != todayKey) {
+                files++;
+                if (oldestKey == 0 || key < oldestKey) oldestKey = key;
             }
+            entry.close();
+            entry = dir.openNextFile();
         }
-    }
-    
-    // Calculate on/off times and temperatures
-    unsigned long lastOnTime = 0;
-    bool lastWasOn = false;
-    
-    for (int i = 0; i < todayEventCount; ++i) {
-        const SwitchEvent& evt = *todayEvents[i].evt;
-        unsigned long eventTime = evt.timestamp > 0 ? evt.timestamp : (evt.uptimeMs / 1000);
+        dir.close();
         
-        if (evt.timestamp > 0 && evt.timestamp < todayStartTimestamp && evt.isOn) {
-            lastOnTime = todayStartTimestamp;
-            lastWasOn = true;
-            continue;
+        bool lowSpace = dataFs->totalBytes() - dataFs->usedBytes() < TS_MIN_FREE_BYTES;
+        if (files == 0 || (oldestKey >= cutoffKey && !lowSpace)) {
+            return;
         }
-        
-        if (evt.isOn) {
-            lastOnTime = eventTime;
-            lastWasOn = true;
-        } else {
-            if (lastWasOn && lastOnTime > 0) {
-                unsigned long duration = eventTime - lastOnTime;
-                if (eventTime >= todayStartTimestamp) {
-                    if (lastOnTime < todayStartTimestamp) {
-                        todayOnSeconds += (eventTime - todayStartTimestamp);
-                    } else {
-                        todayOnSeconds += duration;
-                    }
+        char path[24];
+        tsDayPath(oldestKey, path, sizeof(path));
+        dataFs->remove(path);
+        tsStats.filesDeleted++;
+        LOG_INFO(LOGCH_STORAGE, "[TimeSeries] Deleted %s%s\n", path, lowSpace ? " (low space)" : "");
+    }
+}
+
+// Called from setup() after initDataPartition()
+void initTimeSeries() {
+    tsMutex = xSemaphoreCreateMutex();
+    if (!dataFs->exists(TS_DIR)) {
+        dataFs->mkdir(TS_DIR);
+    }
+    tsReady = true;
+}
+
+// Sensing task: add the current readings to the running minute
+void timeSeriesSample() {
+    if (!tsReady || !state.ntpSynced) {
+        return;  // Samples can only be placed in time with a synced clock
+    }
+    uint32_t minute = (uint32_t)(time(nullptr) / 60);
+    MutexLock lock(tsMutex);
+    if (tsCurrent.minute != 0 && tsCurrent.minute != minute) {
+        tsCompleted = tsCurrent;       // Handed to the network task (an unwritten older minute is replaced)
+        tsCompletedPending = true;
+        tsCurrent = TsAccumulator();
+    }
+    tsCurrent.minute = minute;
+    if (!isnan(state.tempVorlauf) && state.tempVorlauf != -127.0) {
+        tsCurrent.sumVorlauf += state.tempVorlauf;
+        tsCurrent.nVorlauf++;
+    }
+    if (!isnan(state.tempRuecklauf) && state.tempRuecklauf != -127.0) {
+        tsCurrent.sumRuecklauf += state.tempRuecklauf;
+        tsCurrent.nRuecklauf++;
+    }
+    if (state.tankSensorAvailable && !isnan(state.tankLiters)) {
+        tsCurrent.sumTank += state.tankLiters;
+        tsCurrent.nTank++;
+    }
+    tsCurrent.samples++;
+    if (state.heatingOn) {
+        tsCurrent.heatingSamples++;
+    }
+}
+
+// Network task: write the completed minute (if any) to its day file
+void timeSeriesFlush() {
+    if (!tsReady) {
+        return;
+    }
+    TsAccumulator acc;
+    {
+        MutexLock lock(tsMutex);
+        if (!tsCompletedPending) {
+            return;
+        }
+        acc = tsCompleted;
+        tsCompletedPending = false;
+    }
+    if (acc.samples == 0) {
+        return;
+    }
+    
+    time_t minuteStart = (time_t)acc.minute * 60;
+    uint32_t dayKey = tsDayKey(minuteStart);
+    char path[24];
+    tsDayPath(dayKey, path, sizeof(path));
+    if (dayKey != tsFileDayKey) {
+        tsFileDayKey = dayKey;
+        tsFileDayStart = (uint32_t)tsDayStart(minuteStart);
+        tsNeedReset = true;
+        if (!dataFs->exists(path)) {
+            TsFileHeader header;
+            memset(&header, 0, sizeof(header));
+            header.magic = TS_MAGIC;
+            header.dayStart = tsFileDayStart;
+            File f = dataFs->open(path, FILE_WRITE);
+            if (!f || f.write((const uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+                if (f) f.close();
+                tsStats.writeErrors++;
+                tsFileDayKey = 0;
+                return;
+            }
+            f.close();
+            tsEnforceRetention(dayKey);
+        }
+    }
+    
+    TsRow row;
+    row.flags = 0;
+    if (tsNeedReset) {
+        tsEncoder = TsDeltaState();
+        row.flags |= TS_FLAG_RESET;
+    }
+    row.minute = (uint16_t)((minuteStart - tsFileDayStart) / 60);
+    row.dVorlauf = 0;
+    row.dRuecklauf = 0;
+    row.dTank = 0;
+    if (acc.nVorlauf > 0) {
+        row.dVorlauf = tsEncodeDelta(lroundf(acc.sumVorlauf / acc.nVorlauf * TS_TEMP_SCALE), tsEncoder.vorlauf);
+        row.flags |= TS_FLAG_VORLAUF;
+    }
+    if (acc.nRuecklauf > 0) {
+        row.dRuecklauf = tsEncodeDelta(lroundf(acc.sumRuecklauf / acc.nRuecklauf * TS_TEMP_SCALE), tsEncoder.ruecklauf);
+        row.flags |= TS_FLAG_RUECKLAUF;
+    }
+    if (acc.nTank > 0) {
+        row.dTank = tsEncodeDelta(lroundf(acc.sumTank / acc.nTank * TS_TANK_SCALE), tsEncoder.tank);
+        row.flags |= TS_FLAG_TANK;
+    }
+    row.heatingSec = (uint8_t)((acc.heatingSamples * 60 + acc.samples / 2) / acc.samples);
+    
+    File f = dataFs->open(path, FILE_APPEND);
+    if (f && f.write((const uint8_t*)&row, sizeof(row)) == sizeof(row)) {
+        tsStats.rowsWritten++;
+        tsNeedReset = false;
+    } else {
+        tsStats.writeErrors++;
+        tsNeedReset = true;            // Encoder state may be ahead of the file
+    }
+    if (f) {
+        f.close();
+    }
+}
+
+#define TS_MAX_DAY_FILES (TS_RETENTION_DAYS + 8)  // Day files one reader visits (retention keeps fewer)
+
+// Sequential reader over the day files of [from, to). Used by /api/history.
+// begin() lists /ts once and keeps the existing days in range, so a wide range never probes
+// thousands of missing files inside one chunk callback.
+struct TsReader {
+    uint32_t from = 0;
+    uint32_t to = 0;
+    uint32_t dayKeys[TS_MAX_DAY_FILES];  // Ascending
+    uint8_t dayCount = 0;
+    uint8_t dayPos = 0;                // Next day to open
+    File file;
+    uint32_t fileDayStart = 0;
+    TsDeltaState dec;
+    
+    void begin(uint32_t fromTime, uint32_t toTime) {
+        from = fromTime;
+        to = toTime;
+        dayCount = 0;
+        dayPos = 0;
+        uint32_t firstKey = tsDayKey((time_t)fromTime);
+        uint32_t lastKey = tsDayKey((time_t)(toTime - 1));
+        File dir = dataFs->open(TS_DIR);
+        if (!dir || !dir.isDirectory()) {
+            return;
+        }
+        File entry = dir.openNextFile();
+        while (entry) {
+            const char* name = strrchr(entry.name(), '/');
+            uint32_t key = strtoul(name ? name + 1 : entry.name(), nullptr, 10);
+            entry.close();
+            if (key >= firstKey && key <= lastKey && dayCount < TS_MAX_DAY_FILES) {
+                // Insertion sort: the directory order is not guaranteed
+                int i = dayCount++;
+                while (i > 0 && dayKeys[i - 1] > key) {
+                    dayKeys[i] = dayKeys[i - 1];
+                    i--;
                 }
-            } else if (!lastWasOn && lastOnTime > 0) {
-                unsigned long duration = eventTime - lastOnTime;
-                if (eventTime >= todayStartTimestamp) {
-                    if (lastOnTime < todayStartTimestamp) {
-                        todayOffSeconds += (eventTime - todayStartTimestamp);
-                    } else {
-                        todayOffSeconds += duration;
-                    }
+                dayKeys[i] = key;
+            }
+            entry = dir.openNextFile();
+        }
+        dir.close();
+    }
+    
+    // Next sample in range; false when the range is exhausted
+    bool next(TsSample& out) {
+        for (;;) {
+            if (!file) {
+                if (dayPos >= dayCount) {
+                    return false;
+                }
+                char path[24];
+                tsDayPath(dayKeys[dayPos++], path, sizeof(path));
+                file = dataFs->open(path, FILE_READ);
+                TsFileHeader header;
+                if (!file || file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != TS_MAGIC) {
+                    if (file) file.close();
+                    file = File();
+                    continue;
                 }
+                fileDayStart = header.dayStart;
+                dec = TsDeltaState();
+            }
+            TsRow row;
+            if (file.read((uint8_t*)&row, sizeof(row)) != sizeof(row)) {
+                file.close();
+                file = File();
+                continue;
+            }
+            tsDecodeRow(row, fileDayStart, dec, out);
+            if (out.time >= to) {
+                file.close();
+                file = File();
+                dayPos = dayCount;             // Done
+                return false;
+            }
+            if (out.time >= from) {
+                return true;
             }
-            lastOnTime = eventTime;
-            lastWasOn = false;
         }
-        
-        // Track temperatures from OFF events (completed cycles)
-        if (!evt.isOn && !isnan(evt.tempVorlauf)) {
-            sumVorlauf += evt.tempVorlauf;
-            if (isnan(minVorlauf) || evt.tempVorlauf < minVorlauf) minVorlauf = evt.tempVorlauf;
-            if (isnan(maxVorlauf) || evt.tempVorlauf > maxVorlauf) maxVorlauf = evt.tempVorlauf;
-            sampleCount++;
+    }
+    
+    void end() {
+        if (file) file.close();
+    }
+};
+
+// State of one streamed /api/history response: rows are averaged into buckets of res seconds.
+// Output is produced piece by piece (header, one bucket, footer) into a small staging buffer, so any
+// chunk size the web server asks for can be served.
+struct TsHistoryStream {
+    TsReader reader;
+    uint32_t res = 60;
+    uint8_t phase = 0;                 // 0 = header, 1 = rows, 2 = footer, 3 = done
+    bool firstRow = true;
+    uint32_t bucketStart = 0;
+    float sumV = 0, sumR = 0, sumT = 0;
+    uint16_t nV = 0, nR = 0, nT = 0, rows = 0;
+    uint32_t heatingSec = 0;
+    char pending[192];
+    size_t pendingLen = 0;
+    size_t pendingOff = 0;
+    
+    ~TsHistoryStream() { reader.end(); }
+    
+    void add(const TsSample& s) {
+        if (!isnan(s.vorlauf)) { sumV += s.vorlauf; nV++; }
+        if (!isnan(s.ruecklauf)) { sumR += s.ruecklauf; nR++; }
+        if (!isnan(s.tankLiters)) { sumT += s.tankLiters; nT++; }
+        heatingSec += s.heatingSec;
+        rows++;
+    }
+    
+    // Current bucket as [t,vorlauf,ruecklauf,tank,heatingMin] into pending, then clear it
+    void emitBucket() {
+        char v[12], r[12], t[12];
+        if (nV) snprintf(v, sizeof(v), "%.2f", sumV / nV); else strcpy(v, "null");
+        if (nR) snprintf(r, sizeof(r), "%.2f", sumR / nR); else strcpy(r, "null");
+        if (nT) snprintf(t, sizeof(t), "%.0f", sumT / nT); else strcpy(t, "null");
+        int n = snprintf(pending, sizeof(pending), "%s[%lu,%s,%s,%s,%.1f]", firstRow ? "" : ",",
+                         (unsigned long)bucketStart, v, r, t, heatingSec / 60.0f);
+        pendingLen = n > 0 ? min((size_t)n, sizeof(pending) - 1) : 0;
+        firstRow = false;
+        sumV = sumR = sumT = 0;
+        nV = nR = nT = rows = 0;
+        heatingSec = 0;
+    }
+    
+    // Produce the next piece into pending; false when the response is complete
+    bool produce() {
+        pendingOff = 0;
+        pendingLen = 0;
+        if (phase == 0) {
+            int n = snprintf(pending, sizeof(pending), "{\"from\":%lu,\"to\":%lu,\"res\":%lu,"
+                             "\"columns\":[\"t\",\"vorlauf\",\"ruecklauf\",\"tankLiters\",\"heatingMin\"],\"rows\":[",
+                             (unsigned long)reader.from, (unsigned long)reader.to, (unsigned long)res);
+            pendingLen = min((size_t)n, sizeof(pending) - 1);
+            phase = 1;
+            return true;
+        }
+        if (phase == 1) {
+            TsSample s;
+            while (reader.next(s)) {
+                uint32_t bucket = reader.from + (s.time - reader.from) / res * res;
+                bool emit = rows > 0 && bucket != bucketStart;
+                if (emit) {
+                    emitBucket();
+                }
+                bucketStart = bucket;
+                add(s);
+                if (emit) {
+                    return true;
+                }
+            }
+            reader.end();
+            phase = 2;
+            if (rows > 0) {
+                emitBucket();
+                return true;
+            }
         }
-        if (!evt.isOn && !isnan(evt.tempRuecklauf)) {
-            sumRuecklauf += evt.tempRuecklauf;
-            if (isnan(minRuecklauf) || evt.tempRuecklauf < minRuecklauf) minRuecklauf = evt.tempRuecklauf;
-            if (isnan(maxRuecklauf) || evt.tempRuecklauf > maxRuecklauf) maxRuecklauf = evt.tempRuecklauf;
+        if (phase == 2) {
+            memcpy(pending, "]}", 2);
+            pendingLen = 2;
+            phase = 3;
+            return true;
         }
+        return false;
     }
     
-    // If currently ON, add time from last ON event to now
-    // Also include current temperatures in average calculation if heating is running
-    if (lastWasOn && state.heatingOn && lastOnTime > 0) {
-        unsigned long currentTime = mktime(&timeinfo);
-        if (currentTime > lastOnTime) {
-            unsigned long duration = currentTime - lastOnTime;
-            todayOnSeconds += duration;
-            
-            // Include current temperatures in average (for ongoing heating cycle)
-            if (!isnan(state.tempVorlauf)) {
-                sumVorlauf += state.tempVorlauf;
-                if (isnan(minVorlauf) || state.tempVorlauf < minVorlauf) minVorlauf = state.tempVorlauf;
-                if (isnan(maxVorlauf) || state.tempVorlauf > maxVorlauf) maxVorlauf = state.tempVorlauf;
-                sampleCount++;
+    // AwsResponseFiller: fill up to maxLen bytes, 0 = end of response
+    size_t fill(uint8_t* out, size_t maxLen) {
+        size_t len = 0;
+        while (len < maxLen) {
+            if (pendingOff == pendingLen && !produce()) {
+                break;
             }
-            if (!isnan(state.tempRuecklauf)) {
-                sumRuecklauf += state.tempRuecklauf;
-                if (isnan(minRuecklauf) || state.tempRuecklauf < minRuecklauf) minRuecklauf = state.tempRuecklauf;
-                if (isnan(maxRuecklauf) || state.tempRuecklauf > maxRuecklauf) maxRuecklauf = state.tempRuecklauf;
+            size_t n = min(pendingLen - pendingOff, maxLen - len);
+            memcpy(out + len, pending + pendingOff, n);
+            pendingOff += n;
+            len += n;
+        }
+        return len;
+    }
+};
+
+// ========== DAILY STATISTICS ==========
+// Exact per-day statistics, updated online at every temperature reading (control task): Welford
+// mean/variance plus min/max per sensor, ON/OFF time in milliseconds and the number of switches.
+// The daily MySQL upload and /api/stats-history read this state instead of reconstructing the day
+// from the last switch events. It is checkpointed to /daily.bin on the data partition every
+// DAILY_CHECKPOINT_MS and at midnight, so a reboot loses at most a few minutes. The checkpoint is
+// written to /daily.tmp and renamed over the old one, so a power cut never leaves a torn file. At midnight the finished day is kept as
+// "previous" until its final values have been uploaded.
+#define DAILY_STATS_PATH "/daily.bin"
+#define DAILY_STATS_TMP_PATH "/daily.tmp"
+#define DAILY_STATS_MAGIC 0x31594144UL   // "DAY1"
+#define DAILY_CHECKPOINT_MS 300000
+#define DAILY_MAX_SAMPLE_GAP_MS 5000     // Longer gaps (e.g. blocked task) are not counted as ON/OFF time
+
+struct RunningStat {
+    uint32_t count;
+    double mean;
+    double m2;                           // Sum of squared deviations from the mean
+    float min;
+    float max;
+    
+    void reset() {
+        count = 0;
+        mean = 0;
+        m2 = 0;
+        min = NAN;
+        max = NAN;
+    }
+    
+    void add(float x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+        if (count == 1 || x < min) min = x;
+        if (count == 1 || x > max) max = x;
+    }
+    
+    float stddev() const {
+        return count > 1 ? (float)sqrt(m2 / (count - 1)) : 0.0f;
+    }
+};
+
+struct DailyStats {
+    uint32_t dayKey;                     // YYYYMMDD, 0 = nothing recorded yet
+    RunningStat vorlauf;
+    RunningStat ruecklauf;
+    uint64_t onMs;
+    uint64_t offMs;
+    uint32_t switches;
+    
+    void reset(uint32_t key) {
+        dayKey = key;
+        vorlauf.reset();
+        ruecklauf.reset();
+        onMs = 0;
+        offMs = 0;
+        switches = 0;
+    }
+};
+
+struct DailyStatsCheckpoint {
+    uint32_t magic;
+    DailyStats current;
+    DailyStats previous;
+    uint8_t previousPending;
+    uint8_t reserved[3];
+    uint32_t crc;                        // CRC32 over all preceding bytes
+};
+
+SemaphoreHandle_t dailyStatsMutex = nullptr;
+DailyStats dailyStats;                   // Today (guarded by dailyStatsMutex)
+DailyStats dailyStatsPrevious;           // Finished day waiting for its final upload
+bool dailyStatsPreviousPending = false;
+unsigned long dailyStatsLastSampleMs = 0;
+volatile bool dailyStatsCheckpointDue = false;
+unsigned long dailyStatsLastCheckpointMs = 0;
+
+// Called from setup() (after initDataPartition(), if a filesystem is available)
+void initDailyStats() {
+    dailyStatsMutex = xSemaphoreCreateMutex();
+    dailyStats.reset(0);
+    dailyStatsPrevious.reset(0);
+    
+    if (!switchJournalReady) {
+        return;  // No filesystem: statistics start fresh after every reboot
+    }
+    // A leftover temp file is a checkpoint interrupted before its rename: the previous one is still valid
+    if (dataFs->exists(DAILY_STATS_TMP_PATH)) {
+        dataFs->remove(DAILY_STATS_TMP_PATH);
+    }
+    File f = dataFs->open(DAILY_STATS_PATH, FILE_READ);
+    if (!f) {
+        return;
+    }
+    DailyStatsCheckpoint cp;
+    size_t n = f.read((uint8_t*)&cp, sizeof(cp));
+    f.close();
+    if (n != sizeof(cp) || cp.magic != DAILY_STATS_MAGIC ||
+        cp.crc != crc32_le(0, (const uint8_t*)&cp, offsetof(DailyStatsCheckpoint, crc))) {
+        LOG_WARN(LOGCH_STORAGE, "[Stats] ⚠️ Daily statistics checkpoint invalid, starting fresh\n");
+        return;
+    }
+    dailyStats = cp.current;
+    dailyStatsPrevious = cp.previous;
+    dailyStatsPreviousPending = cp.previousPending != 0;
+    LOG_INFO(LOGCH_STORAGE, "[Stats] Restored daily statistics of %lu (%lu samples)\n",
+             (unsigned long)dailyStats.dayKey, (unsigned long)dailyStats.vorlauf.count);
+}
+
+// Network task: write the checkpoint every DAILY_CHECKPOINT_MS and right after midnight
+void dailyStatsCheckpoint() {
+    unsigned long now = millis();
+    if (!switchJournalReady || (!dailyStatsCheckpointDue && now - dailyStatsLastCheckpointMs < DAILY_CHECKPOINT_MS)) {
+        return;
+    }
+    dailyStatsCheckpointDue = false;
+    dailyStatsLastCheckpointMs = now;
+    
+    DailyStatsCheckpoint cp;
+    memset(&cp, 0, sizeof(cp));
+    {
+        MutexLock lock(dailyStatsMutex);
+        if (dailyStats.dayKey == 0) {
+            return;
+        }
+        cp.current = dailyStats;
+        cp.previous = dailyStatsPrevious;
+        cp.previousPending = dailyStatsPreviousPending ? 1 : 0;
+    }
+    cp.magic = DAILY_STATS_MAGIC;
+    cp.crc = crc32_le(0, (const uint8_t*)&cp, offsetof(DailyStatsCheckpoint, crc));
+    // Never truncate the checkpoint in place: a power cut mid-write would fail the CRC and lose the day
+    File f = dataFs->open(DAILY_STATS_TMP_PATH, FILE_WRITE);
+    if (!f) {
+        return;
+    }
+    bool written = f.write((const uint8_t*)&cp, sizeof(cp)) == sizeof(cp);
+    f.close();
+    // LittleFS rename replaces the checkpoint atomically: a power cut leaves either the old or the new file
+    if (!written || !dataFs->rename(DAILY_STATS_TMP_PATH, DAILY_STATS_PATH)) {
+        dataFs->remove(DAILY_STATS_TMP_PATH);
+    }
+}
+
+// Control task, at every temperature update
+void dailyStatsSample() {
+    unsigned long now = millis();
+    unsigned long elapsed = dailyStatsLastSampleMs > 0 ? now - dailyStatsLastSampleMs : 0;
+    dailyStatsLastSampleMs = now;
+    if (!state.ntpSynced) {
+        return;  // Day unknown
+    }
+    uint32_t dayKey = tsDayKey(time(nullptr));
+    
+    MutexLock lock(dailyStatsMutex);
+    if (dailyStats.dayKey != dayKey) {
+        if (dailyStats.dayKey != 0) {
+            dailyStatsPrevious = dailyStats;
+            dailyStatsPreviousPending = true;
+            dailyStatsCheckpointDue = true;
+        }
+        dailyStats.reset(dayKey);
+        elapsed = 0;
+    }
+    if (!isnan(state.tempVorlauf) && state.tempVorlauf != -127.0) {
+        dailyStats.vorlauf.add(state.tempVorlauf);
+    }
+    if (!isnan(state.tempRuecklauf) && state.tempRuecklauf != -127.0) {
+        dailyStats.ruecklauf.add(state.tempRuecklauf);
+    }
+    if (elapsed <= DAILY_MAX_SAMPLE_GAP_MS) {
+        if (state.heatingOn) {
+            dailyStats.onMs += elapsed;
+        } else {
+            dailyStats.offMs += elapsed;
+        }
+    }
+}
+
+// setHeater(): count a switch for today
+void dailyStatsSwitch() {
+    MutexLock lock(dailyStatsMutex);
+    if (dailyStats.dayKey != 0) {
+        dailyStats.switches++;
+    }
+}
+
+void dailyStatsSnapshot(DailyStats& today, DailyStats* previous = nullptr, bool* previousPending = nullptr) {
+    MutexLock lock(dailyStatsMutex);
+    today = dailyStats;
+    if (previous) *previous = dailyStatsPrevious;
+    if (previousPending) *previousPending = dailyStatsPreviousPending;
+}
+
+// ========== MYSQL INTEGRATION (OPTIONAL) ==========
+// All requests to the PHP API go through one keep-alive connection (mysqlRequest). Consecutive
+// requests (batch upload, the three GETs of /api/stats-history, health check) reuse the TCP socket
+// instead of paying a handshake each. The socket is dropped before the server's keep-alive timeout
+// (Apache default: 5 s) and re-established transparently; GETs that hit a stale socket are retried
+// once on a fresh connection. Requests are serialized by a mutex, since the outbound worker, the
+// network task and web handlers all talk to the API.
+#define MYSQL_KEEPALIVE_IDLE_MS 4000     // Close our side before the server does
+#define MYSQL_CONNECT_TIMEOUT_MS 1000
+#define MYSQL_ERROR_BUSY (-100)          // Client mutex not available within the caller's wait time
+#define MYSQL_LATENCY_BUCKETS 8
+
+const uint16_t mysqlLatencyBucketMs[MYSQL_LATENCY_BUCKETS - 1] = { 25, 50, 100, 250, 500, 1000, 2000 };
+
+struct MySQLClientStats {
+    uint32_t requests = 0;
+    uint32_t reused = 0;               // Request sent on an already open socket
+    uint32_t connects = 0;             // New TCP connection needed
+    uint32_t reconnects = 0;           // Stale keep-alive socket, retried on a new connection
+    uint32_t idleCloses = 0;           // Socket closed by us after MYSQL_KEEPALIVE_IDLE_MS
+    uint32_t errors = 0;               // Transport errors (HTTP code < 0)
+    uint32_t busy = 0;                 // Gave up waiting for the client mutex
+    uint32_t lastLatencyMs = 0;
+    uint32_t maxLatencyMs = 0;
+    uint32_t latency[MYSQL_LATENCY_BUCKETS] = {0};  // <25, <50, <100, <250, <500, <1000, <2000, >=2000 ms
+} mysqlClientStats;
+
+SemaphoreHandle_t mysqlClientMutex = nullptr;
+WiFiClient mysqlSocket;
+HTTPClient mysqlHttp;
+bool mysqlHttpBegun = false;
+unsigned long mysqlLastUseMs = 0;
+String mysqlBasePath;  // Path part of MYSQL_API_URL, e.g. "/heizungssteuerung/mysql_api.php"
+
+static void mysqlRecordLatency(uint32_t ms) {
+    int bucket = 0;
+    while (bucket < MYSQL_LATENCY_BUCKETS - 1 && ms >= mysqlLatencyBucketMs[bucket]) {
+        bucket++;
+    }
+    mysqlClientStats.latency[bucket]++;
+    mysqlClientStats.lastLatencyMs = ms;
+    if (ms > mysqlClientStats.maxLatencyMs) mysqlClientStats.maxLatencyMs = ms;
+}
+
+// Drop the persistent connection (caller holds mysqlClientMutex)
+static void mysqlCloseLocked() {
+    if (mysqlHttpBegun) {
+        mysqlHttp.setReuse(false);
+        mysqlHttp.end();
+        mysqlHttpBegun = false;
+    }
+    mysqlSocket.stop();
+}
+
+void initMySQLClient() {
+    mysqlClientMutex = xSemaphoreCreateMutex();
+    String url = String(MYSQL_API_URL);
+    int schemeEnd = url.indexOf("://");
+    int pathStart = url.indexOf('/', schemeEnd >= 0 ? schemeEnd + 3 : 0);
+    mysqlBasePath = pathStart >= 0 ? url.substring(pathStart) : "";
+    if (mysqlBasePath.endsWith("/")) {
+        mysqlBasePath.remove(mysqlBasePath.length() - 1);
+    }
+}
+
+// Send one request to the MySQL API. path is relative to MYSQL_API_URL (e.g. "/stats/today"),
+// body == nullptr means GET. Returns the HTTP code or a negative HTTPClient/MYSQL_ERROR_* code.
+int mysqlRequest(const char* path, const String* body, String* response, uint16_t timeoutMs, uint32_t lockWaitMs) {
+    if (strlen(MYSQL_API_URL) == 0 || !mysqlClientMutex) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    if (xSemaphoreTake(mysqlClientMutex, pdMS_TO_TICKS(lockWaitMs)) != pdTRUE) {
+        mysqlClientStats.busy++;
+        return MYSQL_ERROR_BUSY;
+    }
+    
+    if (mysqlHttpBegun && millis() - mysqlLastUseMs >= MYSQL_KEEPALIVE_IDLE_MS) {
+        mysqlCloseLocked();
+        mysqlClientStats.idleCloses++;
+    }
+    
+    int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = mysqlHttpBegun && mysqlSocket.connected();
+        bool ok;
+        if (mysqlHttpBegun) {
+            ok = mysqlHttp.setURL(mysqlBasePath + path);  // Same host: keeps the socket
+        } else {
+            ok = mysqlHttp.begin(mysqlSocket, String(MYSQL_API_URL) + path);
+            mysqlHttpBegun = ok;
+        }
+        if (!ok) {
+            mysqlCloseLocked();
+            break;
+        }
+        mysqlHttp.setReuse(true);
+        mysqlHttp.setTimeout(timeoutMs);
+        mysqlHttp.setConnectTimeout(MYSQL_CONNECT_TIMEOUT_MS);
+        if (body) {
+            mysqlHttp.addHeader("Content-Type", "application/json");
+        }
+        
+        unsigned long start = millis();
+        httpCode = body ? mysqlHttp.POST(*body) : mysqlHttp.GET();
+        if (httpCode > 0) {
+            String payload = mysqlHttp.getString();  // Always drain the body, or the socket cannot be reused
+            if (response) {
+                *response = payload;
             }
         }
+        mysqlRecordLatency(millis() - start);
+        mysqlClientStats.requests++;
+        if (reused) {
+            mysqlClientStats.reused++;
+        } else {
+            mysqlClientStats.connects++;
+        }
+        
+        if (httpCode > 0) {
+            break;
+        }
+        
+        mysqlClientStats.errors++;
+        mysqlCloseLocked();
+        // Server closed the idle socket under us: retry once on a new connection. POSTs only if
+        // the request could not even be sent (otherwise the server may already have stored it).
+        bool notSent = httpCode == HTTPC_ERROR_CONNECTION_REFUSED || httpCode == HTTPC_ERROR_SEND_HEADER_FAILED;
+        if (!reused || (body && !notSent)) {
+            break;
+        }
+        mysqlClientStats.reconnects++;
     }
     
-    // Use calculated values or fallback to stats
-    unsigned long finalOnSeconds = todayOnSeconds > 0 ? todayOnSeconds : stats.onTimeSeconds;
-    unsigned long finalOffSeconds = todayOffSeconds > 0 ? todayOffSeconds : stats.offTimeSeconds;
+    mysqlLastUseMs = millis();
+    if (httpCode > 0) {
+        // Any answer from the API proves connectivity, no extra /health request needed
+        state.mysqlConnected = true;
+        state.lastMySQLCheck = mysqlLastUseMs;
+    }
+    xSemaphoreGive(mysqlClientMutex);
+    return httpCode;
+}
+
+bool checkMySQLConnection() {
+    if (strlen(MYSQL_API_URL) == 0) {
+        state.mysqlConnected = false;
+        return false;
+    }
     
-    // Only save to MySQL if heater actually ran (has switches or ON time)
-    if (stats.todaySwitches == 0 && finalOnSeconds == 0) {
-        Serial.println("[MySQL] Skipping daily stats save - no heating activity today");
-        return true; // Return true to avoid retry, but don't save
+    if (WiFi.status() != WL_CONNECTED) {
+        state.mysqlConnected = false;
+        return false;
+    }
+    
+    int httpCode = mysqlRequest("/health", nullptr, nullptr, 3000, 3000);
+    if (httpCode == MYSQL_ERROR_BUSY) {
+        return state.mysqlConnected; // Another request is in flight, keep last known state
     }
     
-    // Calculate diesel consumption
-    float todayDieselLiters = (finalOnSeconds / 3600.0) * state.dieselConsumptionPerHour;
+    bool connected = (httpCode == HTTP_CODE_OK);
+    state.mysqlConnected = connected;
+    state.lastMySQLCheck = millis();
     
-    // Build JSON payload for PHP API
-    HTTPClient http;
-    String url = String(MYSQL_API_URL) + "/stats/daily";
+    if (!connected) {
+        LOG_WARN(LOGCH_MYSQL, "[MySQL] Connection check failed: HTTP %d\n", httpCode);
+    }
     
-    Serial.printf("[MySQL] Connecting to: %s\n", url.c_str());
+    return connected;
+}
+
+// Format a Unix timestamp as MySQL DATETIME (local time). Returns false if conversion fails.
+static bool formatMySQLDateTime(unsigned long timestamp, char* buf, size_t len) {
+    time_t t = (time_t)timestamp;
+    struct tm timeinfo;
+    if (timestamp == 0 || localtime_r(&t, &timeinfo) == nullptr) {
+        return false;
+    }
+    snprintf(buf, len, "%04d-%02d-%02d %02d:%02d:%02d",
+             timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    return true;
+}
+
+// Upload several switch events with one POST /events/batch (one multi-row INSERT on the server).
+// No separate /health check: the result of the POST itself updates state.mysqlConnected.
+bool saveSwitchEventsBatchToMySQL(const SwitchEvent* events, int count) {
+    if (strlen(MYSQL_API_URL) == 0) {
+        return false; // MySQL API disabled
+    }
+    if (count <= 0) {
+        return true;
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
     
-    if (!http.begin(url)) {
-        Serial.println("[MySQL] ❌ Failed to begin HTTP connection");
+    // Build JSON payload: {"events": [{timestamp, is_on, temp_vorlauf, temp_ruecklauf, tank_liters}, ...]}
+    StaticJsonDocument<3072> doc;
+    JsonArray arr = doc.createNestedArray("events");
+    for (int i = 0; i < count; i++) {
+        const SwitchEvent& evt = events[i];
+        char timestampStr[32];
+        if (!formatMySQLDateTime(evt.timestamp, timestampStr, sizeof(timestampStr))) {
+            return false; // Caller only passes dated events
+        }
+        JsonObject obj = arr.createNestedObject();
+        obj["timestamp"] = timestampStr;
+        obj["is_on"] = evt.isOn ? 1 : 0;
+        if (!isnan(evt.tempVorlauf)) {
+            obj["temp_vorlauf"] = round(evt.tempVorlauf * 10) / 10.0;
+        }
+        if (!isnan(evt.tempRuecklauf)) {
+            obj["temp_ruecklauf"] = round(evt.tempRuecklauf * 10) / 10.0;
+        }
+        if (!isnan(evt.tankLiters)) {
+            obj["tank_liters"] = round(evt.tankLiters * 10) / 10.0;
+        }
+    }
+    if (doc.overflowed()) {
+        LOG_ERROR(LOGCH_MYSQL, "[MySQL] ❌ Batch payload too large\n");
         return false;
     }
     
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(5000); // 5 seconds timeout
-    http.setReuse(false);
+    String json;
+    serializeJson(doc, json);
+    
+    int httpCode = mysqlRequest("/events/batch", &json, nullptr, 5000, 10000);
+    bool success = (httpCode == HTTP_CODE_OK);
+    if (httpCode < 0 && httpCode != MYSQL_ERROR_BUSY) {
+        state.mysqlConnected = false;
+    }
+    
+    if (!success) {
+        LOG_WARN(LOGCH_MYSQL, "[MySQL] Failed to save %d switch event(s): HTTP %d\n", count, httpCode);
+    }
+    
+    return success;
+}
+
+// Upload one day of accumulated statistics (date_key taken from the accumulator)
+static bool uploadDailyStats(const DailyStats& day) {
+    float onSeconds = day.onMs / 1000.0f;
+    float dieselLiters = (onSeconds / 3600.0f) * state.dieselConsumptionPerHour;
+    
+    String url = String(MYSQL_API_URL) + "/stats/daily";
     
     StaticJsonDocument<512> doc;
     char dateKey[11];
-    sprintf(dateKey, "%04d-%02d-%02d", timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday);
+    snprintf(dateKey, sizeof(dateKey), "%04lu-%02lu-%02lu", (unsigned long)(day.dayKey / 10000),
+             (unsigned long)(day.dayKey / 100 % 100), (unsigned long)(day.dayKey % 100));
     
     // Build JSON exactly as PHP API expects
     doc["date_key"] = dateKey;
-    doc["switches"] = (int)stats.todaySwitches;
-    doc["on_seconds"] = (int)finalOnSeconds;
-    doc["off_seconds"] = (int)finalOffSeconds;
-    doc["diesel_liters"] = round(todayDieselLiters * 10) / 10.0;
-    doc["samples"] = sampleCount > 0 ? sampleCount : 1;
-    
-    // Set temperature statistics (as expected by PHP API)
-    if (sampleCount > 0) {
-        doc["avg_vorlauf"] = round((sumVorlauf / sampleCount) * 10) / 10.0;
-        doc["avg_ruecklauf"] = round((sumRuecklauf / sampleCount) * 10) / 10.0;
-        doc["min_vorlauf"] = round(minVorlauf * 10) / 10.0;
-        doc["max_vorlauf"] = round(maxVorlauf * 10) / 10.0;
-        doc["min_ruecklauf"] = round(minRuecklauf * 10) / 10.0;
-        doc["max_ruecklauf"] = round(maxRuecklauf * 10) / 10.0;
+    doc["switches"] = (int)day.switches;
+    doc["on_seconds"] = (int)(day.onMs / 1000);
+    doc["off_seconds"] = (int)(day.offMs / 1000);
+    doc["diesel_liters"] = round(dieselLiters * 10) / 10.0;
+    doc["samples"] = day.vorlauf.count > 0 ? (int)day.vorlauf.count : 1;
+    
+    // Set temperature statistics (PHP API expects null for missing values)
+    if (day.vorlauf.count > 0) {
+        doc["avg_vorlauf"] = round(day.vorlauf.mean * 10) / 10.0;
+        doc["min_vorlauf"] = round(day.vorlauf.min * 10) / 10.0;
+        doc["max_vorlauf"] = round(day.vorlauf.max * 10) / 10.0;
+        doc["stddev_vorlauf"] = round(day.vorlauf.stddev() * 100) / 100.0;
     } else {
-        // No temperature data - set to null (PHP API expects null for missing values)
         doc["avg_vorlauf"] = nullptr;
-        doc["avg_ruecklauf"] = nullptr;
         doc["min_vorlauf"] = nullptr;
         doc["max_vorlauf"] = nullptr;
+        doc["stddev_vorlauf"] = nullptr;
+    }
+    if (day.ruecklauf.count > 0) {
+        doc["avg_ruecklauf"] = round(day.ruecklauf.mean * 10) / 10.0;
+        doc["min_ruecklauf"] = round(day.ruecklauf.min * 10) / 10.0;
+        doc["max_ruecklauf"] = round(day.ruecklauf.max * 10) / 10.0;
+        doc["stddev_ruecklauf"] = round(day.ruecklauf.stddev() * 100) / 100.0;
+    } else {
+        doc["avg_ruecklauf"] = nullptr;
         doc["min_ruecklauf"] = nullptr;
         doc["max_ruecklauf"] = nullptr;
+        doc["stddev_ruecklauf"] = nullptr;
     }
     
     String json;
     serializeJson(doc, json);
     
-    Serial.printf("[MySQL] POST Request to: %s\n", url.c_str());
-    Serial.printf("[MySQL] JSON Payload: %s\n", json.c_str());
+    LOG_DEBUG(LOGCH_MYSQL, "[MySQL] POST Request to: %s\n", url.c_str());
+    LOG_DEBUG(LOGCH_MYSQL, "[MySQL] JSON Payload: %s\n", json.c_str());
     
-    int httpCode = http.POST(json);
-    String response = http.getString();
+    String response;
+    int httpCode = mysqlRequest("/stats/daily", &json, &response, 5000, 10000);
     
     bool success = (httpCode == HTTP_CODE_OK || httpCode == 200);
     
     if (!success) {
-        Serial.printf("[MySQL] ❌ HTTP Error %d\n", httpCode);
-        Serial.printf("[MySQL] Response: %s\n", response.c_str());
+        LOG_ERROR(LOGCH_MYSQL, "[MySQL] ❌ HTTP Error %d\n", httpCode);
+        LOG_DEBUG(LOGCH_MYSQL, "[MySQL] Response: %s\n", response.c_str());
     } else {
-        Serial.printf("[MySQL] ✅ Success! HTTP %d\n", httpCode);
-        Serial.printf("[MySQL] Response: %s\n", response.c_str());
+        LOG_INFO(LOGCH_MYSQL, "[MySQL] ✅ Success! HTTP %d\n", httpCode);
+        LOG_DEBUG(LOGCH_MYSQL, "[MySQL] Response: %s\n", response.c_str());
     }
     
-    http.end();
     return success;
 }
 
+bool saveDailyStatsToMySQL() {
+    if (strlen(MYSQL_API_URL) == 0) {
+        return false; // MySQL API disabled
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        return false; // No WiFi connection
+    }
+    
+    DailyStats today;
+    DailyStats previous;
+    bool previousPending = false;
+    dailyStatsSnapshot(today, &previous, &previousPending);
+    
+    // Finish the previous day first: its last upload may be hours old
+    if (previousPending) {
+        if ((previous.switches > 0 || previous.onMs > 0) && !uploadDailyStats(previous)) {
+            return false;
+        }
+        MutexLock lock(dailyStatsMutex);
+        if (dailyStatsPrevious.dayKey == previous.dayKey) {
+            dailyStatsPreviousPending = false;
+            dailyStatsCheckpointDue = true;
+        }
+    }
+    
+    if (today.dayKey == 0) {
+        return false; // No NTP sync yet
+    }
+    
+    // Only save to MySQL if heater actually ran (has switches or ON time)
+    if (today.switches == 0 && today.onMs == 0) {
+        LOG_INFO(LOGCH_MYSQL, "[MySQL] Skipping daily stats save - no heating activity today\n");
+        return true; // Return true to avoid retry, but don't save
+    }
+    
+    return uploadDailyStats(today);
+}
+
 bool fetchMySQLStats(StaticJsonDocument<8192>& doc) {
     // Safety checks
     if (strlen(MYSQL_API_URL) == 0) {
@@ -1689,27 +3300,15 @@ bool fetchMySQLStats(StaticJsonDocument<8192>& doc) {
     const unsigned long MAX_MYSQL_TIME_MS = 4000; // Max 4 seconds total
     
     bool hasTodayData = false;
-    bool anyRequestSuccess = false; // Track if any request succeeded
-    String baseUrl = String(MYSQL_API_URL);
+    bool anyResponse = false;       // Any answer (or client busy) counts as connected
     
-    // Fetch today's data - use separate HTTPClient for each request
+    // Fetch today's data - the three GETs share the keep-alive connection
     {
-        HTTPClient http;
-        String todayUrl = baseUrl + "/stats/today";
-        if (!http.begin(todayUrl)) {
-            return false; // Failed to begin HTTP connection
-        }
-        http.setTimeout(1500);
-        http.setConnectTimeout(1000);
-        http.setReuse(false);
-        
-        int httpCode = http.GET();
+        String payload;
+        int httpCode = mysqlRequest("/stats/today", nullptr, &payload, 1500, 1000);
+        anyResponse |= (httpCode > 0 || httpCode == MYSQL_ERROR_BUSY);
         
         if (httpCode == HTTP_CODE_OK) {
-            anyRequestSuccess = true; // At least one request succeeded
-            String payload = http.getString();
-            http.end();
-            
             StaticJsonDocument<512> todayDoc;
             DeserializationError error = deserializeJson(todayDoc, payload);
             
@@ -1745,121 +3344,769 @@ bool fetchMySQLStats(StaticJsonDocument<8192>& doc) {
                 today["samples"] = todayDoc["samples"];
                 hasTodayData = true;
             }
-        } else {
-            http.end();
         }
-    } // HTTPClient destroyed here
+    }
     
     // Check timeout before historical days request
     if (millis() - startTime > MAX_MYSQL_TIME_MS) {
         return hasTodayData;
     }
     
-    // Fetch historical days - use separate HTTPClient
+    // Fetch historical days
     {
-        HTTPClient http;
-        String daysUrl = baseUrl + "/stats/days?days=14";
-        if (http.begin(daysUrl)) {
-            http.setTimeout(1500);
-            http.setConnectTimeout(1000);
-            http.setReuse(false);
-            
-            int httpCode = http.GET();
+        String payload;
+        int httpCode = mysqlRequest("/stats/days?days=14", nullptr, &payload, 1500, 1000);
+        anyResponse |= (httpCode > 0 || httpCode == MYSQL_ERROR_BUSY);
+        if (httpCode == HTTP_CODE_OK) {
+            StaticJsonDocument<4096> daysDoc; // Reduced size
+            DeserializationError error = deserializeJson(daysDoc, payload);
             
-            if (httpCode == HTTP_CODE_OK) {
-                anyRequestSuccess = true; // At least one request succeeded
-                String payload = http.getString();
-                http.end();
-                
-                StaticJsonDocument<4096> daysDoc; // Reduced size
-                DeserializationError error = deserializeJson(daysDoc, payload);
-                
-                if (!error && daysDoc.is<JsonArray>()) {
-                    JsonArray daysArray = doc.createNestedArray("days");
-                    JsonArray mysqlDays = daysDoc.as<JsonArray>();
-                    for (JsonObject day : mysqlDays) {
-                        JsonObject dayObj = daysArray.createNestedObject();
-                        // Convert dateKey from YYYY-MM-DD to YYYYMMDD format
-                        String mysqlDateKey = day["date_key"].as<String>();
-                        mysqlDateKey.replace("-", "");
-                        dayObj["dateKey"] = mysqlDateKey;
-                        dayObj["switches"] = day["switches"];
-                        dayObj["onSeconds"] = day["on_seconds"];
-                        dayObj["offSeconds"] = day["off_seconds"];
-                        dayObj["dieselLiters"] = day["diesel_liters"];
-                        if (day.containsKey("avg_vorlauf") && !day["avg_vorlauf"].isNull()) {
-                            dayObj["avgVorlauf"] = day["avg_vorlauf"];
-                        }
-                        if (day.containsKey("avg_ruecklauf") && !day["avg_ruecklauf"].isNull()) {
-                            dayObj["avgRuecklauf"] = day["avg_ruecklauf"];
-                        }
-                        dayObj["samples"] = day["samples"];
+            if (!error && daysDoc.is<JsonArray>()) {
+                JsonArray daysArray = doc.createNestedArray("days");
+                JsonArray mysqlDays = daysDoc.as<JsonArray>();
+                for (JsonObject day : mysqlDays) {
+                    JsonObject dayObj = daysArray.createNestedObject();
+                    // Convert dateKey from YYYY-MM-DD to YYYYMMDD format
+                    String mysqlDateKey = day["date_key"].as<String>();
+                    mysqlDateKey.replace("-", "");
+                    dayObj["dateKey"] = mysqlDateKey;
+                    dayObj["switches"] = day["switches"];
+                    dayObj["onSeconds"] = day["on_seconds"];
+                    dayObj["offSeconds"] = day["off_seconds"];
+                    dayObj["dieselLiters"] = day["diesel_liters"];
+                    if (day.containsKey("avg_vorlauf") && !day["avg_vorlauf"].isNull()) {
+                        dayObj["avgVorlauf"] = day["avg_vorlauf"];
+                    }
+                    if (day.containsKey("avg_ruecklauf") && !day["avg_ruecklauf"].isNull()) {
+                        dayObj["avgRuecklauf"] = day["avg_ruecklauf"];
                     }
+                    dayObj["samples"] = day["samples"];
                 }
-            } else {
-                http.end();
             }
         }
-    } // HTTPClient destroyed here
+    }
     
     // Check timeout before events request
     if (millis() - startTime > MAX_MYSQL_TIME_MS) {
         return hasTodayData;
     }
     
-    // Fetch switch events - use separate HTTPClient
+    // Fetch switch events
     {
-        HTTPClient http;
-        String eventsUrl = baseUrl + "/events/recent?limit=20";  // Further reduced limit
-        if (http.begin(eventsUrl)) {
-            http.setTimeout(1500);
-            http.setConnectTimeout(1000);
-            http.setReuse(false);
-            
-            int httpCode = http.GET();
+        String payload;
+        int httpCode = mysqlRequest("/events/recent?limit=20", nullptr, &payload, 1500, 1000);  // Further reduced limit
+        anyResponse |= (httpCode > 0 || httpCode == MYSQL_ERROR_BUSY);
+        if (httpCode == HTTP_CODE_OK) {
+            StaticJsonDocument<3072> eventsDoc; // Reduced size
+            DeserializationError error = deserializeJson(eventsDoc, payload);
             
-            if (httpCode == HTTP_CODE_OK) {
-                anyRequestSuccess = true; // At least one request succeeded
-                String payload = http.getString();
-                http.end();
-                
-                StaticJsonDocument<3072> eventsDoc; // Reduced size
-                DeserializationError error = deserializeJson(eventsDoc, payload);
-                
-                if (!error && eventsDoc.is<JsonArray>()) {
-                    JsonArray eventsArray = doc.createNestedArray("switchEvents");
-                    JsonArray mysqlEvents = eventsDoc.as<JsonArray>();
-                    for (JsonObject event : mysqlEvents) {
-                        JsonObject eventObj = eventsArray.createNestedObject();
-                        if (event.containsKey("timestamp_unix")) {
-                            eventObj["timestamp"] = event["timestamp_unix"];
-                        }
-                        eventObj["isOn"] = event["is_on"].as<int>() == 1;
-                        if (event.containsKey("temp_vorlauf") && !event["temp_vorlauf"].isNull()) {
-                            eventObj["tempVorlauf"] = event["temp_vorlauf"];
-                        }
-                        if (event.containsKey("temp_ruecklauf") && !event["temp_ruecklauf"].isNull()) {
-                            eventObj["tempRuecklauf"] = event["temp_ruecklauf"];
-                        }
-                        if (event.containsKey("tank_liters") && !event["tank_liters"].isNull()) {
-                            eventObj["tankLiters"] = event["tank_liters"];
-                        }
+            if (!error && eventsDoc.is<JsonArray>()) {
+                JsonArray eventsArray = doc.createNestedArray("switchEvents");
+                JsonArray mysqlEvents = eventsDoc.as<JsonArray>();
+                for (JsonObject event : mysqlEvents) {
+                    JsonObject eventObj = eventsArray.createNestedObject();
+                    if (event.containsKey("timestamp_unix")) {
+                        eventObj["timestamp"] = event["timestamp_unix"];
+                    }
+                    eventObj["isOn"] = event["is_on"].as<int>() == 1;
+                    if (event.containsKey("temp_vorlauf") && !event["temp_vorlauf"].isNull()) {
+                        eventObj["tempVorlauf"] = event["temp_vorlauf"];
+                    }
+                    if (event.containsKey("temp_ruecklauf") && !event["temp_ruecklauf"].isNull()) {
+                        eventObj["tempRuecklauf"] = event["temp_ruecklauf"];
+                    }
+                    if (event.containsKey("tank_liters") && !event["tank_liters"].isNull()) {
+                        eventObj["tankLiters"] = event["tank_liters"];
                     }
                 }
-            } else {
-                http.end();
             }
         }
-    } // HTTPClient destroyed here
+    }
     
-    // Update MySQL connection status based on request success
-    state.mysqlConnected = anyRequestSuccess;
-    state.lastMySQLCheck = millis();
+    // Update MySQL connection status (mysqlRequest already marks it connected on any response)
+    if (!anyResponse) {
+        state.mysqlConnected = false;
+        state.lastMySQLCheck = millis();
+    }
     
     // Return true if we got today's data, false otherwise (will trigger fallback)
     return hasTodayData;
 }
 
+// ========== SWITCH EVENT OUTBOX (data partition) ==========
+// Store-and-forward queue for switch events that still have to reach MySQL. Every switch is appended
+// as a fixed-size, CRC-protected record to /outbox.bin before any upload is attempted, so events
+// survive MySQL/NAS downtime and reboots. The file is on the data partition, so frontend updates
+// (/update-fs, uploadfs) don't drop events that are still pending. The outbound worker drains the file in batches; the highest
+// uploaded sequence number is persisted in /outbox.ack. Once everything is acknowledged the file is
+// deleted, and it is compacted (acked and corrupt records dropped) when it fills up or at boot.
+//
+// Events recorded before NTP sync carry only the uptime and the boot id. As soon as the clock is set,
+// records of the current boot get their real timestamp written back; records from an earlier boot
+// without timestamp cannot be dated anymore and are skipped (counted as "unresolvable").
+#define OUTBOX_PATH "/outbox.bin"
+#define OUTBOX_TMP_PATH "/outbox.tmp"
+#define OUTBOX_ACK_PATH "/outbox.ack"
+#define OUTBOX_MAGIC 0x4F425831UL       // "OBX1"
+#define OUTBOX_MAX_RECORDS 1024         // 40 KB, several weeks of heating cycles
+#define OUTBOX_DRAIN_BATCH 16           // Max records per POST /events/batch
+#define OUTBOX_BATCH_MIN_COUNT 8        // Upload as soon as this many events are pending...
+#define OUTBOX_BATCH_MAX_AGE_MS 60000   // ...or the oldest pending event is this old
+
+struct OutboxRecord {
+    uint32_t magic;
+    uint32_t seq;              // Monotonic, never reused (ack is "all seq <= ackedSeq")
+    uint32_t bootId;           // Boot counter when the event was recorded
+    uint32_t timestamp;        // Unix time, 0 = not yet known (no NTP at switch time)
+    uint32_t uptimeMs;         // millis() at switch time
+    float tempVorlauf;
+    float tempRuecklauf;
+    float tankLiters;
+    uint8_t isOn;
+    uint8_t reserved[3];
+    uint32_t crc;              // CRC32 over all preceding bytes
+};
+static_assert(sizeof(OutboxRecord) == 40, "OutboxRecord layout is stored on flash");
+
+struct OutboxAck {
+    uint32_t ackedSeq;
+    uint32_t crc;
+};
+
+SemaphoreHandle_t outboxMutex = nullptr;
+bool outboxReady = false;              // Data partition mounted and outbox initialized
+uint32_t outboxBootId = 0;
+uint32_t outboxNextSeq = 1;
+uint32_t outboxAckedSeq = 0;
+uint32_t outboxRecordCount = 0;        // Records in the file (acked or not)
+uint32_t outboxPending = 0;            // Records not yet uploaded
+uint32_t outboxReadOffset = 0;         // File offset of the first unacknowledged record
+uint32_t outboxGeneration = 0;         // Incremented on compaction (file offsets become invalid)
+
+struct OutboxStats {
+    uint32_t appended = 0;
+    uint32_t uploaded = 0;
+    uint32_t dropped = 0;              // Outbox full even after compaction
+    uint32_t corrupt = 0;              // CRC/magic mismatch (e.g. torn write on power loss)
+    uint32_t unresolvable = 0;         // No timestamp and recorded in an earlier boot
+    uint32_t resolved = 0;             // Timestamps rewritten after NTP sync
+    uint32_t batches = 0;              // Successful POST /events/batch requests
+} outboxStats;
+unsigned long outboxOldestPendingMs = 0;  // millis() when the oldest pending event was queued
+bool outboxDrainDeferred = false;         // Last drain failed or waits for NTP: hold off for a while
+unsigned long outboxDeferredSinceMs = 0;
+
+static uint32_t outboxRecordCrc(const OutboxRecord& rec) {
+    return crc32_le(0, (const uint8_t*)&rec, offsetof(OutboxRecord, crc));
+}
+
+static bool outboxRecordValid(const OutboxRecord& rec) {
+    return rec.magic == OUTBOX_MAGIC && rec.crc == outboxRecordCrc(rec);
+}
+
+static void outboxSaveAckLocked() {
+    OutboxAck ack;
+    ack.ackedSeq = outboxAckedSeq;
+    ack.crc = crc32_le(0, (const uint8_t*)&ack.ackedSeq, sizeof(ack.ackedSeq));
+    File f = dataFs->open(OUTBOX_ACK_PATH, FILE_WRITE);
+    if (f) {
+        f.write((const uint8_t*)&ack, sizeof(ack));
+        f.close();
+    }
+}
+
+static uint32_t outboxLoadAck() {
+    OutboxAck ack;
+    File f = dataFs->open(OUTBOX_ACK_PATH, FILE_READ);
+    if (!f) {
+        return 0;
+    }
+    size_t n = f.read((uint8_t*)&ack, sizeof(ack));
+    f.close();
+    if (n != sizeof(ack) || ack.crc != crc32_le(0, (const uint8_t*)&ack.ackedSeq, sizeof(ack.ackedSeq))) {
+        serialLogLn("[Outbox] ⚠️ Ack file corrupt, pending events may be uploaded twice");
+        return 0;
+    }
+    return ack.ackedSeq;
+}
+
+// Rewrite the outbox with only valid, unacknowledged records (caller holds outboxMutex, outbound worker or setup())
+static void outboxCompactLocked() {
+    File src = dataFs->open(OUTBOX_PATH, FILE_READ);
+    uint32_t kept = 0;
+    if (src) {
+        File dst = dataFs->open(OUTBOX_TMP_PATH, FILE_WRITE);
+        OutboxRecord rec;
+        while (src.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+            if (!outboxRecordValid(rec) || rec.seq <= outboxAckedSeq) {
+                continue;
+            }
+            if (dst) {
+                dst.write((const uint8_t*)&rec, sizeof(rec));
+            }
+            kept++;
+        }
+        src.close();
+        if (dst) {
+            dst.close();
+        }
+        if (kept > 0) {
+            // LittleFS rename replaces the old file atomically: a power cut leaves either file complete
+            dataFs->rename(OUTBOX_TMP_PATH, OUTBOX_PATH);
+        } else {
+            dataFs->remove(OUTBOX_TMP_PATH);
+            dataFs->remove(OUTBOX_PATH);
+        }
+    }
+    outboxRecordCount = kept;
+    outboxPending = kept;
+    outboxReadOffset = 0;
+    outboxGeneration++;
+}
+
+// Called from setup() after initDataPartition(): recover state from flash
+void initOutbox() {
+    outboxMutex = xSemaphoreCreateMutex();
+    
+    prefs.begin("outbox", false);
+    outboxBootId = prefs.getUInt("bootId", 0) + 1;
+    prefs.putUInt("bootId", outboxBootId);
+    prefs.end();
+    
+    outboxAckedSeq = outboxLoadAck();
+    
+    // Interrupted compaction: the temp file is only complete if the outbox itself is gone
+    if (dataFs->exists(OUTBOX_TMP_PATH)) {
+        if (!dataFs->exists(OUTBOX_PATH)) {
+            dataFs->rename(OUTBOX_TMP_PATH, OUTBOX_PATH);
+        } else {
+            dataFs->remove(OUTBOX_TMP_PATH);
+        }
+    }
+    
+    uint32_t records = 0, pending = 0, corrupt = 0, lastSeq = outboxAckedSeq;
+    bool tornTail = false;
+    File f = dataFs->open(OUTBOX_PATH, FILE_READ);
+    if (f) {
+        tornTail = (f.size() % sizeof(OutboxRecord)) != 0;
+        OutboxRecord rec;
+        while (f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+            records++;
+            if (!outboxRecordValid(rec)) {
+                corrupt++;
+                continue;
+            }
+            if (rec.seq > lastSeq) lastSeq = rec.seq;
+            if (rec.seq > outboxAckedSeq) pending++;
+        }
+        f.close();
+    }
+    
+    outboxNextSeq = lastSeq + 1;
+    outboxRecordCount = records;
+    outboxPending = pending;
+    outboxReadOffset = 0;
+    outboxStats.corrupt = corrupt;
+    outboxOldestPendingMs = millis() - OUTBOX_BATCH_MAX_AGE_MS;  // Left over from before reboot: send on first chance
+    outboxReady = true;
+    
+    if (records > 0 && (corrupt > 0 || tornTail || pending < records)) {
+        // Drop acked/corrupt records so the drain starts at offset 0
+        outboxCompactLocked();
+    }
+    
+    serialLogF("[Outbox] Boot #%lu, %lu pending event(s), %lu corrupt record(s) discarded\n",
+               (unsigned long)outboxBootId, (unsigned long)outboxPending, (unsigned long)corrupt);
+}
+
+// Runs on the outbound worker (see persistSwitchRecords()), never on the control task
+bool outboxAppend(const SwitchEvent& evt) {
+    if (!outboxReady || strlen(MYSQL_API_URL) == 0) {
+        return false;
+    }
+    
+    MutexLock lock(outboxMutex);
+    if (outboxRecordCount >= OUTBOX_MAX_RECORDS) {
+        outboxCompactLocked();
+        if (outboxRecordCount >= OUTBOX_MAX_RECORDS) {
+            outboxStats.dropped++;
+            serialLogLn("[Outbox] ⚠️ Outbox full, switch event not stored");
+            return false;
+        }
+    }
+    
+    OutboxRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = OUTBOX_MAGIC;
+    rec.seq = outboxNextSeq;
+    rec.bootId = outboxBootId;
+    rec.timestamp = (uint32_t)evt.timestamp;
+    rec.uptimeMs = (uint32_t)evt.uptimeMs;
+    rec.tempVorlauf = evt.tempVorlauf;
+    rec.tempRuecklauf = evt.tempRuecklauf;
+    rec.tankLiters = evt.tankLiters;
+    rec.isOn = evt.isOn ? 1 : 0;
+    rec.crc = outboxRecordCrc(rec);
+    
+    File f = dataFs->open(OUTBOX_PATH, FILE_APPEND);
+    if (!f || f.write((const uint8_t*)&rec, sizeof(rec)) != sizeof(rec)) {
+        if (f) f.close();
+        outboxStats.dropped++;
+        serialLogLn("[Outbox] ❌ Write failed, switch event not stored");
+        return false;
+    }
+    f.close();
+    
+    if (outboxPending == 0) {
+        outboxOldestPendingMs = millis();
+    }
+    outboxNextSeq++;
+    outboxRecordCount++;
+    outboxPending++;
+    outboxStats.appended++;
+    return true;
+}
+
+// Derive the wall-clock time of an uptime-only record of the current boot (0 if not possible)
+static uint32_t outboxResolveTimestamp(const OutboxRecord& rec) {
+    if (rec.timestamp != 0) {
+        return rec.timestamp;
+    }
+    if (rec.bootId != outboxBootId || !state.ntpSynced) {
+        return 0;
+    }
+    time_t now = time(nullptr);
+    uint32_t ageSec = (millis() - rec.uptimeMs) / 1000;
+    return (uint32_t)now - ageSec;
+}
+
+// After NTP sync: write real timestamps into pending records of this boot, so they can still
+// be uploaded after a reboot
+void outboxResolveTimestamps() {
+    if (!outboxReady || outboxPending == 0) {
+        return;
+    }
+    MutexLock lock(outboxMutex);
+    File f = dataFs->open(OUTBOX_PATH, "r+");
+    if (!f) {
+        return;
+    }
+    uint32_t offset = outboxReadOffset;
+    OutboxRecord rec;
+    while (f.seek(offset) && f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+        if (outboxRecordValid(rec) && rec.timestamp == 0 && rec.bootId == outboxBootId) {
+            rec.timestamp = outboxResolveTimestamp(rec);
+            if (rec.timestamp != 0) {
+                rec.crc = outboxRecordCrc(rec);
+                f.seek(offset);
+                f.write((const uint8_t*)&rec, sizeof(rec));
+                outboxStats.resolved++;
+            }
+        }
+        offset += sizeof(rec);
+    }
+    f.close();
+}
+
+// Upload the next batch of pending events (runs on the outbound worker).
+// Returns false only if an upload failed, so the job is retried with backoff.
+bool drainOutboxBatch() {
+    if (!outboxReady) {
+        return true;
+    }
+    
+    OutboxRecord batch[OUTBOX_DRAIN_BATCH];
+    int count = 0;
+    uint32_t generation;
+    uint32_t nextOffset;
+    {
+        MutexLock lock(outboxMutex);
+        generation = outboxGeneration;
+        nextOffset = outboxReadOffset;
+        File f = dataFs->open(OUTBOX_PATH, FILE_READ);
+        if (f) {
+            f.seek(nextOffset);
+            OutboxRecord rec;
+            while (count < OUTBOX_DRAIN_BATCH && f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+                if (!outboxRecordValid(rec)) {
+                    outboxStats.corrupt++;
+                    continue;
+                }
+                if (rec.seq > outboxAckedSeq) {
+                    batch[count++] = rec;
+                }
+            }
+            f.close();
+        }
+    }
+    
+    if (count == 0) {
+        MutexLock lock(outboxMutex);
+        outboxPending = 0; // Nothing left in the file (e.g. only corrupt records)
+        return true;
+    }
+    
+    // Collect the leading run of records that can be sent now
+    static SwitchEvent events[OUTBOX_DRAIN_BATCH];  // Only used by the outbound worker
+    int eventCount = 0;
+    int processed = 0;
+    uint32_t unresolvable = 0;
+    uint32_t lastAcked = 0;
+    bool waitingForTime = false;
+    for (int i = 0; i < count; i++) {
+        const OutboxRecord& rec = batch[i];
+        uint32_t timestamp = outboxResolveTimestamp(rec);
+        if (timestamp == 0) {
+            if (rec.bootId == outboxBootId) {
+                waitingForTime = true; // Same boot: retry after NTP sync
+                break;
+            }
+            unresolvable++;
+        } else {
+            SwitchEvent& evt = events[eventCount++];
+            evt.timestamp = timestamp;
+            evt.isOn = rec.isOn != 0;
+            evt.tempVorlauf = rec.tempVorlauf;
+            evt.tempRuecklauf = rec.tempRuecklauf;
+            evt.uptimeMs = rec.uptimeMs;
+            evt.tankLiters = rec.tankLiters;
+        }
+        lastAcked = rec.seq;
+        processed++;
+    }
+    
+    // Upload outside the lock: outboxResolveTimestamps() on the network task must never wait for the network
+    bool uploadFailed = false;
+    if (eventCount > 0 && !saveSwitchEventsBatchToMySQL(events, eventCount)) {
+        uploadFailed = true;
+        processed = 0; // Nothing acknowledged, the whole batch is retried
+    } else {
+        outboxStats.uploaded += eventCount;
+        outboxStats.unresolvable += unresolvable;
+        if (eventCount > 0) {
+            outboxStats.batches++;
+            queueStatsRefresh(); // MySQL history changed
+        }
+    }
+    
+    bool morePending = false;
+    if (processed > 0) {
+        MutexLock lock(outboxMutex);
+        if (lastAcked > outboxAckedSeq) {
+            outboxAckedSeq = lastAcked;
+            outboxPending = (outboxPending > (uint32_t)processed) ? outboxPending - processed : 0;
+            outboxSaveAckLocked();
+        }
+        
+        if (outboxPending == 0) {
+            // Fully drained: start over with an empty file
+            dataFs->remove(OUTBOX_PATH);
+            outboxRecordCount = 0;
+            outboxReadOffset = 0;
+            outboxGeneration++;
+        } else if (generation == outboxGeneration) {
+            // Skip past acknowledged records for the next batch
+            File f = dataFs->open(OUTBOX_PATH, FILE_READ);
+            if (f) {
+                OutboxRecord rec;
+                f.seek(nextOffset);
+                while (f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+                    if (outboxRecordValid(rec) && rec.seq > outboxAckedSeq) {
+                        break;
+                    }
+                    nextOffset += sizeof(rec);
+                }
+                f.close();
+            }
+            outboxReadOffset = nextOffset;
+        } else {
+            outboxReadOffset = 0; // Compacted meanwhile: file only contains unacked records
+        }
+        morePending = outboxPending > 0;
+        outboxOldestPendingMs = millis(); // Age of the remaining events counts from this drain
+    }
+    
+    outboxDrainDeferred = uploadFailed || waitingForTime;
+    outboxDeferredSinceMs = millis();
+    if (morePending && !outboxDrainDeferred) {
+        queueOutboxDrain();
+    }
+    return !uploadFailed;
+}
+
+// ========== OUTBOUND HTTP WORKER ==========
+// All outgoing HTTP calls triggered by control logic (switch events, daily stats, Telegram, weather)
+// are queued as typed jobs and executed by one background worker task. Switch events go through the
+// persistent outbox above; the queue only carries "drain the next batch" jobs for them. Callers such as setHeater()
+// only copy a job into the FreeRTOS queue and return immediately; failed jobs are retried with
+// exponential backoff, and if the queue is full the new job is dropped (counted in /api/status).
+// Jobs waiting for their backoff sit in a small retry list outside the queue; the worker blocks in
+// xQueueReceive() until a new job arrives or the earliest retry is due, so queued jobs never wait behind one.
+// setHeater() hands new switch events over through switchRecordQueue; the worker appends them to the
+// switch journal and the outbox (including compactions), so the control task never waits for flash or outboxMutex.
+#define OUTBOUND_QUEUE_DEPTH 12
+#define SWITCH_RECORD_QUEUE_DEPTH 16       // Switch events waiting for the worker (minutes apart in practice)
+#define OUTBOUND_MAX_ATTEMPTS 4            // First try + 3 retries
+#define OUTBOUND_RETRY_BASE_MS 5000        // Backoff: 5s, 10s, 20s
+#define OUTBOUND_RETRY_SLOTS 6             // Failed jobs waiting for their backoff (worker-local)
+#define OUTBOUND_TEXT_LEN 384              // Max Telegram message length (bytes, UTF-8)
+
+enum OutboundJobType : uint8_t {
+    JOB_OUTBOX_DRAIN = 0,   // Upload the next batch of switch events from the outbox
+    JOB_DAILY_STATS = 1,    // Upload today's statistics to MySQL
+    JOB_TELEGRAM = 2,       // Send a Telegram message
+    JOB_WEATHER = 3,        // Refresh weather cache (Open-Meteo + reverse geocoding)
+    JOB_STATS_REFRESH = 4,  // Rebuild the /api/stats-history cache (MySQL history + local stats)
+    JOB_SWITCH_RECORDS = 5  // Persist the switch events waiting in switchRecordQueue
+};
+
+struct OutboundJob {
+    OutboundJobType type = JOB_OUTBOX_DRAIN;
+    uint8_t attempts = 0;
+    bool forceRefresh = false;          // JOB_WEATHER: also refetch location name
+    unsigned long notBeforeMs = 0;      // Retry backoff deadline
+    char text[OUTBOUND_TEXT_LEN] = {0}; // JOB_TELEGRAM
+};
+
+struct OutboundStats {
+    volatile uint32_t enqueued = 0;
+    volatile uint32_t completed = 0;
+    volatile uint32_t retried = 0;
+    volatile uint32_t failed = 0;     // Gave up after OUTBOUND_MAX_ATTEMPTS
+    volatile uint32_t dropped = 0;    // Queue or retry list full
+} outboundStats;
+
+QueueHandle_t outboundQueue = nullptr;
+QueueHandle_t switchRecordQueue = nullptr;
+TaskHandle_t outboundWorkerHandle = nullptr;
+static volatile bool switchRecordsQueued = false;
+static volatile bool weatherRefreshQueued = false;  // Avoid stacking weather jobs from page reloads
+static volatile bool outboxDrainQueued = false;
+
+static const char* outboundJobName(OutboundJobType type) {
+    switch (type) {
+        case JOB_OUTBOX_DRAIN: return "outbox-drain";
+        case JOB_DAILY_STATS: return "daily-stats";
+        case JOB_TELEGRAM: return "telegram";
+        case JOB_WEATHER: return "weather";
+        case JOB_STATS_REFRESH: return "stats-refresh";
+        case JOB_SWITCH_RECORDS: return "switch-records";
+    }
+    return "?";
+}
+
+// Non-blocking enqueue (never waits for queue space)
+bool enqueueOutbound(const OutboundJob& job) {
+    if (!outboundQueue) {
+        return false;
+    }
+    if (xQueueSendToBack(outboundQueue, &job, 0) != pdTRUE) {
+        outboundStats.dropped++;
+        serialLogF("[Outbound] ⚠️ Queue full, dropped %s job\n", outboundJobName(job.type));
+        return false;
+    }
+    outboundStats.enqueued++;
+    return true;
+}
+
+bool queueOutboxDrain() {
+    if (strlen(MYSQL_API_URL) == 0 || !outboxReady) {
+        return false;
+    }
+    if (outboxDrainQueued) {
+        return true; // One drain job at a time, it re-queues itself while records are pending
+    }
+    OutboundJob job;
+    job.type = JOB_OUTBOX_DRAIN;
+    if (!enqueueOutbound(job)) {
+        return false;
+    }
+    outboxDrainQueued = true;
+    return true;
+}
+
+// One persist job at a time; the network task re-queues it if records are left waiting
+static bool queueSwitchRecordsJob() {
+    if (switchRecordsQueued) {
+        return true;
+    }
+    OutboundJob job;
+    job.type = JOB_SWITCH_RECORDS;
+    if (!enqueueOutbound(job)) {
+        return false;
+    }
+    switchRecordsQueued = true;
+    return true;
+}
+
+// Called by setHeater() under ControlLock: copies the event, never touches flash
+bool queueSwitchRecord(const SwitchEvent& evt) {
+    if (!switchRecordQueue) {
+        return false;
+    }
+    if (xQueueSendToBack(switchRecordQueue, &evt, 0) != pdTRUE) {
+        outboxStats.dropped++;
+        serialLogLn("[Outbox] ⚠️ Switch record queue full, switch event not stored");
+        return false;
+    }
+    queueSwitchRecordsJob();
+    return true;
+}
+
+static void persistSwitchRecords() {
+    switchRecordsQueued = false;  // Records added from here on queue a new job
+    SwitchEvent evt;
+    while (xQueueReceive(switchRecordQueue, &evt, 0) == pdTRUE) {
+        saveSwitchEvent(evt);
+        outboxAppend(evt);
+    }
+}
+
+// Called from the network task: picks up records whose job was dropped (outbound queue full)
+void checkSwitchRecords() {
+    if (switchRecordQueue && uxQueueMessagesWaiting(switchRecordQueue) > 0) {
+        queueSwitchRecordsJob();
+    }
+}
+
+bool queueDailyStatsUpload() {
+    if (strlen(MYSQL_API_URL) == 0) {
+        return false; // MySQL API disabled
+    }
+    OutboundJob job;
+    job.type = JOB_DAILY_STATS;
+    return enqueueOutbound(job);
+}
+
+void sendTelegramMessage(String message) {
+    if (!isTelegramConfigured()) {
+        serialLogLn("[Telegram] Not configured, skipping notification");
+        return;
+    }
+    OutboundJob job;
+    job.type = JOB_TELEGRAM;
+    strlcpy(job.text, message.c_str(), sizeof(job.text));
+    enqueueOutbound(job);
+}
+
+bool queueWeatherRefresh(bool forceRefresh) {
+    if (weatherRefreshQueued && !forceRefresh) {
+        return true;
+    }
+    OutboundJob job;
+    job.type = JOB_WEATHER;
+    job.forceRefresh = forceRefresh;
+    if (!enqueueOutbound(job)) {
+        return false;
+    }
+    weatherRefreshQueued = true;
+    return true;
+}
+
+static bool runOutboundJob(const OutboundJob& job) {
+    switch (job.type) {
+        case JOB_OUTBOX_DRAIN:
+            outboxDrainQueued = false;
+            return drainOutboxBatch();
+        case JOB_DAILY_STATS:
+            return saveDailyStatsToMySQL();
+        case JOB_TELEGRAM:
+            return deliverTelegramMessage(String(job.text));
+        case JOB_WEATHER: {
+            weatherRefreshQueued = false;
+            doFetchWeatherData(job.forceRefresh);
+            MutexLock lock(weatherMutex);
+            return weather.valid;
+        }
+        case JOB_STATS_REFRESH:
+            refreshStatsCache();
+            return true; // Falls back to local data by itself, no retry
+        case JOB_SWITCH_RECORDS:
+            persistSwitchRecords();
+            return true; // Write errors are counted per record, no retry
+    }
+    return true;
+}
+
+// Worker-only: failed jobs until their backoff has elapsed
+static OutboundJob outboundRetries[OUTBOUND_RETRY_SLOTS];
+static uint8_t outboundRetryCount = 0;
+
+// Run one job; on failure keep it for a retry with exponential backoff
+static void runOutboundJobWithRetry(OutboundJob& job) {
+    if (runOutboundJob(job)) {
+        outboundStats.completed++;
+        return;
+    }
+    
+    job.attempts++;
+    if (job.attempts >= OUTBOUND_MAX_ATTEMPTS) {
+        outboundStats.failed++;
+        serialLogF("[Outbound] ❌ %s job failed after %u attempts\n", outboundJobName(job.type), job.attempts);
+        return;
+    }
+    if (outboundRetryCount >= OUTBOUND_RETRY_SLOTS) {
+        outboundStats.dropped++;
+        serialLogF("[Outbound] ⚠️ Retry list full, dropped %s job\n", outboundJobName(job.type));
+        return;
+    }
+    job.notBeforeMs = millis() + (OUTBOUND_RETRY_BASE_MS << (job.attempts - 1));
+    outboundStats.retried++;
+    outboundRetries[outboundRetryCount++] = job;
+}
+
+// Ticks until the earliest retry is due (portMAX_DELAY without retries)
+static TickType_t outboundRetryWaitTicks() {
+    TickType_t wait = portMAX_DELAY;
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < outboundRetryCount; i++) {
+        long waitMs = (long)(outboundRetries[i].notBeforeMs - now);
+        // Round up, so the worker doesn't wake a tick early and spin
+        TickType_t ticks = waitMs > 0 ? pdMS_TO_TICKS(waitMs) + 1 : 0;
+        if (ticks < wait) wait = ticks;
+    }
+    return wait;
+}
+
+static void outboundWorkerTask(void* arg) {
+    (void)arg;
+    // Static: the job is large and the worker stack is needed for TLS (Telegram/Nominatim)
+    static OutboundJob job;
+    for (;;) {
+        // Sleep until a new job arrives or the earliest backoff elapses; new jobs run right away
+        if (xQueueReceive(outboundQueue, &job, outboundRetryWaitTicks()) == pdTRUE) {
+            runOutboundJobWithRetry(job);
+        }
+        
+        // Retries that are due (a job that fails again goes back to the end of the list, not yet due)
+        uint8_t i = 0;
+        while (i < outboundRetryCount) {
+            if ((long)(outboundRetries[i].notBeforeMs - millis()) > 0) {
+                i++;
+                continue;
+            }
+            job = outboundRetries[i];
+            outboundRetries[i] = outboundRetries[--outboundRetryCount];
+            runOutboundJobWithRetry(job);
+        }
+    }
+}
+
+// Queue is created early in setup() (setHeater() may enqueue before the worker runs)
+void initOutboundQueue() {
+    if (!outboundQueue) {
+        outboundQueue = xQueueCreate(OUTBOUND_QUEUE_DEPTH, sizeof(OutboundJob));
+    }
+    if (!switchRecordQueue) {
+        switchRecordQueue = xQueueCreate(SWITCH_RECORD_QUEUE_DEPTH, sizeof(SwitchEvent));
+    }
+}
+
+void startOutboundWorker() {
+    // Core 0 next to the WiFi stack, lowest priority: it only ever waits on sockets
+    xTaskCreatePinnedToCore(outboundWorkerTask, "outbound", 16384, nullptr, 1, &outboundWorkerHandle, 0);
+}
+
 // Load relay configuration early in setup, before configuring GPIO directions.
 // This reduces the time the relay input might be left in a wrong state after a reset.
 void loadRelayConfigEarly() {
@@ -1901,6 +4148,10 @@ void saveSettings() {
     prefs.putBool("frostEnabled", state.frostProtectionEnabled);
     prefs.putFloat("frostTemp", state.frostProtectionTemp);
     
+    // Save DS18B20 resolution
+    prefs.putUChar("s1Res", state.sensor1Resolution);
+    prefs.putUChar("s2Res", state.sensor2Resolution);
+    
     // Save tank configuration
     prefs.putFloat("tankHeight", state.tankHeight);
     prefs.putFloat("tankCapacity", state.tankCapacity);
@@ -1934,6 +4185,7 @@ void saveSettings() {
     
     prefs.end();
     
+    stateConfigDirty = true;  // Push new configuration to /ws/state clients
     Serial.println("Settings saved to NVS");
 }
 
@@ -1986,249 +4238,1122 @@ bool setupWiFi() {
         serialLog("Connecting");
         WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
         
-        // Wait for connection with progress indication
-        unsigned long startTime = millis();
-        int dotCount = 0;
+        // Wait for connection with progress indication
+        unsigned long startTime = millis();
+        int dotCount = 0;
+        
+        while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < WIFI_TIMEOUT_MS) {
+            delay(500);
+            serialLog(".");
+            dotCount++;
+            
+            if (dotCount % 10 == 0) {
+                int elapsed = (millis() - startTime) / 1000;
+                int remaining = (WIFI_TIMEOUT_MS - (millis() - startTime)) / 1000;
+                serialLogF(" (%ds / %ds remaining)", elapsed, remaining);
+                serialLogLn("");
+                serialLog("Still connecting");
+            }
+        }
+        serialLogLn("");
+        
+        // Check connection status
+        if (WiFi.status() == WL_CONNECTED) {
+            connected = true;
+            
+            // Wait a bit to ensure connection is stable
+            delay(1000);
+            
+            // Verify connection is still active
+            if (WiFi.status() == WL_CONNECTED && WiFi.localIP() != IPAddress(0,0,0,0)) {
+                serialLogLn("✅ WiFi connected successfully!");
+                serialLogF("   IP Address: %s\n", WiFi.localIP().toString().c_str());
+                serialLogF("   Gateway:    %s\n", WiFi.gatewayIP().toString().c_str());
+                serialLogF("   Subnet:     %s\n", WiFi.subnetMask().toString().c_str());
+                serialLogF("   RSSI:       %d dBm\n", WiFi.RSSI());
+                
+                // Additional stability delay
+                delay(1000);
+                return true;
+            } else {
+                serialLogLn("⚠️ Connection lost immediately after connect");
+                connected = false;
+            }
+        } else {
+            serialLogF("❌ Connection attempt %d failed\n", retry + 1);
+            serialLogF("   WiFi status: %d\n", WiFi.status());
+        }
+    }
+    
+    // All attempts failed
+    serialLogLn("❌ WiFi connection FAILED after all attempts!");
+    serialLogLn("WiFi Diagnostics:");
+    // WiFi.printDiag sends directly to Serial - capture it manually
+    Serial.print("WiFi Diagnostics: ");
+    WiFi.printDiag(Serial);
+    Serial.println();
+    serialLogF("SSID tried: '%s'\n", WIFI_SSID);
+    serialLogF("Password length: %d\n", strlen(WIFI_PASSWORD));
+    serialLogF("MAC Address: %s\n", WiFi.macAddress().c_str());
+    
+    return false;
+}
+
+// ========== ACCESS POINT MODE ==========
+void setupAccessPoint() {
+    state.apModeActive = true;
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(AP_SSID, AP_PASSWORD);
+    
+    Serial.println("Access Point Mode activated");
+    Serial.printf("AP SSID: %s\n", AP_SSID);
+    Serial.printf("AP Password: %s\n", AP_PASSWORD);
+    Serial.print("AP IP: ");
+    Serial.println(WiFi.softAPIP());
+}
+
+// ========== mDNS SETUP ==========
+void setupMDNS() {
+    if (MDNS.begin(HOSTNAME)) {
+        Serial.printf("mDNS responder started: http://%s.local/\n", HOSTNAME);
+        MDNS.addService("http", "tcp", 80);
+    } else {
+        Serial.println("Error setting up mDNS responder!");
+    }
+}
+
+// ========== NTP SETUP ==========
+void setupNTP() {
+    configTzTime(TIMEZONE, NTP_SERVER);
+    Serial.println("NTP time sync initiated");
+    
+    struct tm timeinfo;
+    if (getLocalTime(&timeinfo, 5000)) {
+        state.ntpSynced = true;
+        Serial.printf("NTP synced! Current time: %02d:%02d:%02d\n", 
+                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    } else {
+        Serial.println("NTP time sync pending...");
+        state.ntpSynced = false;
+    }
+}
+
+// ========== STATS HISTORY CACHE ==========
+// /api/stats-history used to query MySQL (up to three blocking GETs) inside the web server callback.
+// The response is now built by the outbound worker - on a timer, after every switch event and after
+// switch events were uploaded - and the handler only sends the cached body. The ETag is the CRC32 of
+// the body, so unchanged statistics are answered with 304 Not Modified. The body is shared with the
+// responses still sending it (copied straight into the TCP buffer, never duplicated per request) and
+// replaced as a whole on refresh, so concurrent requests cost no extra heap.
+#define STATS_CACHE_REFRESH_MS 60000
+#define STATS_CACHE_MAX_JSON 16384    // Text limit; the document itself is bounded by its 8 KB pool
+
+struct StatsCache {
+    std::shared_ptr<const String> body;   // Serialized JSON, null until the first build
+    String etag;
+    unsigned long builtMs = 0;
+    uint32_t buildMs = 0;          // Duration of the last build (incl. MySQL requests)
+    uint32_t builds = 0;
+    uint32_t requests = 0;
+    uint32_t notModified = 0;      // Requests answered with 304
+} statsCache;
+SemaphoreHandle_t statsCacheMutex = nullptr;
+static volatile bool statsRefreshQueued = false;
+
+// Build the stats-history document (MySQL history if available, otherwise local data).
+// Runs on the outbound worker only.
+static void buildStatsHistory(StaticJsonDocument<8192>& doc) {
+    // Try to fetch from MySQL (with safety checks)
+    bool mysqlSuccess = false;
+    if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
+        // Try MySQL fetch with timeout protection
+        mysqlSuccess = fetchMySQLStats(doc);
+        doc["mysqlAvailable"] = state.mysqlConnected;
+    } else {
+        doc["mysqlAvailable"] = false;
+    }
+    
+    // Return current statistics for aggregation (always from local stats)
+    doc["switchCount"] = stats.switchCount;
+    doc["todaySwitches"] = stats.todaySwitches;
+    doc["onTimeSeconds"] = stats.onTimeSeconds;
+    doc["offTimeSeconds"] = stats.offTimeSeconds;
+    
+    // Calculate total diesel consumption (from total ON time)
+    float totalDieselLiters = (stats.onTimeSeconds / 3600.0) * state.dieselConsumptionPerHour;
+    doc["totalDieselLiters"] = round(totalDieselLiters * 10) / 10.0;
+    
+    // If MySQL fetch failed, fall back to the local daily accumulators
+    if (!mysqlSuccess || !doc.containsKey("today")) {
+        JsonObject today = doc.createNestedObject("today");
+        DailyStats day;
+        dailyStatsSnapshot(day);
+        if (day.dayKey != 0) {
+            char dateKey[9];
+            snprintf(dateKey, sizeof(dateKey), "%08lu", (unsigned long)day.dayKey);
+            today["dateKey"] = dateKey;
+            today["switches"] = day.switches;
+            today["onSeconds"] = (unsigned long)(day.onMs / 1000);
+            today["offSeconds"] = (unsigned long)(day.offMs / 1000);
+            
+            // Calculate diesel consumption (liters = hours * consumption per hour)
+            float todayDieselLiters = (day.onMs / 3600000.0) * state.dieselConsumptionPerHour;
+            today["dieselLiters"] = round(todayDieselLiters * 10) / 10.0;
+            
+            // Temperature statistics over every reading of the day
+            if (day.vorlauf.count > 0) {
+                today["avgVorlauf"] = round(day.vorlauf.mean * 10) / 10.0;
+                today["minVorlauf"] = round(day.vorlauf.min * 10) / 10.0;
+                today["maxVorlauf"] = round(day.vorlauf.max * 10) / 10.0;
+                today["stddevVorlauf"] = round(day.vorlauf.stddev() * 100) / 100.0;
+            } else {
+                today["avgVorlauf"] = nullptr;
+                today["minVorlauf"] = nullptr;
+                today["maxVorlauf"] = nullptr;
+            }
+            if (day.ruecklauf.count > 0) {
+                today["avgRuecklauf"] = round(day.ruecklauf.mean * 10) / 10.0;
+                today["minRuecklauf"] = round(day.ruecklauf.min * 10) / 10.0;
+                today["maxRuecklauf"] = round(day.ruecklauf.max * 10) / 10.0;
+                today["stddevRuecklauf"] = round(day.ruecklauf.stddev() * 100) / 100.0;
+            } else {
+                today["avgRuecklauf"] = nullptr;
+                today["minRuecklauf"] = nullptr;
+                today["maxRuecklauf"] = nullptr;
+            }
+            today["samples"] = day.vorlauf.count;
+        } else {
+            today["dateKey"] = "";
+            today["switches"] = 0;
+            today["onSeconds"] = 0;
+            today["offSeconds"] = 0;
+            today["avgVorlauf"] = nullptr;
+            today["avgRuecklauf"] = nullptr;
+            today["samples"] = 0;
+        }
+    }
+    
+    // If MySQL didn't provide days array, create empty one
+    if (!doc.containsKey("days")) {
+        JsonArray daysArray = doc.createNestedArray("days");
+    }
+    
+    // If MySQL didn't provide switch events, use local events
+    // Limit to prevent JSON document overflow
+    if (!doc.containsKey("switchEvents")) {
+        JsonArray eventsArray = doc.createNestedArray("switchEvents");
+        // Last 30 events, oldest first (limit prevents document overflow)
+        const int MAX_EVENTS_TO_SEND = 30;
+        ControlLock lock;
+        SwitchEventCursor cursor(MAX_EVENTS_TO_SEND);
+        for (const SwitchEvent* next = cursor.next(); next != nullptr; next = cursor.next()) {
+            const SwitchEvent& evt = *next;
+            JsonObject eventObj = eventsArray.createNestedObject();
+            if (evt.timestamp > 0) {
+                eventObj["timestamp"] = evt.timestamp;
+            } else {
+                eventObj["timestamp"] = nullptr;
+            }
+            eventObj["isOn"] = evt.isOn;
+            eventObj["uptimeMs"] = evt.uptimeMs;
+            if (!isnan(evt.tempVorlauf)) {
+                eventObj["tempVorlauf"] = round(evt.tempVorlauf * 10) / 10.0;
+            } else {
+                eventObj["tempVorlauf"] = nullptr;
+            }
+            if (!isnan(evt.tempRuecklauf)) {
+                eventObj["tempRuecklauf"] = round(evt.tempRuecklauf * 10) / 10.0;
+            } else {
+                eventObj["tempRuecklauf"] = nullptr;
+            }
+            if (!isnan(evt.tankLiters)) {
+                eventObj["tankLiters"] = round(evt.tankLiters * 10) / 10.0;
+            } else {
+                eventObj["tankLiters"] = nullptr;
+            }
+        }
+    }
+    
+}
+
+void refreshStatsCache() {
+    statsRefreshQueued = false;
+    // Static: 8 KB would not fit next to the HTTP client on the worker stack
+    static StaticJsonDocument<8192> doc;
+    doc.clear();
+    unsigned long start = millis();
+    buildStatsHistory(doc);
+    
+    std::shared_ptr<String> json = std::make_shared<String>();
+    size_t jsonSize = measureJson(doc);
+    if (jsonSize == 0 || jsonSize >= STATS_CACHE_MAX_JSON || doc.overflowed() || !json->reserve(jsonSize)) {
+        // Keep serving the previous snapshot
+        serialLogF("[Stats] JSON too large: %d bytes, keeping cached stats\n", jsonSize);
+        MutexLock lock(statsCacheMutex);
+        statsCache.builtMs = millis(); // Retry on the next timer tick, not immediately
+        return;
+    }
+    serializeJson(doc, *json);
+    
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)crc32_le(0, (const uint8_t*)json->c_str(), json->length()));
+    
+    MutexLock lock(statsCacheMutex);
+    statsCache.body = json;
+    statsCache.etag = etag;
+    statsCache.builtMs = millis();
+    statsCache.buildMs = statsCache.builtMs - start;
+    statsCache.builds++;
+}
+
+bool queueStatsRefresh() {
+    if (statsRefreshQueued) {
+        return true;
+    }
+    OutboundJob job;
+    job.type = JOB_STATS_REFRESH;
+    if (!enqueueOutbound(job)) {
+        return false;
+    }
+    statsRefreshQueued = true;
+    return true;
+}
+
+// ========== LIVE STATE PUSH (/ws/state) ==========
+// Dashboards subscribe to /ws/state instead of polling /api/status every second. The status is split
+// into live values (temperatures, relays, counters, tank) and static configuration (thresholds,
+// schedules, relay setup, location). A client gets a full snapshot on connect; after that the
+// housekeeping task sends only the live fields that changed, at most once per STATE_PUSH_INTERVAL_MS.
+// Configuration is resent only after settings were saved. Messages carry a sequence number; a client
+// that detects a gap (AsyncWebSocket drops messages for slow clients) sends "snapshot" to resync,
+// and a full keyframe goes out every STATE_KEYFRAME_MS anyway.
+//
+//   {"type":"snapshot","seq":1,"live":{...},"config":{...}}
+//   {"type":"delta","seq":2,"live":{"uptime":3601,"tempVorlauf":48.6}}
+//   {"type":"config","seq":3,"config":{...}}
+#define STATE_PUSH_INTERVAL_MS 1000
+#define STATE_KEYFRAME_MS 30000
+
+AsyncWebSocket wsState("/ws/state");
+volatile bool stateSnapshotRequested = false;  // New client or resync request
+volatile bool stateConfigDirty = false;        // Settings saved since the last push
+uint32_t stateSeq = 0;
+StaticJsonDocument<768> stateLastLive;         // Live values as last sent (housekeeping task only)
+
+// Live values: everything that changes while the controller runs
+void buildLiveState(JsonDocument& doc) {
+    // Temperatures
+    if (isnan(state.tempVorlauf)) {
+        doc["tempVorlauf"] = nullptr;
+    } else {
+        doc["tempVorlauf"] = round(state.tempVorlauf * 10) / 10.0;
+    }
+    
+    if (isnan(state.tempRuecklauf)) {
+        doc["tempRuecklauf"] = nullptr;
+    } else {
+        doc["tempRuecklauf"] = round(state.tempRuecklauf * 10) / 10.0;
+    }
+    
+    doc["heating"] = state.heatingOn;
+    doc["pump"] = state.pumpOn;
+    doc["pumpManualMode"] = state.pumpManualMode;
+    doc["mode"] = state.mode;
+    doc["rssi"] = WiFi.RSSI();
+    doc["apMode"] = state.apModeActive;
+    doc["uptime"] = state.uptime;
+    doc["ntpSynced"] = state.ntpSynced;
+    
+    // Current time
+    int hour, minute;
+    if (getCurrentTime(hour, minute)) {
+        char timeStr[6];
+        sprintf(timeStr, "%02d:%02d", hour, minute);
+        doc["currentTime"] = timeStr;
+    }
+    
+    // Temperature difference & efficiency
+    if (!isnan(state.tempVorlauf) && !isnan(state.tempRuecklauf)) {
+        float diff = state.tempVorlauf - state.tempRuecklauf;
+        doc["tempDiff"] = round(diff * 10) / 10.0;
+        
+        // Efficiency: optimal is 10-15°C difference
+        float efficiency = 0;
+        if (diff >= 10 && diff <= 15) {
+            efficiency = 100;
+        } else if (diff > 15) {
+            efficiency = 100 - ((diff - 15) * 5);  // Decrease above 15
+        } else if (diff > 0) {
+            efficiency = (diff / 10.0) * 100;  // Scale 0-10 to 0-100
+        }
+        efficiency = max(0.0f, min(100.0f, efficiency));
+        doc["efficiency"] = (int)efficiency;
+    }
+    
+    // Statistics
+    doc["switchCount"] = stats.switchCount;
+    doc["todaySwitches"] = stats.todaySwitches;
+    doc["onTimeSeconds"] = stats.onTimeSeconds;
+    doc["offTimeSeconds"] = stats.offTimeSeconds;
+    doc["behaviorWarning"] = state.behaviorWarningActive;
+    
+    // Tank level
+    doc["tankAvailable"] = state.tankSensorAvailable;
+    if (state.tankSensorAvailable) {
+        doc["tankDistance"] = round(state.tankDistance * 10) / 10.0;
+        doc["tankLiters"] = round(state.tankLiters * 10) / 10.0;
+        doc["tankPercent"] = state.tankPercent;
+        doc["tankConfidence"] = state.tankConfidence;
+    } else {
+        doc["tankDistance"] = nullptr;
+        doc["tankLiters"] = nullptr;
+        doc["tankPercent"] = nullptr;
+        doc["tankConfidence"] = nullptr;
+    }
+}
+
+// Static configuration: only changes through /api/settings, /api/location etc.
+void buildConfigState(JsonDocument& doc) {
+    doc["version"] = FIRMWARE_VERSION;
+    doc["tempOn"] = state.tempOn;
+    doc["tempOff"] = state.tempOff;
+    doc["relayActiveLow"] = true;
+    doc["heaterRelayActiveLow"] = state.heaterRelayActiveLow;
+    doc["pumpRelayActiveLow"] = state.pumpRelayActiveLow;
+    doc["heaterRelayOffMode"] = state.heaterRelayOffMode;
+    doc["pumpRelayOffMode"] = state.pumpRelayOffMode;
+    
+    // Frost protection
+    doc["frostEnabled"] = state.frostProtectionEnabled;
+    doc["frostTemp"] = state.frostProtectionTemp;
+    
+    // Sensor resolution
+    doc["sensor1Resolution"] = state.sensor1Resolution;
+    doc["sensor2Resolution"] = state.sensor2Resolution;
+    
+    // Tank geometry / consumption
+    doc["tankHeight"] = state.tankHeight;
+    doc["tankCapacity"] = state.tankCapacity;
+    doc["dieselConsumptionPerHour"] = state.dieselConsumptionPerHour;
+    
+    // Location
+    doc["latitude"] = state.latitude;
+    doc["longitude"] = state.longitude;
+    
+    // Location name (prefer saved name, then weather location name)
+    if (state.locationName.length() > 0 && state.locationName != "Unbekannter Ort") {
+        doc["locationName"] = state.locationName;
+    } else {
+        MutexLock lock(weatherMutex);
+        if (weather.locationName.length() > 0 && weather.locationName != "Unbekannter Ort") {
+            doc["locationName"] = weather.locationName;
+        }
+    }
+    
+    // Schedules
+    JsonArray schedArray = doc.createNestedArray("schedules");
+    for (int i = 0; i < MAX_SCHEDULES; i++) {
+        JsonObject sched = schedArray.createNestedObject();
+        sched["enabled"] = state.schedules[i].enabled;
+        
+        char startTime[6], endTime[6];
+        sprintf(startTime, "%02d:%02d", state.schedules[i].startHour, state.schedules[i].startMinute);
+        sprintf(endTime, "%02d:%02d", state.schedules[i].endHour, state.schedules[i].endMinute);
+        
+        sched["start"] = startTime;
+        sched["end"] = endTime;
+    }
+}
+
+void onStateSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
+                        AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        stateSnapshotRequested = true;  // Sent by the housekeeping task on its next run
+    } else if (type == WS_EVT_DATA) {
+        AwsFrameInfo *info = (AwsFrameInfo*)arg;
+        if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT &&
+            len == 8 && memcmp(data, "snapshot", 8) == 0) {
+            stateSnapshotRequested = true;
+        }
+    }
+}
+
+// Same value? Compared in serialized form (numbers, strings, null)
+static bool stateValueEquals(JsonVariantConst a, JsonVariantConst b) {
+    char bufA[40], bufB[40];
+    serializeJson(a, bufA, sizeof(bufA));
+    serializeJson(b, bufB, sizeof(bufB));
+    return strcmp(bufA, bufB) == 0;
+}
+
+// Called from the housekeeping task
+void publishLiveState() {
+    static unsigned long lastPush = 0;
+    static unsigned long lastKeyframe = 0;
+    static StaticJsonDocument<768> live;
+    static StaticJsonDocument<2048> msg;
+    
+    unsigned long now = millis();
+    if (wsState.count() == 0) {
+        stateSnapshotRequested = false;  // Next client triggers a fresh snapshot anyway
+        return;
+    }
+    bool snapshot = stateSnapshotRequested || now - lastKeyframe >= STATE_KEYFRAME_MS;
+    if (!snapshot && now - lastPush < STATE_PUSH_INTERVAL_MS) {
+        return;
+    }
+    lastPush = now;
+    
+    live.clear();
+    buildLiveState(live);
+    msg.clear();
+    
+    if (snapshot) {
+        stateSnapshotRequested = false;
+        stateConfigDirty = false;
+        lastKeyframe = now;
+        msg["type"] = "snapshot";
+        msg["seq"] = ++stateSeq;
+        msg["live"] = live.as<JsonObjectConst>();
+        JsonObject config = msg.createNestedObject("config");
+        StaticJsonDocument<1024> configDoc;
+        buildConfigState(configDoc);
+        config.set(configDoc.as<JsonObjectConst>());
+    } else {
+        JsonObject changes = msg.createNestedObject("live");
+        JsonObjectConst last = stateLastLive.as<JsonObjectConst>();
+        for (JsonPairConst kv : live.as<JsonObjectConst>()) {
+            if (!last.containsKey(kv.key().c_str()) || !stateValueEquals(kv.value(), last[kv.key().c_str()])) {
+                changes[kv.key().c_str()] = kv.value();
+            }
+        }
+        // Fields that disappeared (e.g. tempDiff after a sensor fault) are sent as null
+        for (JsonPairConst kv : last) {
+            if (!live.containsKey(kv.key().c_str())) {
+                changes[kv.key().c_str()] = nullptr;
+            }
+        }
+        
+        if (stateConfigDirty) {
+            stateConfigDirty = false;
+            StaticJsonDocument<1024> configDoc;
+            buildConfigState(configDoc);
+            msg.createNestedObject("config").set(configDoc.as<JsonObjectConst>());
+        }
+        
+        if (changes.size() == 0 && !msg.containsKey("config")) {
+            return;  // Nothing changed: no message at all
+        }
+        msg["type"] = msg.containsKey("config") ? "config" : "delta";
+        msg["seq"] = ++stateSeq;
+    }
+    
+    stateLastLive.set(live.as<JsonObjectConst>());
+    
+    String json;
+    serializeJson(msg, json);
+    wsState.textAll(json);
+}
+
+// ========== TASK SCHEDULER (FreeRTOS) ==========
+// The firmware runs as four periodic FreeRTOS tasks instead of one Arduino loop(), so a slow HTTP call
+// can no longer delay relay decisions:
+// - control:      pump cooldown, failsafe, frost/auto/schedule control (highest priority, app core)
+// - sensing:      DS18B20 conversions and ultrasonic bursts (feeds the control task)
+// - network:      MySQL health check, daily stats upload, NTP sync, WiFi reconnect (protocol core)
+// - housekeeping: WebSocket flushing/cleanup and scheduled reboot
+// Each task records run time, release jitter and deadline overruns (exposed via /api/tasks).
+struct ScheduledTask {
+    const char* name;
+    void (*body)();
+    uint32_t periodMs;
+    uint32_t deadlineMs;      // Run time budget; exceeding it counts as overrun
+    UBaseType_t priority;
+    BaseType_t core;
+    uint32_t stackSize;
+    
+    // Runtime (written by the task itself, read by /api/tasks)
+    TaskHandle_t handle = nullptr;
+    volatile uint32_t runs = 0;
+    volatile uint32_t overruns = 0;
+    volatile uint32_t lastRunUs = 0;
+    volatile uint32_t maxRunUs = 0;
+    volatile uint32_t lastJitterUs = 0;
+    volatile uint32_t maxJitterUs = 0;
+    volatile uint64_t totalRunUs = 0;
+};
+
+void controlTask();
+void sensingTask();
+void networkTask();
+void housekeepingTask();
+
+ScheduledTask scheduledTasks[] = {
+    // name,          body,             period, deadline, prio, core, stack
+    { "control",      controlTask,      50,     20,       5,    1,    8192 },
+    { "sensing",      sensingTask,      20,     15,       4,    1,    6144 },
+    { "network",      networkTask,      1000,   1000,     2,    0,    8192 },
+    { "housekeeping", housekeepingTask, 20,     20,       1,    1,    6144 },
+};
+const int SCHEDULED_TASK_COUNT = sizeof(scheduledTasks) / sizeof(scheduledTasks[0]);
+
+static void schedulerTaskEntry(void* arg) {
+    ScheduledTask* task = (ScheduledTask*)arg;
+    const TickType_t periodTicks = pdMS_TO_TICKS(task->periodMs);
+    const int64_t periodUs = (int64_t)task->periodMs * 1000;
+    TickType_t lastWake = xTaskGetTickCount();
+    int64_t releaseUs = esp_timer_get_time();  // Scheduled start of the current run
+    
+    for (;;) {
+        int64_t startUs = esp_timer_get_time();
+        uint32_t jitterUs = (uint32_t)llabs(startUs - releaseUs);
+        
+        task->body();
+        
+        int64_t endUs = esp_timer_get_time();
+        uint32_t runUs = (uint32_t)(endUs - startUs);
+        task->runs++;
+        task->lastRunUs = runUs;
+        task->totalRunUs += runUs;
+        if (runUs > task->maxRunUs) task->maxRunUs = runUs;
+        task->lastJitterUs = jitterUs;
+        if (jitterUs > task->maxJitterUs) task->maxJitterUs = jitterUs;
+        if (runUs > task->deadlineMs * 1000UL) {
+            task->overruns++;
+        }
+        
+        releaseUs += periodUs;
+        if (endUs >= releaseUs) {
+            // Missed the next release: resynchronize instead of running back-to-back to catch up
+            lastWake = xTaskGetTickCount();
+            releaseUs = endUs + periodUs;
+        }
+        vTaskDelayUntil(&lastWake, periodTicks);
+    }
+}
+
+void startScheduler() {
+    for (int i = 0; i < SCHEDULED_TASK_COUNT; i++) {
+        ScheduledTask& task = scheduledTasks[i];
+        BaseType_t ok = xTaskCreatePinnedToCore(schedulerTaskEntry, task.name, task.stackSize, &task,
+                                                task.priority, &task.handle, task.core);
+        if (ok != pdPASS) {
+            serialLogF("[Scheduler] ❌ Failed to start task '%s'\n", task.name);
+        } else {
+            serialLogF("[Scheduler] Task '%s' started (period %lums, prio %u, core %d)\n",
+                       task.name, (unsigned long)task.periodMs, (unsigned)task.priority, (int)task.core);
+        }
+    }
+}
+
+// Control/safety: only relay decisions, never waits for network or sensors
+void controlTask() {
+    unsigned long now = millis();
+    state.uptime = (now - bootTime) / 1000;
+    
+    ControlLock lock;
+    
+    // Relay read-back of the last switch (recorded by setHeater()/setPump())
+    checkRelayReadback();
+    
+    // Handle pump cooldown logic
+    handlePumpCooldown();
+    
+    // New temperatures from the sensing task (once per TEMP_READ_INTERVAL)
+    if (temperaturesUpdated) {
+        temperaturesUpdated = false;
+        
+        // Update statistics
+        updateStatistics();
+        
+        checkFailsafe();
+        
+        // Frost protection has highest priority
+        if (state.frostProtectionEnabled) {
+            frostProtection();
+        }
+        // Then normal modes
+        else if (state.mode == "auto") {
+            automaticControl();
+        } else if (state.mode == "schedule") {
+            scheduleControl();
+        }
+    }
+}
+
+// Sensing: start/collect DS18B20 conversions and drive the ultrasonic burst
+void sensingTask() {
+    unsigned long now = millis();
+    
+    // Start a DS18B20 conversion every TEMP_READ_INTERVAL (returns immediately)
+    if (now - lastTempRead >= TEMP_READ_INTERVAL && tempPhase == TEMP_IDLE) {
+        lastTempRead = now;
+        startTemperatureConversion();
+    }
+    
+    // Collect results once the conversion deadline has passed and hand them to the control task
+    if (collectTemperatures()) {
+        temperaturesUpdated = true;
+        timeSeriesSample();
+    }
+    
+    // Start a tank burst every 5 seconds (echoes are captured by interrupt)
+    if (now - lastTankRead >= TANK_READ_INTERVAL) {
+        lastTankRead = now;
+        startTankBurst();
+    }
+    
+    // Advance the burst and update the level once it is complete (never waits for an echo)
+    updateTankLevel();
+}
+
+// Network I/O: everything that may block on sockets
+void networkTask() {
+    unsigned long now = millis();
+    
+    // Sync NTP if not yet synced
+    if (!state.ntpSynced && !state.apModeActive) {
+        struct tm timeinfo;
+        if (getLocalTime(&timeinfo, 0)) {
+            state.ntpSynced = true;
+            Serial.println("NTP time synced!");
+        }
+    }
+    
+    // Check MySQL connection status every 30 seconds (if MySQL is enabled)
+    if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
+        if (now - state.lastMySQLCheck >= 30000) { // 30 seconds
+            checkMySQLConnection();
+        }
+    }
+    
+    // Date switch events recorded before NTP sync, then keep draining the outbox
+    static bool outboxTimesResolved = false;
+    if (state.ntpSynced && !outboxTimesResolved) {
+        outboxResolveTimestamps();
+        outboxTimesResolved = true;
+    }
+    // Write the last completed minute to the time series store
+    timeSeriesFlush();
+    dailyStatsCheckpoint();
+    
+    // Periodic stats-history cache refresh (today's ON time grows while heating)
+    if (statsCache.builtMs == 0 || now - statsCache.builtMs >= STATS_CACHE_REFRESH_MS) {
+        queueStatsRefresh();
+    }
+    
+    // Switch events still waiting for the outbound worker
+    checkSwitchRecords();
+    
+    // Batch trigger: enough events pending, or the oldest one has waited long enough
+    if (outboxPending > 0 && WiFi.status() == WL_CONNECTED &&
+        (!outboxDrainDeferred || now - outboxDeferredSinceMs >= OUTBOX_BATCH_MAX_AGE_MS) &&
+        (outboxPending >= OUTBOX_BATCH_MIN_COUNT || now - outboxOldestPendingMs >= OUTBOX_BATCH_MAX_AGE_MS)) {
+        queueOutboxDrain();
+    }
+    
+    // Save daily stats to MySQL every 5 minutes (if MySQL is enabled)
+    static unsigned long lastDailyStatsSave = 0;
+    if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
+        if (now - lastDailyStatsSave >= 300000) { // 5 minutes
+            queueDailyStatsUpload();
+            lastDailyStatsSave = now;
+        }
+    }
+    
+    // WiFi reconnect logic - but NOT during OTA update or scheduled reboot
+    if (!state.apModeActive && 
+        !otaUpdateInProgress && 
+        !rebootScheduled && 
+        WiFi.status() != WL_CONNECTED &&
+        (now - lastWiFiReconnectAttempt) >= WIFI_RECONNECT_INTERVAL) {
+        Serial.println("WiFi lost, attempting reconnect...");
+        lastWiFiReconnectAttempt = now;
+        // Don't block - just try once, will retry later if needed
+        WiFi.disconnect();
+        delay(100);
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        // Give it a few seconds to connect before next check
+        lastWiFiReconnectAttempt = now - (WIFI_RECONNECT_INTERVAL - 5000);
+    }
+}
+
+// Housekeeping: WebSocket log flushing, client cleanup, scheduled reboot
+void housekeepingTask() {
+    unsigned long now = millis();
+    
+    // Format queued log events, then flush pending WebSocket messages
+    drainLogEvents();
+    flushWebSocketMessages();
+    
+    // Cleanup disconnected WebSocket clients (once per second is plenty)
+    static unsigned long lastCleanup = 0;
+    if (now - lastCleanup >= 1000) {
+        lastCleanup = now;
+        ws.cleanupClients();
+        wsState.cleanupClients();
+    }
+    
+    // Push live status to /ws/state subscribers (rate-limited inside)
+    publishLiveState();
+    
+    // Handle scheduled reboot after OTA update
+    if (rebootScheduled && now >= scheduledRebootTime) {
+        Serial.println("=== Executing scheduled reboot after OTA update ===");
+        Serial.println("Closing all connections...");
+        
+        // Close all WebSocket connections
+        ws.closeAll();
+        wsState.closeAll();
+        delay(100);
+        
+        // Stop the web server gracefully
+        Serial.println("Stopping server...");
+        server.end();
+        delay(500);
+        
+        // CRITICAL: Reset WiFi state before reboot to ensure clean connection on next boot
+        // Complete WiFi reset - setupWiFi() will handle everything fresh
+        WiFi.persistent(false);  // Don't save anything
+        WiFi.disconnect(true);   // Erase all stored credentials
+        WiFi.mode(WIFI_OFF);     // Turn WiFi OFF
+        delay(200);
+        Serial.println("WiFi completely reset for clean boot");
+        
+        // Flush all serial output
+        Serial.flush();
+        delay(500);
+        
+        Serial.println("Rebooting in 1 second...");
+        delay(1000);
+        Serial.flush();
         
-        while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < WIFI_TIMEOUT_MS) {
-            delay(500);
-            serialLog(".");
-            dotCount++;
-            
-            if (dotCount % 10 == 0) {
-                int elapsed = (millis() - startTime) / 1000;
-                int remaining = (WIFI_TIMEOUT_MS - (millis() - startTime)) / 1000;
-                serialLogF(" (%ds / %ds remaining)", elapsed, remaining);
-                serialLogLn("");
-                serialLog("Still connecting");
-            }
+        ESP.restart();
+    }
+}
+
+// ========== STREAMING JSON RESPONSES ==========
+// request->send(200, "application/json", json) keeps the document, the serialized String and the
+// response's own copy of it alive at the same time. Large responses instead keep only the document
+// (owned by the response via shared_ptr) and serialize it chunk by chunk into the TCP send buffer:
+// every chunk the web server asks for is a fresh serializeJson() pass through a window that keeps
+// bytes [index, index + maxLen) and drops the rest. A 2 KB status needs two or three passes; the
+// Content-Length comes from measureJson(), so no chunked encoding is needed.
+class JsonWindowPrint : public Print {
+public:
+    JsonWindowPrint(uint8_t* out, size_t skip, size_t room) : out(out), skip(skip), room(room) {}
+    
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+    
+    size_t write(const uint8_t* buf, size_t len) override {
+        size_t from = pos;
+        pos += len;
+        if (pos <= skip || from >= skip + room) {
+            return len;              // Entirely outside the window
         }
-        serialLogLn("");
-        
-        // Check connection status
-        if (WiFi.status() == WL_CONNECTED) {
-            connected = true;
-            
-            // Wait a bit to ensure connection is stable
-            delay(1000);
-            
-            // Verify connection is still active
-            if (WiFi.status() == WL_CONNECTED && WiFi.localIP() != IPAddress(0,0,0,0)) {
-                serialLogLn("✅ WiFi connected successfully!");
-                serialLogF("   IP Address: %s\n", WiFi.localIP().toString().c_str());
-                serialLogF("   Gateway:    %s\n", WiFi.gatewayIP().toString().c_str());
-                serialLogF("   Subnet:     %s\n", WiFi.subnetMask().toString().c_str());
-                serialLogF("   RSSI:       %d dBm\n", WiFi.RSSI());
-                
-                // Additional stability delay
-                delay(1000);
-                return true;
-            } else {
-                serialLogLn("⚠️ Connection lost immediately after connect");
-                connected = false;
+        size_t a = from < skip ? skip - from : 0;
+        size_t b = min(len, skip + room - from);
+        memcpy(out + (from + a - skip), buf + a, b - a);
+        copied = max(copied, from + b - skip);
+        return len;
+    }
+    
+    uint8_t* out;
+    size_t skip;
+    size_t room;
+    size_t pos = 0;
+    size_t copied = 0;
+};
+
+AsyncWebServerResponse *beginJsonResponse(AsyncWebServerRequest *request, std::shared_ptr<JsonDocument> doc) {
+    return request->beginResponse("application/json", measureJson(*doc),
+        [doc](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            JsonWindowPrint window(buffer, index, maxLen);
+            serializeJson(*doc, window);
+            return window.copied;
+        });
+}
+
+// ========== STATIC ASSETS (LittleFS) ==========
+// The filesystem image comes from scripts/build_fs.py: text files are stored gzip-compressed as
+// "<file>.gz" (AsyncFileResponse falls back to it and adds Content-Encoding: gzip) and index.html
+// links CSS/JS as "<asset>?v=<content hash>". At boot every asset gets a strong ETag (CRC32 and size
+// of the stored bytes), so a revalidation is answered with 304 without reading flash. A URL is cached
+// for a year as immutable only if its "v" matches the content hash of this image (/asset-versions,
+// written by build_fs.py); everything else, including stale or made-up versions, is revalidated on
+// every use (no-cache), which keeps index.html and sw.js current after a /update-fs upload.
+// /asset-manifest.json (also generated) is the precache list of the service worker (data/sw.js).
+struct StaticAsset {
+    const char* url;
+    const char* path;
+    const char* contentType;
+    char etag[24];          // Quoted; empty if the file is missing
+    bool gzip;              // Stored as path + ".gz"
+    uint32_t size;          // Stored (transfer) size
+    char version[16];       // Content hash of this image ("?v="), empty if not versioned
+};
+
+StaticAsset staticAssets[] = {
+    { "/", "/index.html", "text/html" },
+    { "/index.html", "/index.html", "text/html" },
+    { "/manifest.json", "/manifest.json", "application/json" },
+    { "/sw.js", "/sw.js", "application/javascript" },
+    { "/asset-manifest.json", "/asset-manifest.json", "application/json" },
+    { "/assets/css/style.css", "/assets/css/style.css", "text/css" },
+    { "/assets/js/script.js", "/assets/js/script.js", "application/javascript" },
+};
+const int STATIC_ASSET_COUNT = sizeof(staticAssets) / sizeof(staticAssets[0]);
+
+#define STATIC_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#define STATIC_CACHE_REVALIDATE "no-cache"
+#define STATIC_VERSIONS_PATH "/asset-versions"   // "<url> <hash>" per line, not compressed
+
+// Versions of the assets index.html links with "?v=" (missing in an image built without build_fs.py)
+static void loadStaticAssetVersions() {
+    char buf[256];
+    File f = LittleFS.open(STATIC_VERSIONS_PATH, "r");
+    if (!f) {
+        return;
+    }
+    size_t len = f.read((uint8_t*)buf, sizeof(buf) - 1);
+    f.close();
+    buf[len] = '\0';
+    char* save = nullptr;
+    for (char* line = strtok_r(buf, "\n", &save); line; line = strtok_r(nullptr, "\n", &save)) {
+        char* hash = strchr(line, ' ');
+        if (!hash) {
+            continue;
+        }
+        *hash++ = '\0';
+        for (int i = 0; i < STATIC_ASSET_COUNT; i++) {
+            if (strcmp(staticAssets[i].url, line) == 0) {
+                strlcpy(staticAssets[i].version, hash, sizeof(staticAssets[i].version));
             }
-        } else {
-            serialLogF("❌ Connection attempt %d failed\n", retry + 1);
-            serialLogF("   WiFi status: %d\n", WiFi.status());
         }
     }
-    
-    // All attempts failed
-    serialLogLn("❌ WiFi connection FAILED after all attempts!");
-    serialLogLn("WiFi Diagnostics:");
-    // WiFi.printDiag sends directly to Serial - capture it manually
-    Serial.print("WiFi Diagnostics: ");
-    WiFi.printDiag(Serial);
-    Serial.println();
-    serialLogF("SSID tried: '%s'\n", WIFI_SSID);
-    serialLogF("Password length: %d\n", strlen(WIFI_PASSWORD));
-    serialLogF("MAC Address: %s\n", WiFi.macAddress().c_str());
-    
-    return false;
 }
 
-// ========== ACCESS POINT MODE ==========
-void setupAccessPoint() {
-    state.apModeActive = true;
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(AP_SSID, AP_PASSWORD);
-    
-    Serial.println("Access Point Mode activated");
-    Serial.printf("AP SSID: %s\n", AP_SSID);
-    Serial.printf("AP Password: %s\n", AP_PASSWORD);
-    Serial.print("AP IP: ");
-    Serial.println(WiFi.softAPIP());
+void initStaticAssets() {
+    uint8_t buf[512];
+    for (int i = 0; i < STATIC_ASSET_COUNT; i++) {
+        StaticAsset& asset = staticAssets[i];
+        asset.etag[0] = '\0';
+        asset.version[0] = '\0';
+        asset.gzip = !LittleFS.exists(asset.path) && LittleFS.exists(String(asset.path) + ".gz");
+        File f = LittleFS.open(asset.gzip ? String(asset.path) + ".gz" : String(asset.path), "r");
+        if (!f) {
+            serialLogF("[Assets] ⚠️ %s missing\n", asset.path);
+            continue;
+        }
+        uint32_t crc = 0;
+        size_t n;
+        while ((n = f.read(buf, sizeof(buf))) > 0) {
+            crc = crc32_le(crc, buf, n);
+        }
+        asset.size = f.size();
+        f.close();
+        snprintf(asset.etag, sizeof(asset.etag), "\"%08lx-%lx\"", (unsigned long)crc, (unsigned long)asset.size);
+        serialLogF("[Assets] %s: %lu bytes%s, ETag %s\n", asset.url, (unsigned long)asset.size,
+                   asset.gzip ? " (gzip)" : "", asset.etag);
+    }
+    loadStaticAssetVersions();
 }
 
-// ========== mDNS SETUP ==========
-void setupMDNS() {
-    if (MDNS.begin(HOSTNAME)) {
-        Serial.printf("mDNS responder started: http://%s.local/\n", HOSTNAME);
-        MDNS.addService("http", "tcp", 80);
+static void serveStaticAsset(AsyncWebServerRequest *request, const StaticAsset& asset) {
+    if (asset.etag[0] == '\0') {
+        request->send(404, "text/plain", "Not found");
+        return;
+    }
+    // Immutable only for the version this image serves: an old or unknown "v" must not pin the
+    // current content in the browser cache for a year
+    bool currentVersion = asset.version[0] != '\0' && request->hasParam("v") &&
+                          request->getParam("v")->value() == asset.version;
+    const char* cacheControl = currentVersion ? STATIC_CACHE_IMMUTABLE : STATIC_CACHE_REVALIDATE;
+    AsyncWebServerResponse *response;
+    AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+    if (ifNoneMatch && ifNoneMatch->value().indexOf(asset.etag) >= 0) {
+        response = request->beginResponse(304);
     } else {
-        Serial.println("Error setting up mDNS responder!");
+        response = request->beginResponse(LittleFS, asset.path, asset.contentType);
     }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
 }
 
-// ========== NTP SETUP ==========
-void setupNTP() {
-    configTzTime(TIMEZONE, NTP_SERVER);
-    Serial.println("NTP time sync initiated");
+#ifdef BENCH_ENABLED
+// ========== MICROBENCHMARKS (env:esp32dev_bench) ==========
+// POST /api/bench starts one run in a low-priority task on the app core (preempted by the control
+// task, so usMin is the undisturbed figure); GET /api/bench returns the last results. Each result is
+// also logged as "[Bench] {json}" (same format as "program bench" on the host). The cases use the
+// live state but never switch relays; the log-append case overwrites the log history and the
+// persistence cases write /bench.tmp and the "bench" NVS namespace, both removed afterwards.
+#define BENCH_MAX_CASES 8
+
+BenchResult benchResults[BENCH_MAX_CASES];
+volatile int benchResultCount = 0;
+volatile bool benchRunning = false;
+uint32_t benchRunsCompleted = 0;
+
+// /api/status payload as served (live + config state, serialized into a String)
+static void benchCaseStatusJson(void* ctx) {
+    (void)ctx;
+    StaticJsonDocument<2048> doc;
+    buildLiveState(doc);
+    buildConfigState(doc);
+    String json;
+    serializeJson(doc, json);
+}
+
+static void benchCaseAggregateLocked(void* ctx) {
+    ControlLock lock;
+    benchCaseAggregate(ctx);
+}
+
+static void benchCaseUnusualBehaviorLocked(void* ctx) {
+    ControlLock lock;
+    benchCaseUnusualBehavior(ctx);
+}
+
+// Structured log event -> text (the drain side of logEvent())
+static void benchCaseLogFormat(void* ctx) {
+    const LogEventSlot& slot = *(const LogEventSlot*)ctx;
+    char line[LOG_LINE_MAX];
+    logFormatEvent(slot, line, sizeof(line));
+}
+
+// One complete line into the WebSocket log ring (what serialLog() does besides the UART write)
+static void benchCaseLogAppend(void* ctx) {
+    (void)ctx;
+    static const char text[] = "[Bench] Switch #1234: Heater ON - GPIO16: LOW (OUTPUT)";
+    MutexLock lock(logMutex);
+    memcpy(logLine, text, sizeof(text) - 1);
+    logLineLen = sizeof(text) - 1;
+    logLineChannel = LOGCH_AUTO;
+    logCommitLine();
+}
+
+static void benchTask(void* arg) {
+    (void)arg;
+    BenchAggregateCtx aggregateCtx;
+    benchAggregateInit(aggregateCtx, state.ntpSynced ? time(nullptr) : 0, millis());
+    
+    LogEventSlot logSlot;
+    logSlot.fmt = LOGF_HEATER_SET;
+    logSlot.argc = 3;
+    logSlot.args[0] = logArg("ON");
+    logSlot.args[1] = logArg((unsigned int)HEATING_RELAY_PIN);
+    logSlot.args[2] = logArg("LOW (OUTPUT)");
+    
+    BenchPersistCtx persistCtx = {};
+    persistCtx.path = "/bench.tmp";
+    persistCtx.nvsNamespace = "bench";
+    hal::fsRemove(persistCtx.path);
+    
+    struct Case {
+        const char* name;
+        uint32_t iterations;
+        BenchFn fn;
+        void* ctx;
+    };
+    const Case cases[] = {
+        { "status_json", 200, benchCaseStatusJson, nullptr },
+        { "switch_aggregate_7d", 1000, benchCaseAggregateLocked, &aggregateCtx },
+        { "unusual_behavior", 2000, benchCaseUnusualBehaviorLocked, nullptr },
+        { "log_event_format", 2000, benchCaseLogFormat, &logSlot },
+        { "log_line_append", 1000, benchCaseLogAppend, nullptr },
+        { "fs_append_36b", 200, benchCaseFsAppend, &persistCtx },
+        { "nvs_put_36b", 80, benchCaseNvsPut, &persistCtx },
+    };
+    static_assert(sizeof(cases) / sizeof(cases[0]) <= BENCH_MAX_CASES, "too many bench cases");
+    
+    char line[256];
+    for (const Case& c : cases) {
+        BenchResult r = benchRun(c.name, c.iterations, c.fn, c.ctx);
+        benchResults[benchResultCount] = r;
+        benchResultCount = benchResultCount + 1;
+        benchFormat(r, "esp32", line, sizeof(line));
+        serialLogF("[Bench] %s\n", line);
+    }
     
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo, 5000)) {
-        state.ntpSynced = true;
-        Serial.printf("NTP synced! Current time: %02d:%02d:%02d\n", 
-                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-    } else {
-        Serial.println("NTP time sync pending...");
-        state.ntpSynced = false;
+    hal::fsRemove(persistCtx.path);
+    Preferences benchPrefs;
+    if (benchPrefs.begin("bench", false)) {
+        benchPrefs.clear();
+        benchPrefs.end();
+    }
+    benchRunsCompleted++;
+    benchRunning = false;
+    vTaskDelete(nullptr);
+}
+
+static bool startBench() {
+    if (benchRunning) {
+        return false;
+    }
+    benchRunning = true;
+    benchResultCount = 0;
+    if (xTaskCreatePinnedToCore(benchTask, "bench", 12288, nullptr, 1, nullptr, 1) != pdPASS) {
+        benchRunning = false;
+        return false;
     }
+    return true;
 }
+#endif
 
 // ========== WEB SERVER ROUTES ==========
 void setupWebServer() {
-    // Serve index.html from LittleFS
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/index.html", "text/html");
-    });
-    
-    // Serve manifest.json for PWA
-    server.on("/manifest.json", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/manifest.json", "application/json");
-    });
-    
-    // Serve service worker
-    server.on("/sw.js", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/sw.js", "application/javascript");
-    });
-    
-    // Serve CSS file
-    server.on("/assets/css/style.css", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/assets/css/style.css", "text/css");
-    });
-    
-    // Serve JS file
-    server.on("/assets/js/script.js", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/assets/js/script.js", "application/javascript");
-    });
+    // Static files (gzip, ETag, Cache-Control; see STATIC ASSETS)
+    for (int i = 0; i < STATIC_ASSET_COUNT; i++) {
+        const StaticAsset* asset = &staticAssets[i];
+        server.on(asset->url, HTTP_GET, [asset](AsyncWebServerRequest *request) {
+            serveStaticAsset(request, *asset);
+        });
+    }
     
     // API: Get current status
     server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
         // NOTE: This payload includes nested arrays/objects (schedules) and optional data.
         // Increase capacity to avoid truncated/missing fields which can break the frontend.
-        StaticJsonDocument<2048> doc;
-        
-        // Temperatures
-        if (isnan(state.tempVorlauf)) {
-            doc["tempVorlauf"] = nullptr;
-        } else {
-            doc["tempVorlauf"] = round(state.tempVorlauf * 10) / 10.0;
-        }
-        
-        if (isnan(state.tempRuecklauf)) {
-            doc["tempRuecklauf"] = nullptr;
-        } else {
-            doc["tempRuecklauf"] = round(state.tempRuecklauf * 10) / 10.0;
-        }
-        
-        doc["heating"] = state.heatingOn;
-        doc["pump"] = state.pumpOn;
-        doc["pumpManualMode"] = state.pumpManualMode;
-        doc["mode"] = state.mode;
-        doc["tempOn"] = state.tempOn;
-        doc["tempOff"] = state.tempOff;
-        doc["relayActiveLow"] = true;
-        doc["heaterRelayActiveLow"] = state.heaterRelayActiveLow;
-        doc["pumpRelayActiveLow"] = state.pumpRelayActiveLow;
-        doc["heaterRelayOffMode"] = state.heaterRelayOffMode;
-        doc["pumpRelayOffMode"] = state.pumpRelayOffMode;
-        doc["rssi"] = WiFi.RSSI();
-        doc["apMode"] = state.apModeActive;
-        doc["uptime"] = state.uptime;
-        doc["ntpSynced"] = state.ntpSynced;
-        doc["version"] = FIRMWARE_VERSION;
+        // Live dashboards should use /ws/state instead of polling this endpoint.
+        std::shared_ptr<StaticJsonDocument<2048>> docPtr = std::make_shared<StaticJsonDocument<2048>>();
+        StaticJsonDocument<2048>& doc = *docPtr;
+        buildLiveState(doc);
+        buildConfigState(doc);
         
-        // Current time
-        int hour, minute;
-        if (getCurrentTime(hour, minute)) {
-            char timeStr[6];
-            sprintf(timeStr, "%02d:%02d", hour, minute);
-            doc["currentTime"] = timeStr;
-        }
-        
-        // Temperature difference & efficiency
-        if (!isnan(state.tempVorlauf) && !isnan(state.tempRuecklauf)) {
-            float diff = state.tempVorlauf - state.tempRuecklauf;
-            doc["tempDiff"] = round(diff * 10) / 10.0;
-            
-            // Efficiency: optimal is 10-15°C difference
-            float efficiency = 0;
-            if (diff >= 10 && diff <= 15) {
-                efficiency = 100;
-            } else if (diff > 15) {
-                efficiency = 100 - ((diff - 15) * 5);  // Decrease above 15
-            } else if (diff > 0) {
-                efficiency = (diff / 10.0) * 100;  // Scale 0-10 to 0-100
-            }
-            efficiency = max(0.0f, min(100.0f, efficiency));
-            doc["efficiency"] = (int)efficiency;
-        }
-        
-        // Statistics
-        doc["switchCount"] = stats.switchCount;
-        doc["todaySwitches"] = stats.todaySwitches;
-        doc["onTimeSeconds"] = stats.onTimeSeconds;
-        doc["offTimeSeconds"] = stats.offTimeSeconds;
-        doc["behaviorWarning"] = behaviorWarningActive;
-        
-        // Frost protection
-        doc["frostEnabled"] = state.frostProtectionEnabled;
-        doc["frostTemp"] = state.frostProtectionTemp;
-        
-        // Tank level
-        doc["tankAvailable"] = state.tankSensorAvailable;
-        if (state.tankSensorAvailable) {
-            doc["tankDistance"] = round(state.tankDistance * 10) / 10.0;
-            doc["tankLiters"] = round(state.tankLiters * 10) / 10.0;
-            doc["tankPercent"] = state.tankPercent;
-        } else {
-            doc["tankDistance"] = nullptr;
-            doc["tankLiters"] = nullptr;
-            doc["tankPercent"] = nullptr;
-        }
-        doc["tankHeight"] = state.tankHeight;
-        doc["tankCapacity"] = state.tankCapacity;
-        doc["dieselConsumptionPerHour"] = state.dieselConsumptionPerHour;
-        
-        // Location
-        doc["latitude"] = state.latitude;
-        doc["longitude"] = state.longitude;
-        
-        // Location name (prefer saved name, then weather location name)
-        if (state.locationName.length() > 0 && state.locationName != "Unbekannter Ort") {
-            doc["locationName"] = state.locationName;
-        } else if (weather.locationName.length() > 0 && weather.locationName != "Unbekannter Ort") {
-            doc["locationName"] = weather.locationName;
-        }
+        // Outbound HTTP worker (MySQL/Telegram/weather queue)
+        JsonObject outbound = doc.createNestedObject("outbound");
+        outbound["queueDepth"] = outboundQueue ? uxQueueMessagesWaiting(outboundQueue) : 0;
+        outbound["queueCapacity"] = OUTBOUND_QUEUE_DEPTH;
+        outbound["enqueued"] = outboundStats.enqueued;
+        outbound["completed"] = outboundStats.completed;
+        outbound["retried"] = outboundStats.retried;
+        outbound["failed"] = outboundStats.failed;
+        outbound["dropped"] = outboundStats.dropped;
         
-        // Schedules
-        JsonArray schedArray = doc.createNestedArray("schedules");
-        for (int i = 0; i < MAX_SCHEDULES; i++) {
-            JsonObject sched = schedArray.createNestedObject();
-            sched["enabled"] = state.schedules[i].enabled;
-            
-            char startTime[6], endTime[6];
-            sprintf(startTime, "%02d:%02d", state.schedules[i].startHour, state.schedules[i].startMinute);
-            sprintf(endTime, "%02d:%02d", state.schedules[i].endHour, state.schedules[i].endMinute);
-            
-            sched["start"] = startTime;
-            sched["end"] = endTime;
-        }
+        // Switch event outbox (store-and-forward on the data partition)
+        JsonObject outbox = doc.createNestedObject("outbox");
+        outbox["ready"] = outboxReady;
+        outbox["pending"] = outboxPending;
+        outbox["capacity"] = OUTBOX_MAX_RECORDS;
+        outbox["appended"] = outboxStats.appended;
+        outbox["uploaded"] = outboxStats.uploaded;
+        outbox["batches"] = outboxStats.batches;
+        outbox["resolved"] = outboxStats.resolved;
+        outbox["unresolvable"] = outboxStats.unresolvable;
+        outbox["corrupt"] = outboxStats.corrupt;
+        outbox["dropped"] = outboxStats.dropped;
         
-        String json;
-        serializeJson(doc, json);
-        request->send(200, "application/json", json);
+        request->send(beginJsonResponse(request, docPtr));
+    });
+    
+    // Static configuration only (changes only via settings); live values come from /ws/state
+    server.on("/api/config", HTTP_GET, [](AsyncWebServerRequest *request) {
+        std::shared_ptr<StaticJsonDocument<1024>> doc = std::make_shared<StaticJsonDocument<1024>>();
+        buildConfigState(*doc);
+        request->send(beginJsonResponse(request, doc));
     });
     
     // API: Toggle heater (manual mode only)
@@ -2265,16 +5390,14 @@ void setupWebServer() {
         
         // Read current pin state BEFORE toggle
         int pinBefore = digitalRead(state.heaterRelayPin);
-        serialLogF("[API] GPIO%d BEFORE toggle: %s\n", (int)state.heaterRelayPin, pinBefore == LOW ? "LOW" : "HIGH");
-        Serial.flush();
+        logEvent(LOGF_API_PIN_BEFORE, (int)state.heaterRelayPin, pinBefore == LOW ? "LOW" : "HIGH");
         
         setHeater(!state.heatingOn);
         
         // Read pin state AFTER toggle
         delay(100);
         int pinAfter = digitalRead(state.heaterRelayPin);
-        serialLogF("[API] GPIO%d AFTER toggle: %s\n", (int)state.heaterRelayPin, pinAfter == LOW ? "LOW" : "HIGH");
-        Serial.flush();
+        logEvent(LOGF_API_PIN_AFTER, (int)state.heaterRelayPin, pinAfter == LOW ? "LOW" : "HIGH");
         lastToggleTime = millis();
         
         StaticJsonDocument<64> doc;
@@ -2333,7 +5456,7 @@ void setupWebServer() {
         state.pumpManualMode = newPumpState;
         if (state.pumpManualMode) {
             // Manual pump ON should not be affected by a stale heating cooldown timestamp.
-            lastHeatingOffTime = 0;
+            state.lastHeatingOffTime = 0;
         }
         setPump(newPumpState, true);  // Manual override
         
@@ -2372,6 +5495,8 @@ void setupWebServer() {
                 return;
             }
             
+            // Hold the control lock while changing mode/thresholds (control task reads them)
+            ControlLock lock;
             bool changed = false;
             
             // Update mode
@@ -2379,6 +5504,7 @@ void setupWebServer() {
                 String newMode = doc["mode"].as<String>();
                 if (newMode == "manual" || newMode == "auto" || newMode == "schedule") {
                     state.mode = newMode;
+                    state.controlMode = controlModeFromName(newMode.c_str());
                     changed = true;
                     serialLogF("Mode changed to: %s\n", newMode.c_str());
                     
@@ -2470,6 +5596,24 @@ void setupWebServer() {
                 }
             }
             
+            // Update DS18B20 resolution (9..12 bit), applied by the sensor engine between conversions
+            if (doc.containsKey("sensor1Resolution") && doc["sensor1Resolution"].is<int>()) {
+                int bits = doc["sensor1Resolution"].as<int>();
+                if (isValidSensorResolution(bits) && (uint8_t)bits != state.sensor1Resolution) {
+                    state.sensor1Resolution = (uint8_t)bits;
+                    sensorResolutionDirty = true;
+                    changed = true;
+                }
+            }
+            if (doc.containsKey("sensor2Resolution") && doc["sensor2Resolution"].is<int>()) {
+                int bits = doc["sensor2Resolution"].as<int>();
+                if (isValidSensorResolution(bits) && (uint8_t)bits != state.sensor2Resolution) {
+                    state.sensor2Resolution = (uint8_t)bits;
+                    sensorResolutionDirty = true;
+                    changed = true;
+                }
+            }
+            
             // Update tank configuration
             if (doc.containsKey("tankHeight")) {
                 float height = doc["tankHeight"];
@@ -2562,7 +5706,7 @@ void setupWebServer() {
         
         String query = request->getParam("query")->value();
         
-        Serial.printf("[Geocode] Searching for: %s\n", query.c_str());
+        LOG_INFO(LOGCH_WEATHER, "[Geocode] Searching for: %s\n", query.c_str());
         
         HTTPClient http;
         
@@ -2584,7 +5728,7 @@ void setupWebServer() {
             }
         }
         
-        Serial.printf("[Geocode] Encoded query: %s\n", encodedQuery.c_str());
+        LOG_DEBUG(LOGCH_WEATHER, "[Geocode] Encoded query: %s\n", encodedQuery.c_str());
         
         // OpenStreetMap Nominatim API (forward geocoding)
         // Use HTTPS to avoid HTTP 301 redirect
@@ -2593,7 +5737,7 @@ void setupWebServer() {
         url += "&format=json&limit=5";
         url += "&accept-language=de"; // Prefer German results
         
-        Serial.printf("[Geocode] URL: %s\n", url.c_str());
+        LOG_DEBUG(LOGCH_WEATHER, "[Geocode] URL: %s\n", url.c_str());
         
         http.begin(url);
         http.addHeader("User-Agent", "ESP32-HeaterControl/2.3.0");
@@ -2601,13 +5745,13 @@ void setupWebServer() {
         
         int httpCode = http.GET();
         
-        Serial.printf("[Geocode] HTTP Code: %d\n", httpCode);
+        LOG_DEBUG(LOGCH_WEATHER, "[Geocode] HTTP Code: %d\n", httpCode);
         
         StaticJsonDocument<512> doc;
         
         if (httpCode == HTTP_CODE_OK) {
             String payload = http.getString();
-            Serial.printf("[Geocode] Response length: %d\n", payload.length());
+            LOG_DEBUG(LOGCH_WEATHER, "[Geocode] Response length: %d\n", payload.length());
             
             // Parse array response - increase buffer size for larger responses
             StaticJsonDocument<2048> responseDoc;
@@ -2628,17 +5772,17 @@ void setupWebServer() {
                 }
                 doc["displayName"] = displayName;
                 
-                Serial.printf("[Geocode] Found: %s at %.6f,%.6f\n", 
-                            displayName.c_str(), 
-                            doc["latitude"].as<float>(), 
-                            doc["longitude"].as<float>());
+                LOG_INFO(LOGCH_WEATHER, "[Geocode] Found: %s at %.6f,%.6f\n", 
+                         displayName.c_str(), 
+                         doc["latitude"].as<float>(), 
+                         doc["longitude"].as<float>());
             } else {
-                Serial.printf("[Geocode] Parse error or empty: %s\n", error.c_str());
+                LOG_WARN(LOGCH_WEATHER, "[Geocode] Parse error or empty: %s\n", error.c_str());
                 doc["found"] = false;
                 doc["error"] = error ? String("Parse error: ") + error.c_str() : "Location not found";
             }
         } else {
-            Serial.printf("[Geocode] HTTP error: %d\n", httpCode);
+            LOG_WARN(LOGCH_WEATHER, "[Geocode] HTTP error: %d\n", httpCode);
             doc["found"] = false;
             doc["error"] = "Geocoding service unavailable (HTTP " + String(httpCode) + ")";
         }
@@ -2656,13 +5800,14 @@ void setupWebServer() {
         // Only fetch if data is old (> 10 min) or invalid, to avoid unnecessary API calls
         unsigned long now = millis();
         if (!weather.valid || (weather.valid && (now - weather.lastUpdate >= WEATHER_UPDATE_INTERVAL))) {
-            // Fetch in background (don't wait for response to avoid blocking)
+            // Fetch in background (outbound worker), this response serves the cached data
             if (WiFi.status() == WL_CONNECTED && state.locationName.length() > 0 && state.locationName != "Unbekannter Ort") {
-                doFetchWeatherData(false);
+                queueWeatherRefresh(false);
             }
         }
         
         StaticJsonDocument<512> doc;
+        MutexLock lock(weatherMutex);
         
         // Always include locationName if available (even if weather data is invalid)
         // Only include if it's not the default "Unbekannter Ort"
@@ -2698,12 +5843,35 @@ void setupWebServer() {
 
     // API: Tank debug (diagnose JSN-SR04T wiring/levels)
     server.on("/api/tank-debug", HTTP_GET, [](AsyncWebServerRequest *request) {
-        StaticJsonDocument<384> doc;
+        StaticJsonDocument<768> doc;
         doc["trigPin"] = TRIG_PIN;
         doc["echoPin"] = ECHO_PIN;
         doc["echoBefore"] = lastEchoBefore;
         doc["echoAfter"] = lastEchoAfter;
         doc["durationUs"] = lastUltrasonicDurationUs;
+        doc["echoDelayUs"] = lastEchoDelayUs;
+        doc["edgeCount"] = echoEdgeCount;
+        doc["pingPending"] = tankPingPending;
+        doc["captureMode"] = "gpio-isr";
+        
+        // Last finished burst (raw samples, null = missed echo); the sensing task may be filling the next one
+        TankBurstSnapshot snapshot;
+        {
+            MutexLock lock(tankBurstMutex);
+            snapshot = lastBurst;
+        }
+        JsonArray burst = doc.createNestedArray("burst");
+        for (int i = 0; i < TANK_BURST_SAMPLES; i++) {
+            if (isnan(snapshot.samples[i])) {
+                burst.add(nullptr);
+            } else {
+                burst.add(round(snapshot.samples[i] * 10) / 10.0);
+            }
+        }
+        doc["burstValid"] = snapshot.diag.valid;
+        doc["burstMedianCm"] = snapshot.diag.medianCm;
+        doc["burstSpreadCm"] = snapshot.diag.spreadCm;
+        doc["confidence"] = state.tankConfidence;
         doc["distanceCm"] = lastUltrasonicDistanceCm;
         doc["tankAvailable"] = state.tankSensorAvailable;
 
@@ -2719,320 +5887,201 @@ void setupWebServer() {
 
         String json;
         serializeJson(doc, json);
-        request->send(200, "application/json", json);
-    });
-    
-    // API: Stats history (no authentication required)
-    server.on("/api/stats-history", HTTP_GET, [](AsyncWebServerRequest *request) {
-        
-        // Use smaller document to prevent stack overflow
-        StaticJsonDocument<8192> doc;  // Reduced from 16384 to prevent crashes
-        
-        // Try to fetch from MySQL (with safety checks)
-        bool mysqlSuccess = false;
-        if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
-            // Try MySQL fetch with timeout protection
-            mysqlSuccess = fetchMySQLStats(doc);
-            doc["mysqlAvailable"] = state.mysqlConnected;
-        } else {
-            doc["mysqlAvailable"] = false;
-        }
-        
-        // Return current statistics for aggregation (always from local stats)
-        doc["switchCount"] = stats.switchCount;
-        doc["todaySwitches"] = stats.todaySwitches;
-        doc["onTimeSeconds"] = stats.onTimeSeconds;
-        doc["offTimeSeconds"] = stats.offTimeSeconds;
-        
-        // Calculate total diesel consumption (from total ON time)
-        float totalDieselLiters = (stats.onTimeSeconds / 3600.0) * state.dieselConsumptionPerHour;
-        doc["totalDieselLiters"] = round(totalDieselLiters * 10) / 10.0;
-        
-        // If MySQL fetch failed, fall back to local calculation
-        if (!mysqlSuccess || !doc.containsKey("today")) {
-            // Today's data object
-            JsonObject today = doc.createNestedObject("today");
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo, 100)) {
-            char dateKey[9];
-            sprintf(dateKey, "%04d%02d%02d", timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday);
-            today["dateKey"] = dateKey;
-            today["switches"] = stats.todaySwitches;
-            
-            // Calculate today's on/off times from switch events
-            unsigned long todayOnSeconds = 0;
-            unsigned long todayOffSeconds = 0;
-            unsigned long todayStartTime = 0;
-            bool todayStarted = false;
-            float sumVorlauf = 0.0;
-            float sumRuecklauf = 0.0;
-            float minVorlauf = NAN;
-            float maxVorlauf = NAN;
-            float minRuecklauf = NAN;
-            float maxRuecklauf = NAN;
-            unsigned long sampleCount = 0;
-            
-            // Get today's timestamp at 00:00:00
-            struct tm todayStart = timeinfo;
-            todayStart.tm_hour = 0;
-            todayStart.tm_min = 0;
-            todayStart.tm_sec = 0;
-            unsigned long todayStartTimestamp = mktime(&todayStart);
-            
-            // Get yesterday's timestamp at 00:00:00 (for events that started yesterday but ended today)
-            struct tm yesterdayStart = timeinfo;
-            yesterdayStart.tm_hour = 0;
-            yesterdayStart.tm_min = 0;
-            yesterdayStart.tm_sec = 0;
-            // Subtract one day
-            time_t yesterdayTime = mktime(&yesterdayStart);
-            yesterdayTime -= 86400; // 24 hours in seconds
-            unsigned long yesterdayStartTimestamp = (unsigned long)yesterdayTime;
-            
-            // Collect and sort today's events chronologically (including events from yesterday that affect today)
-            // Use smaller array to prevent stack overflow
-            const int MAX_TODAY_EVENTS = 20; // Limit to prevent stack overflow
-            struct EventWithIndex {
-                const SwitchEvent* evt;
-                int originalIdx;
-                unsigned long sortKey; // timestamp or uptimeMs for sorting
-            };
-            EventWithIndex todayEvents[MAX_TODAY_EVENTS];
-            int todayEventCount = 0;
-            
-            // Limit iteration to prevent timeout
-            int maxIterations = MAX_SWITCH_EVENTS < MAX_TODAY_EVENTS ? MAX_SWITCH_EVENTS : MAX_TODAY_EVENTS;
-            for (int i = 0; i < MAX_SWITCH_EVENTS && todayEventCount < MAX_TODAY_EVENTS; ++i) {
-                int idx = (switchEventIndex + i) % MAX_SWITCH_EVENTS;
-                const SwitchEvent& evt = switchEvents[idx];
-                if (evt.timestamp == 0 && evt.uptimeMs == 0) continue;
-                
-                // Check if event is from today or yesterday (for overnight runs)
-                bool isRelevant = false;
-                if (evt.timestamp > 0) {
-                    // Include events from yesterday (for overnight heating cycles)
-                    // and events from today
-                    isRelevant = (evt.timestamp >= yesterdayStartTimestamp && evt.timestamp < (todayStartTimestamp + 86400));
-                } else if (evt.uptimeMs > 0) {
-                    // Fallback: if no timestamp, assume it's relevant if uptime is reasonable
-                    unsigned long currentUptime = millis();
-                    if (evt.uptimeMs <= currentUptime && (currentUptime - evt.uptimeMs) < 172800000) {
-                        isRelevant = true; // Within last 48 hours (to catch overnight cycles)
-                    }
-                }
-                
-                if (!isRelevant) continue;
-                
-                todayEvents[todayEventCount].evt = &evt;
-                todayEvents[todayEventCount].originalIdx = idx;
-                todayEvents[todayEventCount].sortKey = evt.timestamp > 0 ? evt.timestamp : evt.uptimeMs;
-                todayEventCount++;
-            }
-            
-            // Sort events chronologically (oldest first)
-            for (int i = 0; i < todayEventCount - 1; ++i) {
-                for (int j = i + 1; j < todayEventCount; ++j) {
-                    if (todayEvents[i].sortKey > todayEvents[j].sortKey) {
-                        EventWithIndex temp = todayEvents[i];
-                        todayEvents[i] = todayEvents[j];
-                        todayEvents[j] = temp;
-                    }
-                }
-            }
-            
-            // Calculate on/off times from sorted events
-            // Track the state at the start of today (from yesterday's last event)
-            unsigned long lastOnTime = 0;
-            bool lastWasOn = false;
-            bool startedBeforeToday = false;
-            
-            for (int i = 0; i < todayEventCount; ++i) {
-                const SwitchEvent& evt = *todayEvents[i].evt;
-                unsigned long eventTime = evt.timestamp > 0 ? evt.timestamp : (evt.uptimeMs / 1000);
-                
-                // If this event is from yesterday and it's an ON event, we started before today
-                if (evt.timestamp > 0 && evt.timestamp < todayStartTimestamp && evt.isOn) {
-                    startedBeforeToday = true;
-                    lastOnTime = todayStartTimestamp; // Start counting from today 00:00
-                    lastWasOn = true;
-                    continue;
-                }
-                
-                if (evt.isOn) {
-                    // ON event
-                    if (lastWasOn && lastOnTime > 0) {
-                        // Previous ON period ended (shouldn't happen, but handle it)
-                        unsigned long duration = eventTime - lastOnTime;
-                        if (eventTime >= todayStartTimestamp) {
-                            todayOffSeconds += duration;
-                        }
-                    }
-                    lastOnTime = eventTime;
-                    lastWasOn = true;
-                } else {
-                    // OFF event
-                    if (lastWasOn && lastOnTime > 0) {
-                        // Calculate ON duration
-                        unsigned long duration = eventTime - lastOnTime;
-                        // Only count time that's within today
-                        if (eventTime >= todayStartTimestamp) {
-                            if (lastOnTime < todayStartTimestamp) {
-                                // Started before today, only count from today 00:00
-                                todayOnSeconds += (eventTime - todayStartTimestamp);
-                            } else {
-                                // Entirely within today
-                                todayOnSeconds += duration;
-                            }
-                        }
-                    } else if (!lastWasOn && lastOnTime > 0) {
-                        // Calculate OFF duration
-                        unsigned long duration = eventTime - lastOnTime;
-                        if (eventTime >= todayStartTimestamp) {
-                            if (lastOnTime < todayStartTimestamp) {
-                                // Started before today, only count from today 00:00
-                                todayOffSeconds += (eventTime - todayStartTimestamp);
-                            } else {
-                                // Entirely within today
-                                todayOffSeconds += duration;
-                            }
-                        }
-                    }
-                    lastOnTime = eventTime;
-                    lastWasOn = false;
-                }
-                
-                // Track temperatures from all events
-                if (!isnan(evt.tempVorlauf)) {
-                    sumVorlauf += evt.tempVorlauf;
-                    if (isnan(minVorlauf) || evt.tempVorlauf < minVorlauf) minVorlauf = evt.tempVorlauf;
-                    if (isnan(maxVorlauf) || evt.tempVorlauf > maxVorlauf) maxVorlauf = evt.tempVorlauf;
-                }
-                if (!isnan(evt.tempRuecklauf)) {
-                    sumRuecklauf += evt.tempRuecklauf;
-                    if (isnan(minRuecklauf) || evt.tempRuecklauf < minRuecklauf) minRuecklauf = evt.tempRuecklauf;
-                    if (isnan(maxRuecklauf) || evt.tempRuecklauf > maxRuecklauf) maxRuecklauf = evt.tempRuecklauf;
-                }
-                sampleCount++;
-            }
-            
-            // If currently ON, add time from last ON event to now
-            if (lastWasOn && state.heatingOn && lastOnTime > 0) {
-                unsigned long currentTime = 0;
-                if (getLocalTime(&timeinfo, 100)) {
-                    currentTime = mktime(&timeinfo);
-                } else {
-                    currentTime = millis() / 1000; // Fallback to uptime
-                }
-                if (currentTime > lastOnTime) {
-                    unsigned long duration = currentTime - lastOnTime;
-                    todayOnSeconds += duration;
-                }
-            }
-            
-            // Use calculated values or fallback to stats
-            unsigned long finalOnSeconds = todayOnSeconds > 0 ? todayOnSeconds : stats.onTimeSeconds;
-            unsigned long finalOffSeconds = todayOffSeconds > 0 ? todayOffSeconds : stats.offTimeSeconds;
-            today["onSeconds"] = finalOnSeconds;
-            today["offSeconds"] = finalOffSeconds;
-            
-            // Calculate diesel consumption (liters = hours * consumption per hour)
-            float todayDieselLiters = (finalOnSeconds / 3600.0) * state.dieselConsumptionPerHour;
-            today["dieselLiters"] = round(todayDieselLiters * 10) / 10.0;
-            
-            // Temperature statistics
-            if (sampleCount > 0) {
-                today["avgVorlauf"] = round((sumVorlauf / sampleCount) * 10) / 10.0;
-                today["avgRuecklauf"] = round((sumRuecklauf / sampleCount) * 10) / 10.0;
-                today["minVorlauf"] = round(minVorlauf * 10) / 10.0;
-                today["maxVorlauf"] = round(maxVorlauf * 10) / 10.0;
-                today["minRuecklauf"] = round(minRuecklauf * 10) / 10.0;
-                today["maxRuecklauf"] = round(maxRuecklauf * 10) / 10.0;
-            } else {
-                // Fallback to current values
-                if (!isnan(state.tempVorlauf)) {
-                    today["avgVorlauf"] = round(state.tempVorlauf * 10) / 10.0;
-                } else {
-                    today["avgVorlauf"] = nullptr;
-                }
-                if (!isnan(state.tempRuecklauf)) {
-                    today["avgRuecklauf"] = round(state.tempRuecklauf * 10) / 10.0;
-                } else {
-                    today["avgRuecklauf"] = nullptr;
-                }
-                today["minVorlauf"] = nullptr;
-                today["maxVorlauf"] = nullptr;
-                today["minRuecklauf"] = nullptr;
-                today["maxRuecklauf"] = nullptr;
+        request->send(200, "application/json", json);
+    });
+    
+#ifdef BENCH_ENABLED
+    // API: Microbenchmarks (bench firmware only). POST starts a run, GET returns the last results.
+    server.on("/api/bench", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!request->authenticate(AUTH_USER, AUTH_PASS)) {
+            return request->requestAuthentication();
+        }
+        if (!startBench()) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Benchmark already running\"}");
+            return;
+        }
+        serialLogLn("[Bench] Run started");
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+    
+    server.on("/api/bench", HTTP_GET, [](AsyncWebServerRequest *request) {
+        DynamicJsonDocument doc(256 + BENCH_MAX_CASES * 192);
+        doc["platform"] = "esp32";
+        doc["running"] = benchRunning;
+        doc["runs"] = benchRunsCompleted;
+        doc["cpuMHz"] = ESP.getCpuFreqMHz();
+        JsonArray results = doc.createNestedArray("results");
+        int count = benchResultCount;
+        for (int i = 0; i < count; i++) {
+            const BenchResult& r = benchResults[i];
+            JsonObject o = results.createNestedObject();
+            o["bench"] = r.name;
+            o["iterations"] = r.iterations;
+            o["usMean"] = r.usMean;
+            o["usMin"] = r.usMin;
+            o["usMax"] = r.usMax;
+            o["cyclesMean"] = r.cyclesMean;
+        }
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
+#endif
+    
+    // API: Scheduler task statistics (run time, jitter, overruns, stack headroom)
+    server.on("/api/tasks", HTTP_GET, [](AsyncWebServerRequest *request) {
+        bool reset = request->hasParam("reset");
+        StaticJsonDocument<2048> doc;
+        doc["uptime"] = state.uptime;
+        JsonArray tasks = doc.createNestedArray("tasks");
+        for (int i = 0; i < SCHEDULED_TASK_COUNT; i++) {
+            ScheduledTask& task = scheduledTasks[i];
+            JsonObject t = tasks.createNestedObject();
+            t["name"] = task.name;
+            t["periodMs"] = task.periodMs;
+            t["deadlineMs"] = task.deadlineMs;
+            t["priority"] = task.priority;
+            t["core"] = task.core;
+            t["runs"] = task.runs;
+            t["overruns"] = task.overruns;
+            t["lastRunUs"] = task.lastRunUs;
+            t["maxRunUs"] = task.maxRunUs;
+            t["avgRunUs"] = task.runs > 0 ? (uint32_t)(task.totalRunUs / task.runs) : 0;
+            t["lastJitterUs"] = task.lastJitterUs;
+            t["maxJitterUs"] = task.maxJitterUs;
+            t["stackFreeBytes"] = task.handle ? uxTaskGetStackHighWaterMark(task.handle) : 0;
+            if (reset) {
+                task.maxRunUs = 0;
+                task.maxJitterUs = 0;
+                task.overruns = 0;
             }
-            today["samples"] = sampleCount > 0 ? sampleCount : 1;
-        } else {
-            today["dateKey"] = "";
-            today["switches"] = 0;
-            today["onSeconds"] = 0;
-            today["offSeconds"] = 0;
-            today["avgVorlauf"] = nullptr;
-            today["avgRuecklauf"] = nullptr;
-            today["samples"] = 0;
         }
+        doc["freeHeap"] = ESP.getFreeHeap();
+        
+        // Log ring (serial monitor history)
+        JsonObject log = doc.createNestedObject("log");
+        log["ringBytes"] = LOG_RING_SIZE;
+        log["usedBytes"] = logRingUsed;
+        log["firstSeq"] = logFirstSeq;
+        log["nextSeq"] = logNextSeq;
+        log["overwrittenLines"] = logOverwrittenLines;
+        log["chunksSent"] = logStreamChunks;
+        log["deferredSends"] = logStreamDeferred;
+        log["eventsFormatted"] = logEventsFormatted;
+        log["eventsDropped"] = logEventsDropped.load();
+        
+        // History filesystem (data partition, or the asset partition on the old partition table)
+        JsonObject storage = doc.createNestedObject("storage");
+        storage["dataPartition"] = dataPartitionMounted;
+        storage["totalBytes"] = dataFs->totalBytes();
+        storage["usedBytes"] = dataFs->usedBytes();
+        
+        // Switch event journal (data partition)
+        JsonObject journal = doc.createNestedObject("switchJournal");
+        journal["ready"] = switchJournalReady;
+        journal["records"] = switchJournalRecords;
+        journal["appended"] = switchJournalStats.appended;
+        journal["compactions"] = switchJournalStats.compactions;
+        journal["corrupt"] = switchJournalStats.corrupt;
+        journal["writeErrors"] = switchJournalStats.writeErrors;
+        journal["lastAppendUs"] = switchJournalStats.lastAppendUs;
+        journal["maxAppendUs"] = switchJournalStats.maxAppendUs;
+        journal["replayMs"] = switchJournalStats.replayMs;
+        
+        // Per-minute time series (data partition)
+        JsonObject timeSeries = doc.createNestedObject("timeSeries");
+        timeSeries["ready"] = tsReady;
+        timeSeries["day"] = tsFileDayKey;
+        timeSeries["rowsWritten"] = tsStats.rowsWritten;
+        timeSeries["writeErrors"] = tsStats.writeErrors;
+        timeSeries["filesDeleted"] = tsStats.filesDeleted;
+        timeSeries["queries"] = tsStats.queries;
+        
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
+    
+    // MySQL API client diagnostics (keep-alive reuse, reconnects, latency histogram)
+    server.on("/api/mysql-debug", HTTP_GET, [](AsyncWebServerRequest *request) {
+        StaticJsonDocument<768> doc;
+        doc["enabled"] = strlen(MYSQL_API_URL) > 0;
+        doc["connected"] = state.mysqlConnected;
+        doc["keepAliveIdleMs"] = MYSQL_KEEPALIVE_IDLE_MS;
+        doc["socketOpen"] = mysqlHttpBegun;
+        doc["idleMs"] = mysqlLastUseMs > 0 ? millis() - mysqlLastUseMs : 0;
+        doc["requests"] = mysqlClientStats.requests;
+        doc["reused"] = mysqlClientStats.reused;
+        doc["connects"] = mysqlClientStats.connects;
+        doc["reconnects"] = mysqlClientStats.reconnects;
+        doc["idleCloses"] = mysqlClientStats.idleCloses;
+        doc["errors"] = mysqlClientStats.errors;
+        doc["busy"] = mysqlClientStats.busy;
+        doc["lastLatencyMs"] = mysqlClientStats.lastLatencyMs;
+        doc["maxLatencyMs"] = mysqlClientStats.maxLatencyMs;
+        
+        // Histogram: bucket i counts requests below upperMs[i] (last bucket: everything slower)
+        JsonArray upper = doc.createNestedArray("latencyUpperMs");
+        for (int i = 0; i < MYSQL_LATENCY_BUCKETS - 1; i++) {
+            upper.add(mysqlLatencyBucketMs[i]);
+        }
+        JsonArray hist = doc.createNestedArray("latency");
+        for (int i = 0; i < MYSQL_LATENCY_BUCKETS; i++) {
+            hist.add(mysqlClientStats.latency[i]);
         }
         
-        // If MySQL didn't provide days array, create empty one
-        if (!doc.containsKey("days")) {
-            JsonArray daysArray = doc.createNestedArray("days");
+        // /api/stats-history cache
+        JsonObject cache = doc.createNestedObject("statsCache");
+        cache["builds"] = statsCache.builds;
+        cache["lastBuildMs"] = statsCache.buildMs;
+        cache["ageMs"] = statsCache.builtMs > 0 ? millis() - statsCache.builtMs : 0;
+        cache["requests"] = statsCache.requests;
+        cache["notModified"] = statsCache.notModified;
+        
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
+    
+    // API: Stats history (no authentication required)
+    server.on("/api/stats-history", HTTP_GET, [](AsyncWebServerRequest *request) {
+        // Served from the cache built by the outbound worker: no MySQL I/O on the web server thread
+        std::shared_ptr<const String> body;
+        String etag;
+        {
+            MutexLock lock(statsCacheMutex);
+            body = statsCache.body;
+            etag = statsCache.etag;
         }
+        statsCache.requests++;
         
-        // If MySQL didn't provide switch events, use local events
-        // Limit to prevent JSON document overflow
-        if (!doc.containsKey("switchEvents")) {
-            JsonArray eventsArray = doc.createNestedArray("switchEvents");
-            // Start from oldest event (after current index) and wrap around
-            // Limit to last 30 events to prevent document overflow
-            const int MAX_EVENTS_TO_SEND = 30;
-            int eventCount = 0;
-            for (int i = 0; i < MAX_SWITCH_EVENTS && eventCount < MAX_EVENTS_TO_SEND; ++i) {
-                int idx = (switchEventIndex + i) % MAX_SWITCH_EVENTS;
-                const SwitchEvent& evt = switchEvents[idx];
-                // Skip empty entries (timestamp == 0 and uptimeMs == 0 means never written)
-                if (evt.timestamp == 0 && evt.uptimeMs == 0) continue;
-                
-                JsonObject eventObj = eventsArray.createNestedObject();
-                if (evt.timestamp > 0) {
-                    eventObj["timestamp"] = evt.timestamp;
-                } else {
-                    eventObj["timestamp"] = nullptr;
-                }
-                eventObj["isOn"] = evt.isOn;
-                eventObj["uptimeMs"] = evt.uptimeMs;
-                if (!isnan(evt.tempVorlauf)) {
-                    eventObj["tempVorlauf"] = round(evt.tempVorlauf * 10) / 10.0;
-                } else {
-                    eventObj["tempVorlauf"] = nullptr;
-                }
-                if (!isnan(evt.tempRuecklauf)) {
-                    eventObj["tempRuecklauf"] = round(evt.tempRuecklauf * 10) / 10.0;
-                } else {
-                    eventObj["tempRuecklauf"] = nullptr;
-                }
-                if (!isnan(evt.tankLiters)) {
-                    eventObj["tankLiters"] = round(evt.tankLiters * 10) / 10.0;
-                } else {
-                    eventObj["tankLiters"] = nullptr;
-                }
-                eventCount++;
-            }
+        if (!body) {
+            // First build after boot still running
+            queueStatsRefresh();
+            AsyncWebServerResponse *response = request->beginResponse(503, "application/json", "{\"error\":\"Statistik wird berechnet\"}");
+            response->addHeader("Retry-After", "1");
+            request->send(response);
+            return;
         }
         
-        // Serialize JSON with safety check
-        String json;
-        size_t jsonSize = measureJson(doc);
-        if (jsonSize > 0 && jsonSize < 8000) { // Safety check to prevent overflow
-            serializeJson(doc, json);
-            request->send(200, "application/json", json);
-        } else {
-            // Fallback: send minimal response if JSON is too large
-            serialLogF("[Stats] JSON too large: %d bytes, sending error\n", jsonSize);
-            request->send(500, "application/json", "{\"error\":\"JSON too large\"}");
+        if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag) {
+            statsCache.notModified++;
+            AsyncWebServerResponse *response = request->beginResponse(304);
+            response->addHeader("ETag", etag);
+            response->addHeader("Cache-Control", "no-cache");
+            request->send(response);
+            return;
         }
+        
+        AsyncWebServerResponse *response = request->beginResponse("application/json", body->length(),
+            [body](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                size_t n = min(maxLen, body->length() - index);
+                memcpy(buffer, body->c_str() + index, n);
+                return n;
+            });
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");  // Browser revalidates with If-None-Match
+        request->send(response);
     });
     
     // API: Update location
@@ -3075,6 +6124,7 @@ void setupWebServer() {
                 String locName = doc["locationName"].as<String>();
                 if (locName.length() > 0) {
                     state.locationName = locName;
+                    MutexLock lock(weatherMutex);
                     weather.locationName = locName;  // Also update weather location name
                     changed = true;
                 }
@@ -3082,18 +6132,21 @@ void setupWebServer() {
             
             if (changed) {
                 saveSettings();
-                // Force immediate weather update (reset fetch timer and clear cache)
-                weather.valid = false;
-                weather.lastUpdate = 0;
-                lastWeatherFetch = 0;  // Force immediate fetch
-                
-                // Only clear location name if coordinates changed but no name was provided
-                if (!doc.containsKey("locationName")) {
-                    weather.locationName = "";  // Will be refetched with new coordinates
+                {
+                    // Force immediate weather update (reset fetch timer and clear cache)
+                    MutexLock lock(weatherMutex);
+                    weather.valid = false;
+                    weather.lastUpdate = 0;
+                    lastWeatherFetch = 0;  // Force immediate fetch
+                    
+                    // Only clear location name if coordinates changed but no name was provided
+                    if (!doc.containsKey("locationName")) {
+                        weather.locationName = "";  // Will be refetched with new coordinates
+                    }
                 }
                 
-                // Fetch weather data immediately with force refresh (don't wait for next loop cycle)
-                doFetchWeatherData(true);
+                // Fetch weather data with force refresh on the outbound worker
+                queueWeatherRefresh(true);
                 
                 request->send(200, "application/json", "{\"success\":true,\"message\":\"Location updated\"}");
             } else {
@@ -3102,6 +6155,194 @@ void setupWebServer() {
         }
     );
     
+    // API: Temperature/tank history from the time series store, /api/history?from=&to=&res=
+    // (Unix seconds; res = bucket size in seconds, multiple of 60). Streamed in chunks.
+    server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!tsReady) {
+            request->send(503, "application/json", "{\"error\":\"Dateisystem nicht verfügbar\"}");
+            return;
+        }
+        if (!state.ntpSynced && !(request->hasParam("from") && request->hasParam("to"))) {
+            request->send(503, "application/json", "{\"error\":\"Zeit nicht synchronisiert\"}");
+            return;
+        }
+        uint32_t now = (uint32_t)time(nullptr);
+        uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : now;
+        if (state.ntpSynced && to > now) {
+            to = now;
+        }
+        uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) : to - 86400;
+        if (state.ntpSynced) {
+            // Nothing older than the retention window is stored; also keeps the bucket size sensible
+            uint32_t oldest = (uint32_t)tsDayStart(now, -TS_RETENTION_DAYS);
+            if (from < oldest) {
+                from = oldest;
+            }
+        }
+        uint32_t res = request->hasParam("res") ? strtoul(request->getParam("res")->value().c_str(), nullptr, 10) : 60;
+        if (from >= to) {
+            request->send(400, "application/json", "{\"error\":\"from must be before to\"}");
+            return;
+        }
+        
+        // Buckets are whole minutes, and one response holds at most TS_MAX_POINTS of them
+        uint32_t minRes = ((to - from) / TS_MAX_POINTS + 59) / 60 * 60;
+        res = max((uint32_t)60, max(minRes, res / 60 * 60));
+        
+        std::shared_ptr<TsHistoryStream> stream = std::make_shared<TsHistoryStream>();
+        stream->reader.begin(from, to);
+        stream->res = res;
+        tsStats.queries++;
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return stream->fill(buffer, maxLen);
+            });
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+    
+    // API: ON/OFF time, cycles and flow temperatures per window from the local switch history
+    server.on("/api/events/summary", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!state.ntpSynced && !(request->hasParam("from") && request->hasParam("to"))) {
+            request->send(503, "application/json", "{\"error\":\"Zeit nicht synchronisiert\"}");
+            return;
+        }
+        const int MAX_WINDOWS = 62;
+        uint32_t now = (uint32_t)time(nullptr);
+        String bucket = request->hasParam("bucket") ? request->getParam("bucket")->value() : String("day");
+        uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : now;
+        uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10)
+                                                  : (uint32_t)tsDayStart(to, -6);
+        if (from >= to) {
+            request->send(400, "application/json", "{\"error\":\"from must be before to\"}");
+            return;
+        }
+        
+        // Window bounds: local calendar days (DST-safe) or fixed steps ("hour" or seconds)
+        std::unique_ptr<uint32_t[]> bounds(new uint32_t[MAX_WINDOWS + 1]);
+        int windowCount = 0;
+        bounds[0] = from;
+        if (bucket == "day") {
+            time_t next = tsDayStart(from, 1);
+            while (windowCount < MAX_WINDOWS && bounds[windowCount] < to) {
+                bounds[++windowCount] = min((uint32_t)next, to);
+                next = tsDayStart(next, 1);
+            }
+        } else {
+            uint32_t step = bucket == "hour" ? 3600 : strtoul(bucket.c_str(), nullptr, 10);
+            if (step < 60) {
+                request->send(400, "application/json", "{\"error\":\"bucket must be day, hour or >= 60 seconds\"}");
+                return;
+            }
+            while (windowCount < MAX_WINDOWS && bounds[windowCount] < to) {
+                bounds[windowCount + 1] = to - bounds[windowCount] > step ? bounds[windowCount] + step : to;
+                windowCount++;
+            }
+        }
+        
+        std::unique_ptr<SwitchWindowStats[]> windows(new SwitchWindowStats[windowCount]);
+        int placed;
+        {
+            ControlLock lock;
+            placed = switchEventsAggregate(bounds.get(), windowCount, windows.get(),
+                                           state.ntpSynced ? time(nullptr) : 0, millis());
+        }
+        
+        std::shared_ptr<DynamicJsonDocument> docPtr = std::make_shared<DynamicJsonDocument>(512 + windowCount * 384);
+        DynamicJsonDocument& doc = *docPtr;
+        doc["from"] = bounds[0];
+        doc["to"] = bounds[windowCount];
+        doc["truncated"] = bounds[windowCount] < to;
+        doc["events"] = placed;
+        JsonArray arr = doc.createNestedArray("windows");
+        for (int i = 0; i < windowCount; i++) {
+            const SwitchWindowStats& win = windows[i];
+            JsonObject obj = arr.createNestedObject();
+            obj["from"] = win.from;
+            obj["to"] = win.to;
+            obj["switches"] = win.switches;
+            obj["onCycles"] = win.onCycles;
+            obj["onSeconds"] = win.onSeconds;
+            obj["offSeconds"] = win.offSeconds;
+            obj["unknownSeconds"] = win.unknownSeconds;
+            obj["dieselLiters"] = round((win.onSeconds / 3600.0) * state.dieselConsumptionPerHour * 10) / 10.0;
+            if (win.vorlaufSamples > 0) {
+                obj["avgVorlaufOff"] = round(win.vorlaufSum / win.vorlaufSamples * 10) / 10.0;
+                obj["maxVorlaufOff"] = round(win.vorlaufMax * 10) / 10.0;
+            } else {
+                obj["avgVorlaufOff"] = nullptr;
+                obj["maxVorlaufOff"] = nullptr;
+            }
+            if (!isnan(win.tankFirst) && win.tankFirst > win.tankLast) {
+                obj["tankUsedLiters"] = round((win.tankFirst - win.tankLast) * 10) / 10.0;
+            } else {
+                obj["tankUsedLiters"] = nullptr;
+            }
+        }
+        
+        request->send(beginJsonResponse(request, docPtr));
+    });
+    
+    // API: Log channels and their runtime levels
+    server.on("/api/log-config", HTTP_GET, [](AsyncWebServerRequest *request) {
+        StaticJsonDocument<768> doc;
+        doc["compileLevel"] = logLevelNames[LOG_COMPILE_LEVEL];
+        JsonArray levels = doc.createNestedArray("levelNames");
+        for (int i = 0; i <= LOG_LEVEL_DEBUG; i++) {
+            levels.add(logLevelNames[i]);
+        }
+        JsonObject channels = doc.createNestedObject("channels");
+        for (int i = 0; i < LOGCH_COUNT; i++) {
+            channels[logChannelNames[i]] = logLevelNames[logChannelLevel[i]];
+        }
+        
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
+    
+    // API: Change log levels, e.g. {"channels":{"mysql":"debug","weather":"warn"}} (stored in NVS)
+    server.on("/api/log-config", HTTP_POST, 
+        [](AsyncWebServerRequest *request) {},
+        NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            if (!request->authenticate(AUTH_USER, AUTH_PASS)) {
+                return request->requestAuthentication();
+            }
+            
+            StaticJsonDocument<512> doc;
+            DeserializationError error = deserializeJson(doc, data, len);
+            
+            if (error || !doc["channels"].is<JsonObject>()) {
+                request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+                return;
+            }
+            
+            // Validate everything first, then apply
+            uint8_t newLevels[LOGCH_COUNT];
+            memcpy(newLevels, logChannelLevel, sizeof(newLevels));
+            for (JsonPair kv : doc["channels"].as<JsonObject>()) {
+                const char* name = kv.key().c_str();
+                int channel = strcmp(name, "all") == 0 ? LOGCH_COUNT : logChannelByName(name);
+                int level = logLevelByName(kv.value() | "");
+                if (channel < 0 || level < 0) {
+                    request->send(400, "application/json", "{\"error\":\"Unknown channel or level\"}");
+                    return;
+                }
+                if (channel == LOGCH_COUNT) {
+                    memset(newLevels, level, sizeof(newLevels));
+                } else {
+                    newLevels[channel] = level;
+                }
+            }
+            memcpy(logChannelLevel, newLevels, sizeof(newLevels));
+            saveLogConfig();
+            serialLogLn("[API] Log levels updated");
+            
+            request->send(200, "application/json", "{\"success\":true}");
+        }
+    );
+    
     // API: Send test Telegram message
     server.on("/api/telegram/test", HTTP_POST, [](AsyncWebServerRequest *request) {
         if (!request->authenticate(AUTH_USER, AUTH_PASS)) {
@@ -3120,7 +6361,7 @@ void setupWebServer() {
         
         sendTelegramMessage(msg);
         
-        request->send(200, "application/json", "{\"success\":true,\"message\":\"Testnachricht gesendet\"}");
+        request->send(200, "application/json", "{\"success\":true,\"message\":\"Testnachricht wird gesendet\"}");
     });
     
     // Handle 404 - try to serve static files from LittleFS
@@ -3153,8 +6394,8 @@ void setupWebServer() {
             contentType = "text/html";
         }
         
-        // Try to serve file from LittleFS
-        if (LittleFS.exists(path)) {
+        // Try to serve file from LittleFS (plain or pre-compressed "<path>.gz")
+        if (LittleFS.exists(path) || LittleFS.exists(path + ".gz")) {
             request->send(LittleFS, path, contentType);
         } else {
             request->send(404, "text/plain", "Not found");
@@ -3166,6 +6407,11 @@ void setupWebServer() {
     server.addHandler(&ws);
     serialLogLn("WebSocket initialized at /ws");
     
+    // Live status push (separate from the log socket)
+    wsState.onEvent(onStateSocketEvent);
+    server.addHandler(&wsState);
+    serialLogLn("WebSocket initialized at /ws/state");
+    
     // Initialize OTA Updates (custom handler)
     server.on("/update", HTTP_POST, 
         [](AsyncWebServerRequest *request) {
@@ -3291,6 +6537,14 @@ void setupWebServer() {
 void setup() {
     Serial.begin(115200);
     delay(1000);
+    controlMutex = xSemaphoreCreateRecursiveMutex();
+    weatherMutex = xSemaphoreCreateMutex();
+    statsCacheMutex = xSemaphoreCreateMutex();
+    tankBurstMutex = xSemaphoreCreateMutex();
+    initLogEvents();
+    loadLogConfig();
+    initMySQLClient();
+    initOutboundQueue();
     {
         String banner = String("\n\n=== ESP32 Heater Control ") + FIRMWARE_VERSION + " ===";
         serialLogLn(banner.c_str());
@@ -3312,16 +6566,27 @@ void setup() {
     // NOTE: JSN-SR04T ECHO is 5V on many boards -> requires a voltage divider to 3.3V for ESP32!
     pinMode(ECHO_PIN, INPUT_PULLDOWN);
     digitalWrite(TRIG_PIN, LOW);
+    // Echo pulse is timed by edge interrupt (see onEchoEdge), no busy-waiting in loop()
+    attachInterrupt(digitalPinToInterrupt(ECHO_PIN), onEchoEdge, CHANGE);
     
     // IMPORTANT: On some ESP32 boards/cores, auto-format-on-fail can crash inside esp_littlefs_format_partition().
     // We avoid formatting here and simply continue without filesystem if mount fails.
-    if (!LittleFS.begin(false)) {
+    bool assetsMounted = LittleFS.begin(false);
+    if (!assetsMounted) {
         Serial.println("⚠️ WARNING: LittleFS mount failed!");
         Serial.println("Continuing without filesystem - Web server may not work properly");
         // DON'T return - continue anyway, maybe filesystem isn't critical
     } else {
         Serial.println("LittleFS mounted successfully");
+        initStaticAssets();
     }
+    // History (journal, outbox, time series) on the data partition, which asset updates don't touch
+    if (initDataPartition(assetsMounted)) {
+        initOutbox();
+        initSwitchJournal();
+        initTimeSeries();
+    }
+    initDailyStats();
     
     // Initialize sensors
     initSensors();
@@ -3395,17 +6660,23 @@ void setup() {
         serialLogLn("Access via: http://192.168.4.1/");
     }
     
-    // Fetch weather data once at startup (only if WiFi connected and location is set)
+    // Fetch weather data once at startup (only if WiFi connected and location is set; runs on the outbound worker)
     if (wifiConnected && state.locationName.length() > 0 && state.locationName != "Unbekannter Ort") {
-        doFetchWeatherData(false);
+        queueWeatherRefresh(false);
     }
     
     readTemperatures();
     Serial.printf("Vorlauf: %.1f°C, Rücklauf: %.1f°C\n", 
                  state.tempVorlauf, state.tempRuecklauf);
     
-    // Test tank sensor
-    updateTankLevel();
+    // Test tank sensor (wait for one burst here, loop() never waits)
+    startTankBurst();
+    unsigned long burstStart = millis();
+    while (tankBurstActive && millis() - burstStart < 1000) {
+        updateTankLevel();
+        delay(5);
+    }
+    lastTankRead = millis();
     if (state.tankSensorAvailable) {
         Serial.printf("Tank sensor detected: %.1f L (%.0f%%)\n", 
                      state.tankLiters, (float)state.tankPercent);
@@ -3424,161 +6695,17 @@ void setup() {
         scheduleControl();  // Will turn on if in schedule time
     }
     
+    drainLogEvents();  // Setup's relay events, before the tasks take over
+    
+    // Hand over to the periodic tasks (control, sensing, network, housekeeping) and the outbound worker
+    startOutboundWorker();
+    startScheduler();
+    
     Serial.println("\n");
 }
 
 // ========== LOOP ==========
 void loop() {
-    // Flush pending WebSocket messages
-    flushWebSocketMessages();
-    
-    // TEST MODE - COMMENTED OUT (uncomment to test relay)
-    /*
-    static unsigned long lastToggle = 0;
-    static bool relayState = false;
-    unsigned long now = millis();
-    
-    if (lastToggle == 0) {
-        lastToggle = now;
-        relayState = false;
-        Serial.println("\n[Loop] First toggle - Setting GPIO23 to LOW");
-        pinMode(RELAY_PIN, OUTPUT);
-        digitalWrite(RELAY_PIN, LOW);
-        delay(100);
-        return;
-    }
-    
-    if (now - lastToggle >= 2000) {
-        lastToggle = now;
-        relayState = !relayState;
-        
-        if (relayState) {
-            pinMode(RELAY_PIN, OUTPUT);
-            digitalWrite(RELAY_PIN, LOW);
-        } else {
-            pinMode(RELAY_PIN, OUTPUT_OPEN_DRAIN);
-            digitalWrite(RELAY_PIN, HIGH);
-        }
-        delay(100);
-        return;
-    }
-    delay(10);
-    */
-    
-    // NORMAL MODE
-    unsigned long now = millis();
-    
-    // Handle scheduled reboot after OTA update
-    if (rebootScheduled && now >= scheduledRebootTime) {
-        Serial.println("=== Executing scheduled reboot after OTA update ===");
-        Serial.println("Closing all connections...");
-        
-        // Close all WebSocket connections
-        ws.closeAll();
-        delay(100);
-        
-        // Stop the web server gracefully
-        Serial.println("Stopping server...");
-        server.end();
-        delay(500);
-        
-        // CRITICAL: Reset WiFi state before reboot to ensure clean connection on next boot
-        // Complete WiFi reset - setupWiFi() will handle everything fresh
-        WiFi.persistent(false);  // Don't save anything
-        WiFi.disconnect(true);   // Erase all stored credentials
-        WiFi.mode(WIFI_OFF);     // Turn WiFi OFF
-        delay(200);
-        Serial.println("WiFi completely reset for clean boot");
-        
-        // Flush all serial output
-        Serial.flush();
-        delay(500);
-        
-        Serial.println("Rebooting in 1 second...");
-        delay(1000);
-        Serial.flush();
-        
-        ESP.restart();
-        return;  // Should never reach here, but just in case
-    }
-    
-    state.uptime = (now - bootTime) / 1000;
-    
-    // Weather data is only fetched on demand via /api/weather endpoint (not in loop to avoid WebSocket issues)
-    
-    // Sync NTP if not yet synced
-    if (!state.ntpSynced && !state.apModeActive) {
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo, 100)) {
-            state.ntpSynced = true;
-            Serial.println("NTP time synced!");
-        }
-    }
-    
-    // Handle pump cooldown logic (check every second)
-    handlePumpCooldown();
-    
-    if (now - lastTempRead >= TEMP_READ_INTERVAL) {
-        lastTempRead = now;
-        readTemperatures();
-        
-        // Update statistics
-        updateStatistics();
-        
-        checkFailsafe();
-        
-        // Frost protection has highest priority
-        if (state.frostProtectionEnabled) {
-            frostProtection();
-        }
-        // Then normal modes
-        else if (state.mode == "auto") {
-            automaticControl();
-        } else if (state.mode == "schedule") {
-            scheduleControl();
-        }
-    }
-    
-    // Read tank level every 5 seconds
-    if (now - lastTankRead >= TANK_READ_INTERVAL) {
-        lastTankRead = now;
-        updateTankLevel();
-    }
-    
-    // Check MySQL connection status every 30 seconds (if MySQL is enabled)
-    if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
-        if (now - state.lastMySQLCheck >= 30000) { // 30 seconds
-            checkMySQLConnection();
-        }
-    }
-    
-    // Save daily stats to MySQL every 5 minutes (if MySQL is enabled)
-    static unsigned long lastDailyStatsSave = 0;
-    if (strlen(MYSQL_API_URL) > 0 && WiFi.status() == WL_CONNECTED) {
-        if (now - lastDailyStatsSave >= 300000) { // 5 minutes
-            saveDailyStatsToMySQL();
-            lastDailyStatsSave = now;
-        }
-    }
-    
-    // WiFi reconnect logic - but NOT during OTA update or scheduled reboot
-    if (!state.apModeActive && 
-        !otaUpdateInProgress && 
-        !rebootScheduled && 
-        WiFi.status() != WL_CONNECTED &&
-        (now - lastWiFiReconnectAttempt) >= WIFI_RECONNECT_INTERVAL) {
-        Serial.println("WiFi lost, attempting reconnect...");
-        lastWiFiReconnectAttempt = now;
-        // Don't block - just try once, will retry later if needed
-        WiFi.disconnect();
-        delay(100);
-        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-        // Give it a few seconds to connect before next check
-        lastWiFiReconnectAttempt = now - (WIFI_RECONNECT_INTERVAL - 5000);
-    }
-    
-    // Cleanup disconnected WebSocket clients
-    ws.cleanupClients();
-    
-    delay(10);
+    // All periodic work runs in the scheduler tasks (see TASK SCHEDULER), the Arduino loop task is not needed
+    vTaskDelete(NULL);
 }
@@ -0,0 +1,109 @@
+// "bench" command: microbenchmarks of the portable hot paths (bench.cpp) plus the host-only
+// control step and plant model. One JSON object per line on stdout.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "hal.h"
+#include "host.h"
+#include "plant.h"
+
+#define BENCH_NOW 1760000000  // Fixed Unix time so aggregation results do not depend on the date
+
+static void usageBench() {
+    fprintf(stderr,
+            "usage: program bench [options]\n"
+            "  --iterations <n>  calls per case (default: per case)\n"
+            "  --filter <text>   only cases whose name contains text\n");
+}
+
+struct ControlStepCtx {
+    uint32_t calls;
+};
+
+// Steady-state pass plus a temperature swing every 600 calls, so switching is part of the mix
+static void benchCaseControlStep(void* ctx) {
+    ControlStepCtx& c = *(ControlStepCtx*)ctx;
+    bool cold = (c.calls++ / 600) % 2 == 0;
+    hostState.tempVorlauf = cold ? 30.0f : 60.0f;
+    hostState.tempRuecklauf = cold ? 28.0f : 45.0f;
+    hal::delay(1000);
+    hostControlStep(true);
+}
+
+struct PlantStepCtx {
+    PlantParams params;
+    PlantState state;
+    double timeS;
+};
+
+static void benchCasePlantStep(void* ctx) {
+    PlantStepCtx& c = *(PlantStepCtx*)ctx;
+    plantStep(c.params, c.state, true, true, c.timeS, 1.0f);
+    c.timeS += 1.0;
+}
+
+int runBench(int argc, char** argv) {
+    uint32_t iterations = 0;
+    const char* filter = nullptr;
+    for (int i = 0; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value && strcmp(argv[i], "--iterations") == 0) {
+            iterations = strtoul(value, nullptr, 10);
+            i++;
+        } else if (value && strcmp(argv[i], "--filter") == 0) {
+            filter = value;
+            i++;
+        } else {
+            usageBench();
+            return 2;
+        }
+    }
+    hostVerbose = false;
+    hal::fake::setLogEcho(false);
+    hostRelaysReset();
+    hostState.controlMode = CONTROL_AUTO;
+    hal::fake::setMillis(1000);
+
+    ControlStepCtx controlCtx = {};
+    PlantStepCtx plantCtx;
+    plantInit(plantCtx.params, plantCtx.state);
+    plantCtx.timeS = 0;
+
+    benchFillSwitchEvents(MAX_SWITCH_EVENTS, BENCH_NOW, 3 * 3600);
+    BenchAggregateCtx aggregateCtx;
+    benchAggregateInit(aggregateCtx, BENCH_NOW, 0);
+
+    BenchPersistCtx persistCtx = {};
+    persistCtx.path = "/bench.tmp";
+    persistCtx.nvsNamespace = "bench";
+    hal::fsRemove(persistCtx.path);
+
+    struct Case {
+        const char* name;
+        uint32_t iterations;
+        BenchFn fn;
+        void* ctx;
+    };
+    const Case cases[] = {
+        { "control_step", 200000, benchCaseControlStep, &controlCtx },
+        { "plant_step", 1000000, benchCasePlantStep, &plantCtx },
+        { "switch_aggregate_7d", 200000, benchCaseAggregate, &aggregateCtx },
+        { "unusual_behavior", 1000000, benchCaseUnusualBehavior, nullptr },
+        { "fs_append_36b", 20000, benchCaseFsAppend, &persistCtx },
+        { "nvs_put_36b", 200000, benchCaseNvsPut, &persistCtx },
+    };
+
+    char line[256];
+    for (const Case& c : cases) {
+        if (filter && !strstr(c.name, filter)) {
+            continue;
+        }
+        BenchResult r = benchRun(c.name, iterations ? iterations : c.iterations, c.fn, c.ctx);
+        benchFormat(r, "native", line, sizeof(line));
+        printf("%s\n", line);
+        fflush(stdout);
+    }
+    hal::fsRemove(persistCtx.path);
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Linux fakes for hal.h (env:native): virtual clock, in-memory NVS and a
+// directory-backed filesystem (./native_fs). Single-threaded, fully deterministic.
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <map>
+#include <string>
+#include <vector>
+#include "hal.h"
+
+namespace {
+
+uint64_t clockUs = 0;
+std::map<std::string, std::vector<uint8_t>> nvs;
+const std::string fsRoot = "./native_fs";
+bool logEcho = true;
+
+std::string fsPath(const char* path) {
+    std::string full = fsRoot;
+    if (path[0] != '/') {
+        full += '/';
+    }
+    full += path;
+    return full;
+}
+
+}  // namespace
+
+namespace hal {
+
+// ========== CLOCK ==========
+uint32_t millis() {
+    return (uint32_t)(clockUs / 1000);
+}
+
+void delay(uint32_t ms) {
+    clockUs += (uint64_t)ms * 1000;
+}
+
+uint64_t monotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// ========== NVS ==========
+bool nvsPut(const char* ns, const char* key, const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    nvs[std::string(ns) + "/" + key].assign(bytes, bytes + len);
+    return true;
+}
+
+// ========== FILESYSTEM ==========
+bool fsAppend(const char* path, const void* data, size_t len) {
+    mkdir(fsRoot.c_str(), 0755);
+    FILE* f = fopen(fsPath(path).c_str(), "ab");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    fclose(f);
+    return ok;
+}
+
+bool fsRemove(const char* path) {
+    return remove(fsPath(path).c_str()) == 0;
+}
+
+// ========== LOG ==========
+// No level filter on the host: every line is printed while echo is on
+static void logLine(const char* format, va_list args) {
+    if (!logEcho) {
+        return;
+    }
+    printf("[%10.3f] ", clockUs / 1e6);
+    vprintf(format, args);
+}
+
+void log(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(format, args);
+    va_end(args);
+}
+
+void logWarn(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(format, args);
+    va_end(args);
+}
+
+void logError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logLine(format, args);
+    va_end(args);
+}
+
+// ========== FAKE CONTROLS ==========
+namespace fake {
+
+void setMillis(uint32_t ms) {
+    clockUs = (uint64_t)ms * 1000;
+}
+
+void advance(uint32_t ms) {
+    clockUs += (uint64_t)ms * 1000;
+}
+
+void setLogEcho(bool echo) {
+    logEcho = echo;
+}
+
+}  // namespace fake
+
+}  // namespace hal
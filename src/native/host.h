@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include "control.h"
+
+// ========== HOST RELAYS ==========
+// Actuators for control.cpp on the host: same pump/heater coupling as setHeater()/setPump() in
+// main.cpp (relay state in hostState only), plus counters for reports.
+
+struct HostRelayStats {
+    uint32_t heaterSwitches;
+    uint32_t pumpSwitches;
+    uint32_t notifications;
+    uint32_t behaviorWarnings;      // checkUnusualBehavior() raised a warning
+};
+
+extern ControlState hostState;
+extern HostRelayStats hostRelays;
+extern bool hostVerbose;             // Print switches and notifications
+
+void hostRelaysReset();
+
+// One pass of controlTask() (main.cpp): pump cooldown always, the rest on new temperatures
+void hostControlStep(bool temperaturesUpdated);
+
+// --mode/--on/--off/--frost/--quiet; returns false on an unknown option (i is advanced past values)
+bool parseControlOption(int argc, char** argv, int& i);
+
+// Commands
+int runReplay(int argc, char** argv);
+int runSimulate(int argc, char** argv);
+int runBench(int argc, char** argv);
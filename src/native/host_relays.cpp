@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "host.h"
+
+ControlState hostState;
+ControlState& controlState = hostState;
+HostRelayStats hostRelays;
+bool hostVerbose = true;
+
+void hostRelaysReset() {
+    memset(&hostRelays, 0, sizeof(hostRelays));
+}
+
+void setPump(bool on, bool manualOverride) {
+    (void)manualOverride;
+    if (on != hostState.pumpOn) {
+        hostRelays.pumpSwitches++;
+        hal::log("[Pump] %s\n", on ? "ON" : "OFF");
+    }
+    hostState.pumpOn = on;
+}
+
+void setHeater(bool on, bool saveToNVS) {
+    (void)saveToNVS;
+    // CRITICAL SAFETY RULE: If heating is turned ON, pump MUST be ON
+    if (on && !hostState.pumpOn) {
+        setPump(true, false);
+    }
+    bool stateChanged = on != hostState.heatingOn;
+    hostState.heatingOn = on;
+    // Pump cooldown starts when heating turns OFF
+    hostState.lastHeatingOffTime = on ? 0 : hal::millis();
+    if (stateChanged) {
+        hostRelays.heaterSwitches++;
+        hal::log("[Relay] Heater %s (switch #%lu)\n", on ? "ON" : "OFF", (unsigned long)hostRelays.heaterSwitches);
+        controlRecordSwitch();
+        bool warned = hostState.behaviorWarningActive;
+        checkUnusualBehavior();
+        if (hostState.behaviorWarningActive && !warned) {
+            hostRelays.behaviorWarnings++;
+        }
+    }
+}
+
+void controlNotify(const char* message) {
+    hostRelays.notifications++;
+    if (hostVerbose) {
+        printf("[Notify] %s\n", message);
+    }
+}
+
+void hostControlStep(bool temperaturesUpdated) {
+    handlePumpCooldown();
+    if (!temperaturesUpdated) {
+        return;
+    }
+    checkFailsafe();
+    if (hostState.frostProtectionEnabled) {
+        frostProtection();
+    } else if (hostState.controlMode == CONTROL_AUTO) {
+        automaticControl();
+    }
+}
@@ -0,0 +1,124 @@
+// Host program for env:native. Runs the portable control logic (control.cpp) against the fake HAL.
+//
+//   program replay [options] < temps.csv
+//   program simulate [options]
+//   program bench [options]
+//
+// Control options: --mode auto|manual|frost  --on <°C>  --off <°C>  --frost <°C>  --quiet
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "host.h"
+
+static void usage() {
+    fprintf(stderr,
+            "usage: program <command> [options]\n"
+            "  replay    read \"seconds,vorlauf,ruecklauf\" lines from stdin and run the control logic\n"
+            "  simulate  run the control logic against a thermal plant model (see simulate --help)\n"
+            "  bench     microbenchmarks of the hot paths, one JSON line per case (see bench --help)\n"
+            "options: --mode auto|manual|frost  --on <C>  --off <C>  --frost <C>  --quiet\n");
+}
+
+bool parseControlOption(int argc, char** argv, int& i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--quiet") == 0) {
+        hostVerbose = false;
+        hal::fake::setLogEcho(false);
+        return true;
+    }
+    if (!value) {
+        return false;
+    }
+    if (strcmp(arg, "--mode") == 0) {
+        hostState.controlMode = controlModeFromName(value);
+        hostState.frostProtectionEnabled = strcmp(value, "frost") == 0;
+    } else if (strcmp(arg, "--on") == 0) {
+        hostState.tempOn = atof(value);
+    } else if (strcmp(arg, "--off") == 0) {
+        hostState.tempOff = atof(value);
+    } else if (strcmp(arg, "--frost") == 0) {
+        hostState.frostProtectionTemp = atof(value);
+    } else {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+static float parseTemp(const char* field) {
+    while (*field == ' ') field++;
+    if (*field == '\0' || strncmp(field, "null", 4) == 0 || strncmp(field, "nan", 3) == 0) {
+        return NAN;
+    }
+    return atof(field);
+}
+
+int runReplay(int argc, char** argv) {
+    for (int i = 0; i < argc; i++) {
+        if (!parseControlOption(argc, argv, i)) {
+            usage();
+            return 2;
+        }
+    }
+    hostRelaysReset();
+
+    char line[160];
+    uint32_t startSec = 0;
+    bool started = false;
+    unsigned long samples = 0;
+    while (fgets(line, sizeof(line), stdin)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        char* vorlauf = strchr(line, ',');
+        char* ruecklauf = vorlauf ? strchr(vorlauf + 1, ',') : nullptr;
+        if (!ruecklauf) {
+            continue;
+        }
+        uint32_t sec = strtoul(line, nullptr, 10);
+        if (!started) {
+            startSec = sec;
+            started = true;
+        }
+        // Virtual clock starts at 1 s (0 means "no cooldown running" in ControlState)
+        uint32_t targetMs = (sec - startSec + 1) * 1000;
+        while (hal::millis() + 1000 <= targetMs) {
+            hal::delay(1000);
+            hostControlStep(false);
+        }
+        if (targetMs > hal::millis()) {
+            hal::fake::setMillis(targetMs);
+        }
+        hostState.tempVorlauf = parseTemp(vorlauf + 1);
+        hostState.tempRuecklauf = parseTemp(ruecklauf + 1);
+        hostControlStep(true);
+        samples++;
+    }
+
+    printf("samples=%lu heaterSwitches=%lu pumpSwitches=%lu notifications=%lu\n",
+           samples, (unsigned long)hostRelays.heaterSwitches,
+           (unsigned long)hostRelays.pumpSwitches, (unsigned long)hostRelays.notifications);
+    return 0;
+}
+
+#ifndef UNIT_TEST  // pio test links its own main() (test/test_native)
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    if (strcmp(argv[1], "replay") == 0) {
+        return runReplay(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "simulate") == 0) {
+        return runSimulate(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return runBench(argc - 2, argv + 2);
+    }
+    usage();
+    return 2;
+}
+#endif
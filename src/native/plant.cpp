@@ -0,0 +1,79 @@
+#include <math.h>
+#include "plant.h"
+
+static const float WATER_J_PER_KG_K = 4186.0f;
+static const float BOILER_LIMIT_TEMP = 85.0f;   // Boiler's own limit thermostat blocks the burner
+static const float RETURN_FLOW_TAU_S = 20.0f;   // Return sensor follows the water with the pump running
+static const double FRONT_PERIOD_S = 3 * 86400.0;
+static const float FRONT_TAU_S = 12 * 3600.0f;
+
+// Deterministic LCG in [-1, 1]
+static float plantRandom(uint32_t& rng) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) / 8388608.0f - 1.0f;
+}
+
+static float plantOutdoor(const PlantParams& p, const PlantState& s, double timeS) {
+    // Coldest around 05:00, warmest around 17:00
+    double dayPhase = fmod(timeS, 86400.0) / 86400.0;
+    return p.outdoorMean + s.frontOffset - p.outdoorDailySwing * (float)cos(2 * M_PI * (dayPhase - 5.0 / 24.0));
+}
+
+void plantInit(const PlantParams& p, PlantState& s) {
+    s.rng = p.seed ? p.seed : 1;
+    s.frontTarget = plantRandom(s.rng) * p.frontAmplitude;
+    s.frontOffset = s.frontTarget;
+    s.boilerTemp = 35.0f;
+    s.returnTemp = 30.0f;
+    s.roomTemp = 20.0f;
+    s.tankLiters = p.tankLiters;
+    s.outdoorTemp = plantOutdoor(p, s, 0);
+}
+
+void plantStep(const PlantParams& p, PlantState& s, bool burnerOn, bool pumpOn, double timeS, float dtS) {
+    // Weather: a new front every FRONT_PERIOD_S, approached with FRONT_TAU_S
+    if (fmod(timeS, FRONT_PERIOD_S) < dtS) {
+        s.frontTarget = plantRandom(s.rng) * p.frontAmplitude;
+    }
+    s.frontOffset += (s.frontTarget - s.frontOffset) * (dtS / FRONT_TAU_S);
+    s.outdoorTemp = plantOutdoor(p, s, timeS);
+
+    // Burner (needs fuel and is blocked by the boiler limit thermostat)
+    float burnerW = 0;
+    if (burnerOn && s.tankLiters > 0) {
+        s.tankLiters -= p.dieselPerHour / 3600.0f * dtS;
+        if (s.tankLiters < 0) s.tankLiters = 0;
+        if (s.boilerTemp < BOILER_LIMIT_TEMP) {
+            burnerW = p.dieselPerHour * p.kWhPerLiter * 1000.0f * p.efficiency;
+        }
+    }
+
+    // Radiators: with the pump running the mean water temperature is between flow and return
+    float emittedW;
+    float returnWater = s.boilerTemp;
+    if (pumpOn) {
+        float flowWPerK = p.pumpFlowKgPerS * WATER_J_PER_KG_K;
+        emittedW = p.radiatorWPerK * (s.boilerTemp - s.roomTemp) / (1.0f + p.radiatorWPerK / (2.0f * flowWPerK));
+        returnWater = s.boilerTemp - emittedW / flowWPerK;
+    } else {
+        emittedW = p.radiatorWPerK * p.radiatorIdleFactor * (s.boilerTemp - s.roomTemp);
+    }
+
+    float boilerJPerK = p.boilerLiters * WATER_J_PER_KG_K;
+    float boilerLossW = p.boilerLossWPerK * (s.boilerTemp - p.cellarTemp);
+    s.boilerTemp += (burnerW - emittedW - boilerLossW) / boilerJPerK * dtS;
+
+    float houseLossW = p.houseWPerK * (s.roomTemp - s.outdoorTemp);
+    s.roomTemp += (emittedW - houseLossW) / p.houseJPerK * dtS;
+
+    // Return sensor: follows the water while it flows, otherwise the pipe cools down
+    if (pumpOn) {
+        s.returnTemp += (returnWater - s.returnTemp) * (dtS / RETURN_FLOW_TAU_S);
+    } else {
+        s.returnTemp += (p.cellarTemp - s.returnTemp) * (dtS / p.returnPipeTauS);
+    }
+}
+
+float plantSensorReading(float celsius) {
+    return roundf(celsius * 16.0f) / 16.0f;
+}
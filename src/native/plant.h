@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========== THERMAL PLANT MODEL ==========
+// Lumped model of the heating system for accelerated-time runs of the control logic:
+//   burner -> boiler water -> (pump) radiator loop -> rooms -> outdoors
+// plus the return pipe at the sensor and the diesel tank. Integrated with a fixed 1 s step
+// (TEMP_READ_INTERVAL); sensors are quantized like a DS18B20 at 12 bit.
+
+struct PlantParams {
+    float dieselPerHour = 2.0f;        // L/h while the burner runs (state.dieselConsumptionPerHour)
+    float kWhPerLiter = 10.0f;         // Heating value of diesel
+    float efficiency = 0.9f;
+    float boilerLiters = 120.0f;       // Water in boiler and pipes
+    float boilerLossWPerK = 15.0f;     // Boiler jacket to cellar
+    float cellarTemp = 12.0f;
+    float pumpFlowKgPerS = 0.25f;
+    float radiatorWPerK = 350.0f;      // Emitter coefficient with the pump running
+    float radiatorIdleFactor = 0.1f;   // Natural convection with the pump off
+    float houseWPerK = 220.0f;         // Envelope loss coefficient
+    float houseJPerK = 25.0e6f;        // Thermal mass of the building
+    float returnPipeTauS = 900.0f;     // Return pipe at the sensor cools towards the cellar
+    float tankLiters = 1000.0f;
+    float outdoorMean = 0.0f;          // Daily mean, drifts with weather fronts
+    float outdoorDailySwing = 4.0f;    // Amplitude of the day/night cycle
+    float frontAmplitude = 6.0f;       // Multi-day weather fronts
+    uint32_t seed = 1;
+};
+
+struct PlantState {
+    float boilerTemp;                  // = flow (Vorlauf) temperature
+    float returnTemp;                  // Return (Rücklauf) at the sensor
+    float roomTemp;
+    float outdoorTemp;
+    float tankLiters;
+    float frontOffset;                 // Current weather front deviation
+    float frontTarget;
+    uint32_t rng;
+};
+
+void plantInit(const PlantParams& p, PlantState& s);
+
+// Advance by dtS seconds with the given relay states (absolute time for the weather)
+void plantStep(const PlantParams& p, PlantState& s, bool burnerOn, bool pumpOn, double timeS, float dtS);
+
+// DS18B20 reading at 12 bit (0.0625 °C steps)
+float plantSensorReading(float celsius);
@@ -0,0 +1,192 @@
+// "simulate" command: drives the real control logic (control.cpp) with the thermal plant model
+// (plant.cpp) on the virtual clock and reports switching, fuel use and comfort.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "host.h"
+#include "plant.h"
+
+#define SIM_MAX_DAYS 45   // The 32-bit millisecond clock wraps after 49.7 days
+
+struct SimReport {
+    uint32_t burnerSeconds;
+    uint32_t pumpSeconds;
+    uint32_t burnerWithoutPumpSeconds;   // Must stay 0 (safety rule)
+    uint32_t outOfFuelSeconds;
+    uint32_t comfortViolationSeconds;
+    uint32_t comfortViolations;          // Episodes below the comfort temperature
+    double comfortDegreeHours;           // Integral of the shortfall
+    double roomSum;
+    float roomMin;
+    float roomMax;
+    float boilerMax;
+    uint32_t shortestBurnerRun;          // Seconds
+    uint32_t cycles;
+};
+
+static void usageSimulate() {
+    fprintf(stderr,
+            "usage: program simulate [options]\n"
+            "  --days <n>        simulated days (default 31, max %d)\n"
+            "  --seed <n>        weather seed\n"
+            "  --outdoor <C>     mean outdoor temperature (default 0)\n"
+            "  --diesel <L/h>    burner consumption (default 2.0)\n"
+            "  --tank <L>        initial tank level (default 1000)\n"
+            "  --comfort <C>     minimum room temperature (default 19)\n"
+            "  --trace <file>    write one CSV line per simulated minute\n"
+            "  --verbose         print control log lines\n"
+            "  plus --mode/--on/--off/--frost as for replay (default mode auto)\n",
+            SIM_MAX_DAYS);
+}
+
+int runSimulate(int argc, char** argv) {
+    PlantParams params;
+    int days = 31;
+    float comfort = 19.0f;
+    const char* tracePath = nullptr;
+    bool verbose = false;
+    hostState.controlMode = CONTROL_AUTO;
+
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (value && strcmp(arg, "--days") == 0) {
+            days = atoi(value);
+            i++;
+        } else if (value && strcmp(arg, "--seed") == 0) {
+            params.seed = strtoul(value, nullptr, 10);
+            i++;
+        } else if (value && strcmp(arg, "--outdoor") == 0) {
+            params.outdoorMean = atof(value);
+            i++;
+        } else if (value && strcmp(arg, "--diesel") == 0) {
+            params.dieselPerHour = atof(value);
+            i++;
+        } else if (value && strcmp(arg, "--tank") == 0) {
+            params.tankLiters = atof(value);
+            i++;
+        } else if (value && strcmp(arg, "--comfort") == 0) {
+            comfort = atof(value);
+            i++;
+        } else if (value && strcmp(arg, "--trace") == 0) {
+            tracePath = value;
+            i++;
+        } else if (!parseControlOption(argc, argv, i)) {
+            usageSimulate();
+            return 2;
+        }
+    }
+    if (days < 1 || days > SIM_MAX_DAYS) {
+        usageSimulate();
+        return 2;
+    }
+    hostVerbose = verbose;
+    hal::fake::setLogEcho(verbose);
+
+    FILE* trace = nullptr;
+    if (tracePath) {
+        trace = fopen(tracePath, "w");
+        if (!trace) {
+            perror(tracePath);
+            return 1;
+        }
+        fprintf(trace, "minute,outdoor,room,vorlauf,ruecklauf,burner,pump,tank\n");
+    }
+
+    PlantState plant;
+    plantInit(params, plant);
+    hostRelaysReset();
+    hal::fake::setMillis(1000);  // 0 means "no cooldown running" in ControlState
+
+    SimReport report;
+    memset(&report, 0, sizeof(report));
+    report.roomMin = plant.roomTemp;
+    report.roomMax = plant.roomTemp;
+    report.boilerMax = plant.boilerTemp;
+    report.shortestBurnerRun = UINT32_MAX;
+    uint32_t burnerRun = 0;
+    bool inViolation = false;
+
+    struct timespec wallStart, wallEnd;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+    const uint32_t totalSeconds = (uint32_t)days * 86400;
+    for (uint32_t t = 0; t < totalSeconds; t++) {
+        // One sensor reading per TEMP_READ_INTERVAL (1 s), then the control pass
+        hostState.tempVorlauf = plantSensorReading(plant.boilerTemp);
+        hostState.tempRuecklauf = plantSensorReading(plant.returnTemp);
+        hostControlStep(true);
+
+        bool burner = hostState.heatingOn;
+        bool pump = hostState.pumpOn;
+        plantStep(params, plant, burner, pump, t, 1.0f);
+        hal::delay(1000);
+
+        if (burner) {
+            report.burnerSeconds++;
+            if (plant.tankLiters <= 0) report.outOfFuelSeconds++;
+            if (!pump) report.burnerWithoutPumpSeconds++;
+            if (burnerRun == 0) report.cycles++;
+            burnerRun++;
+        } else if (burnerRun > 0) {
+            if (burnerRun < report.shortestBurnerRun) report.shortestBurnerRun = burnerRun;
+            burnerRun = 0;
+        }
+        if (pump) report.pumpSeconds++;
+
+        report.roomSum += plant.roomTemp;
+        if (plant.roomTemp < report.roomMin) report.roomMin = plant.roomTemp;
+        if (plant.roomTemp > report.roomMax) report.roomMax = plant.roomTemp;
+        if (plant.boilerTemp > report.boilerMax) report.boilerMax = plant.boilerTemp;
+        if (plant.roomTemp < comfort) {
+            report.comfortViolationSeconds++;
+            report.comfortDegreeHours += (comfort - plant.roomTemp) / 3600.0;
+            if (!inViolation) report.comfortViolations++;
+            inViolation = true;
+        } else if (plant.roomTemp >= comfort + 0.2f) {
+            inViolation = false;  // Small hysteresis so sensor-level wiggles are one episode
+        }
+
+        if (trace && t % 60 == 0) {
+            fprintf(trace, "%lu,%.2f,%.2f,%.2f,%.2f,%d,%d,%.1f\n", (unsigned long)(t / 60),
+                    plant.outdoorTemp, plant.roomTemp, plant.boilerTemp, plant.returnTemp,
+                    burner ? 1 : 0, pump ? 1 : 0, plant.tankLiters);
+        }
+    }
+    if (trace) {
+        fclose(trace);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    double wallMs = (wallEnd.tv_sec - wallStart.tv_sec) * 1e3 + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e6;
+
+    printf("days=%d\n", days);
+    printf("seed=%lu\n", (unsigned long)params.seed);
+    printf("tempOn=%.1f\ntempOff=%.1f\n", hostState.tempOn, hostState.tempOff);
+    printf("heaterSwitches=%lu\n", (unsigned long)hostRelays.heaterSwitches);
+    printf("pumpSwitches=%lu\n", (unsigned long)hostRelays.pumpSwitches);
+    printf("burnerCycles=%lu\n", (unsigned long)report.cycles);
+    printf("cyclesPerDay=%.1f\n", (double)report.cycles / days);
+    printf("shortestBurnerRunS=%lu\n",
+           (unsigned long)(report.shortestBurnerRun == UINT32_MAX ? 0 : report.shortestBurnerRun));
+    printf("behaviorWarnings=%lu\n", (unsigned long)hostRelays.behaviorWarnings);
+    printf("notifications=%lu\n", (unsigned long)hostRelays.notifications);
+    printf("burnerHours=%.1f\n", report.burnerSeconds / 3600.0);
+    printf("pumpHours=%.1f\n", report.pumpSeconds / 3600.0);
+    printf("dieselLiters=%.1f\n", params.tankLiters - plant.tankLiters);
+    printf("tankLeftLiters=%.1f\n", plant.tankLiters);
+    printf("outOfFuelHours=%.1f\n", report.outOfFuelSeconds / 3600.0);
+    printf("burnerWithoutPumpS=%lu\n", (unsigned long)report.burnerWithoutPumpSeconds);
+    printf("roomMin=%.2f\nroomAvg=%.2f\nroomMax=%.2f\n", report.roomMin,
+           report.roomSum / totalSeconds, report.roomMax);
+    printf("boilerMax=%.1f\n", report.boilerMax);
+    printf("comfortViolations=%lu\n", (unsigned long)report.comfortViolations);
+    printf("comfortViolationHours=%.1f\n", report.comfortViolationSeconds / 3600.0);
+    printf("comfortDegreeHours=%.1f\n", report.comfortDegreeHours);
+    printf("wallMs=%.0f\n", wallMs);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <string.h>
+#include "switch_events.h"
+
+SwitchEvent switchEvents[MAX_SWITCH_EVENTS];
+int switchEventIndex = 0;
+
+SwitchEventCursor::SwitchEventCursor(int newest) : pos(switchEventIndex), remaining(MAX_SWITCH_EVENTS) {
+    int used = 0;
+    for (int i = 0; i < MAX_SWITCH_EVENTS; i++) {
+        if (switchEventUsed(switchEvents[i])) used++;
+    }
+    for (int skip = used - newest; skip > 0 && next() != nullptr; skip--) {
+    }
+}
+
+const SwitchEvent* SwitchEventCursor::next() {
+    while (remaining > 0) {
+        const SwitchEvent& evt = switchEvents[pos];
+        pos = (pos + 1) % MAX_SWITCH_EVENTS;
+        remaining--;
+        if (switchEventUsed(evt)) {
+            return &evt;
+        }
+    }
+    return nullptr;
+}
+
+unsigned long switchEventTime(const SwitchEvent& evt, time_t now, uint32_t nowMs) {
+    if (evt.timestamp > 0) {
+        return evt.timestamp;
+    }
+    if (now == 0 || evt.uptimeMs > nowMs) {
+        return 0;
+    }
+    return (unsigned long)now - (nowMs - evt.uptimeMs) / 1000;
+}
+
+int switchEventsAggregate(const uint32_t* bounds, int windowCount, SwitchWindowStats* out,
+                          time_t now, uint32_t nowMs) {
+    for (int w = 0; w < windowCount; w++) {
+        SwitchWindowStats& win = out[w];
+        memset(&win, 0, sizeof(win));
+        win.from = bounds[w];
+        win.to = bounds[w + 1];
+        win.vorlaufMax = NAN;
+        win.tankFirst = NAN;
+        win.tankLast = NAN;
+    }
+
+    int intervalWindow = 0;    // First window that can still overlap the next interval
+    int eventWindow = 0;       // Window of the next event
+
+    // Add [a, b) with the given state to all windows it overlaps (intervals arrive in time order)
+    auto addInterval = [&](uint32_t a, uint32_t b, int kind) {
+        while (intervalWindow < windowCount && bounds[intervalWindow + 1] <= a) {
+            intervalWindow++;
+        }
+        for (int w = intervalWindow; w < windowCount && bounds[w] < b; w++) {
+            uint32_t lo = a > bounds[w] ? a : bounds[w];
+            uint32_t hi = b < bounds[w + 1] ? b : bounds[w + 1];
+            if (hi <= lo) continue;
+            if (kind > 0) out[w].onSeconds += hi - lo;
+            else if (kind == 0) out[w].offSeconds += hi - lo;
+            else out[w].unknownSeconds += hi - lo;
+        }
+    };
+
+    int placed = 0;
+    uint32_t prevTime = bounds[0];
+    int prevKind = -1;         // Unknown until the first event
+    SwitchEventCursor cursor;
+    for (const SwitchEvent* evt = cursor.next(); evt != nullptr; evt = cursor.next()) {
+        uint32_t t = switchEventTime(*evt, now, nowMs);
+        if (t == 0) continue;
+        placed++;
+        uint32_t at = t > prevTime ? t : prevTime;  // Events before the range (or clock steps) only set the state
+        addInterval(prevTime, at, prevKind);
+        prevTime = at;
+        prevKind = evt->isOn ? 1 : 0;
+
+        while (eventWindow < windowCount && bounds[eventWindow + 1] <= t) {
+            eventWindow++;
+        }
+        if (eventWindow >= windowCount || t < bounds[eventWindow]) continue;
+        SwitchWindowStats& win = out[eventWindow];
+        win.switches++;
+        if (evt->isOn) {
+            win.onCycles++;
+        } else if (!isnan(evt->tempVorlauf)) {
+            win.vorlaufSamples++;
+            win.vorlaufSum += evt->tempVorlauf;
+            if (isnan(win.vorlaufMax) || evt->tempVorlauf > win.vorlaufMax) win.vorlaufMax = evt->tempVorlauf;
+        }
+        if (!isnan(evt->tankLiters)) {
+            if (isnan(win.tankFirst)) win.tankFirst = evt->tankLiters;
+            win.tankLast = evt->tankLiters;
+        }
+    }
+
+    // Current state up to now, the future stays unknown
+    uint32_t nowSec = (uint32_t)now;
+    if (now != 0 && nowSec > prevTime) {
+        addInterval(prevTime, nowSec, prevKind);
+        prevTime = nowSec;
+    }
+    addInterval(prevTime, bounds[windowCount], -1);
+    return placed;
+}
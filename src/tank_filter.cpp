@@ -0,0 +1,53 @@
+#include <math.h>
+#include "tank_filter.h"
+
+static inline void compareExchange(float& a, float& b) {
+    float lo = fminf(a, b);
+    float hi = fmaxf(a, b);
+    a = lo;
+    b = hi;
+}
+
+// Branch-free kernel: missed echoes are mapped to a sentinel that sorts last, an odd-even
+// transposition network (fixed N rounds) sorts the samples, and the trimmed mean drops a quarter of
+// the valid samples on each side.
+float filterTankBurst(const float* samples, int& confidence, TankBurstDiag& diag) {
+    const float SENTINEL = 1.0e6f;
+    float v[TANK_BURST_SAMPLES];
+    int valid = 0;
+    for (int i = 0; i < TANK_BURST_SAMPLES; i++) {
+        bool ok = !isnan(samples[i]);
+        v[i] = ok ? samples[i] : SENTINEL;
+        valid += ok;
+    }
+
+    for (int round = 0; round < TANK_BURST_SAMPLES; round++) {
+        for (int i = round & 1; i + 1 < TANK_BURST_SAMPLES; i += 2) {
+            compareExchange(v[i], v[i + 1]);
+        }
+    }
+
+    diag.valid = (uint8_t)valid;
+    if (valid < TANK_BURST_MIN_VALID) {
+        diag.medianCm = -1.0f;
+        diag.spreadCm = -1.0f;
+        confidence = 0;
+        return -1.0f;
+    }
+
+    // Valid samples occupy v[0..valid-1] in ascending order
+    int trim = valid / 4;
+    float sum = 0.0f;
+    for (int i = trim; i < valid - trim; i++) {
+        sum += v[i];
+    }
+    float trimmedMean = sum / (valid - 2 * trim);
+    float spread = v[valid - 1 - trim] - v[trim];
+    diag.medianCm = (valid & 1) ? v[valid / 2] : 0.5f * (v[valid / 2 - 1] + v[valid / 2]);
+    diag.spreadCm = spread;
+
+    float spreadFactor = 1.0f - spread / TANK_SPREAD_FULL_SCALE_CM;
+    spreadFactor = fmaxf(0.0f, fminf(1.0f, spreadFactor));
+    confidence = (int)lroundf(100.0f * ((float)valid / TANK_BURST_SAMPLES) * spreadFactor);
+    return trimmedMean;
+}
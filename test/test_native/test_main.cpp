@@ -0,0 +1,230 @@
+// Unit tests of the portable logic against the fake HAL: "pio test -e native".
+// Control functions run on hostState through the host relays (src/native/host_relays.cpp), which
+// keep the same heater/pump coupling as setHeater()/setPump() in main.cpp.
+#include <math.h>
+#include <unity.h>
+#include "control.h"
+#include "hal.h"
+#include "host.h"
+#include "switch_events.h"
+#include "tank_filter.h"
+
+#define T0 1760000000UL  // Fixed Unix time for the switch event tests
+
+void setUp() {
+    hostState = ControlState();
+    hostState.controlMode = CONTROL_AUTO;
+    hostState.tempOn = 30.0f;
+    hostState.tempOff = 40.0f;
+    hostVerbose = false;
+    hal::fake::setLogEcho(false);
+    hal::fake::setMillis(1000);  // lastHeatingOffTime = 0 means "no cooldown running"
+    hostRelaysReset();
+}
+
+void tearDown() {}
+
+static void controlStepAt(float vorlauf, float ruecklauf) {
+    hostState.tempVorlauf = vorlauf;
+    hostState.tempRuecklauf = ruecklauf;
+    hostControlStep(true);
+}
+
+// ========== HYSTERESIS ==========
+void test_hysteresis_turns_on_at_ton() {
+    controlStepAt(35.0f, 30.1f);
+    TEST_ASSERT_FALSE(hostState.heatingOn);
+    controlStepAt(35.0f, 30.0f);  // tempRuecklauf <= tempOn
+    TEST_ASSERT_TRUE(hostState.heatingOn);
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+}
+
+void test_hysteresis_turns_off_at_toff() {
+    controlStepAt(35.0f, 25.0f);
+    TEST_ASSERT_TRUE(hostState.heatingOn);
+    controlStepAt(50.0f, 39.9f);
+    TEST_ASSERT_TRUE(hostState.heatingOn);
+    controlStepAt(50.0f, 40.0f);  // tempRuecklauf >= tempOff
+    TEST_ASSERT_FALSE(hostState.heatingOn);
+}
+
+void test_hysteresis_holds_state_between_thresholds() {
+    controlStepAt(35.0f, 35.0f);
+    TEST_ASSERT_FALSE(hostState.heatingOn);
+    controlStepAt(35.0f, 29.0f);
+    controlStepAt(45.0f, 35.0f);
+    TEST_ASSERT_TRUE(hostState.heatingOn);
+    TEST_ASSERT_EQUAL_UINT32(1, hostRelays.heaterSwitches);
+}
+
+// ========== FAILSAFE ==========
+void test_failsafe_forces_pump_on_while_heating() {
+    hostState.heatingOn = true;
+    hostState.pumpOn = false;
+    hostState.tempVorlauf = 45.0f;
+    hostState.tempRuecklauf = 35.0f;
+    checkFailsafe();
+    TEST_ASSERT_TRUE(hostState.heatingOn);
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+}
+
+void test_failsafe_all_sensors_failed_turns_both_off() {
+    setHeater(true, false);
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+    controlStepAt(NAN, NAN);
+    TEST_ASSERT_FALSE(hostState.heatingOn);
+    TEST_ASSERT_FALSE(hostState.pumpOn);
+    TEST_ASSERT_TRUE(hostState.sensorErrorNotified);
+    TEST_ASSERT_EQUAL_UINT32(1, hostRelays.notifications);
+}
+
+void test_failsafe_keeps_manual_pump_override() {
+    hostState.controlMode = CONTROL_MANUAL;
+    hostState.pumpManualMode = true;
+    setPump(true, true);
+    controlStepAt(NAN, NAN);
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+}
+
+// ========== PUMP COOLDOWN ==========
+void test_pump_cooldown_expires() {
+    setHeater(true, false);
+    hal::fake::advance(60000);
+    setHeater(false, false);
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+
+    hal::fake::advance(PUMP_COOLDOWN_MS - 1);
+    handlePumpCooldown();
+    TEST_ASSERT_TRUE(hostState.pumpOn);
+
+    hal::fake::advance(1);
+    handlePumpCooldown();
+    TEST_ASSERT_FALSE(hostState.pumpOn);
+    TEST_ASSERT_EQUAL_UINT32(0, hostState.lastHeatingOffTime);
+}
+
+void test_pump_cooldown_restarts_when_heating_resumes() {
+    setHeater(true, false);
+    setHeater(false, false);
+    hal::fake::advance(PUMP_COOLDOWN_MS / 2);
+    setHeater(true, false);
+    hal::fake::advance(PUMP_COOLDOWN_MS);
+    handlePumpCooldown();
+    TEST_ASSERT_TRUE(hostState.pumpOn);  // Heating ON: cooldown does not apply
+}
+
+// ========== SWITCH EVENT AGGREGATION ==========
+static void clearSwitchEvents() {
+    for (int i = 0; i < MAX_SWITCH_EVENTS; i++) {
+        switchEvents[i] = SwitchEvent();
+    }
+    switchEventIndex = 0;
+}
+
+static void addSwitchEvent(unsigned long timestamp, bool on, float vorlauf, float tankLiters) {
+    SwitchEvent& evt = switchEvents[switchEventIndex];
+    evt.timestamp = timestamp;
+    evt.isOn = on;
+    evt.tempVorlauf = vorlauf;
+    evt.tempRuecklauf = vorlauf - 10.0f;
+    evt.uptimeMs = 1000;
+    evt.tankLiters = tankLiters;
+    switchEventIndex = (switchEventIndex + 1) % MAX_SWITCH_EVENTS;
+}
+
+void test_aggregate_clips_intervals_to_windows() {
+    clearSwitchEvents();
+    addSwitchEvent(T0, true, 32.0f, 800.0f);
+    addSwitchEvent(T0 + 3600, false, 55.0f, 798.0f);
+    addSwitchEvent(T0 + 7200, true, 33.0f, NAN);
+
+    const uint32_t bounds[] = { T0 - 1000, T0 + 1800, T0 + 5400, T0 + 12000 };
+    SwitchWindowStats win[3];
+    int placed = switchEventsAggregate(bounds, 3, win, (time_t)(T0 + 10800), 0);
+    TEST_ASSERT_EQUAL_INT(3, placed);
+
+    // Before the oldest event the state is unknown
+    TEST_ASSERT_EQUAL_UINT32(1000, win[0].unknownSeconds);
+    TEST_ASSERT_EQUAL_UINT32(1800, win[0].onSeconds);
+    TEST_ASSERT_EQUAL_UINT32(0, win[0].offSeconds);
+    TEST_ASSERT_EQUAL_UINT32(1, win[0].onCycles);
+
+    // The ON interval [T0, T0+3600) is split across the first two windows
+    TEST_ASSERT_EQUAL_UINT32(1800, win[1].onSeconds);
+    TEST_ASSERT_EQUAL_UINT32(1800, win[1].offSeconds);
+    TEST_ASSERT_EQUAL_UINT32(1, win[1].switches);
+    TEST_ASSERT_EQUAL_UINT32(1, win[1].vorlaufSamples);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 55.0f, win[1].vorlaufMax);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 798.0f, win[1].tankFirst);
+
+    // The current state lasts until now, the rest of the window is in the future
+    TEST_ASSERT_EQUAL_UINT32(1800, win[2].offSeconds);
+    TEST_ASSERT_EQUAL_UINT32(3600, win[2].onSeconds);
+    TEST_ASSERT_EQUAL_UINT32(1200, win[2].unknownSeconds);
+}
+
+void test_aggregate_event_before_range_sets_state() {
+    clearSwitchEvents();
+    addSwitchEvent(T0 - 86400, true, 32.0f, NAN);
+
+    const uint32_t bounds[] = { T0, T0 + 3600 };
+    SwitchWindowStats win[1];
+    switchEventsAggregate(bounds, 1, win, (time_t)(T0 + 3600), 0);
+    TEST_ASSERT_EQUAL_UINT32(3600, win[0].onSeconds);
+    TEST_ASSERT_EQUAL_UINT32(0, win[0].switches);
+    TEST_ASSERT_EQUAL_UINT32(0, win[0].unknownSeconds);
+}
+
+// ========== TANK BURST FILTER ==========
+void test_tank_filter_uniform_burst() {
+    const float samples[TANK_BURST_SAMPLES] = { 80.0f, 80.0f, 80.0f, 80.0f, 80.0f };
+    int confidence = -1;
+    TankBurstDiag diag;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 80.0f, filterTankBurst(samples, confidence, diag));
+    TEST_ASSERT_EQUAL_INT(100, confidence);
+    TEST_ASSERT_EQUAL_UINT8(5, diag.valid);
+}
+
+void test_tank_filter_trims_outlier() {
+    const float samples[TANK_BURST_SAMPLES] = { 103.0f, 250.0f, 101.0f, 102.0f, 100.0f };
+    int confidence = -1;
+    TankBurstDiag diag;
+    // Trim one sample on each side: mean of 101, 102, 103; inner spread 2 cm -> 60 %
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 102.0f, filterTankBurst(samples, confidence, diag));
+    TEST_ASSERT_EQUAL_INT(60, confidence);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 102.0f, diag.medianCm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f, diag.spreadCm);
+}
+
+void test_tank_filter_missed_echoes() {
+    const float partial[TANK_BURST_SAMPLES] = { NAN, 90.0f, NAN, 90.0f, 90.0f };
+    int confidence = -1;
+    TankBurstDiag diag;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 90.0f, filterTankBurst(partial, confidence, diag));
+    TEST_ASSERT_EQUAL_INT(60, confidence);  // 3 of 5 valid, no spread
+
+    const float missed[TANK_BURST_SAMPLES] = { NAN, 90.0f, NAN, NAN, 90.0f };
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -1.0f, filterTankBurst(missed, confidence, diag));
+    TEST_ASSERT_EQUAL_INT(0, confidence);
+    TEST_ASSERT_EQUAL_UINT8(2, diag.valid);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_hysteresis_turns_on_at_ton);
+    RUN_TEST(test_hysteresis_turns_off_at_toff);
+    RUN_TEST(test_hysteresis_holds_state_between_thresholds);
+    RUN_TEST(test_failsafe_forces_pump_on_while_heating);
+    RUN_TEST(test_failsafe_all_sensors_failed_turns_both_off);
+    RUN_TEST(test_failsafe_keeps_manual_pump_override);
+    RUN_TEST(test_pump_cooldown_expires);
+    RUN_TEST(test_pump_cooldown_restarts_when_heating_resumes);
+    RUN_TEST(test_aggregate_clips_intervals_to_windows);
+    RUN_TEST(test_aggregate_event_before_range_sets_state);
+    RUN_TEST(test_tank_filter_uniform_burst);
+    RUN_TEST(test_tank_filter_trims_outlier);
+    RUN_TEST(test_tank_filter_missed_echoes);
+    return UNITY_END();
+}